@@ -0,0 +1,102 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+/*
+* LOCAL includes
+*/
+#include "allocation_counter.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+/** per thread, so that counting costs no synchronization */
+__thread boost::uint64_t allocations = 0;
+
+inline void* allocate( std::size_t size )
+{
+  ++allocations;
+  void* p = std::malloc( size == 0 ? 1 : size );
+  if ( p == NULL )
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+} // anonymous
+
+namespace naoqi
+{
+namespace bench
+{
+
+boost::uint64_t threadAllocations()
+{
+  return allocations;
+}
+
+} // bench
+} // naoqi
+
+void* operator new( std::size_t size )
+{
+  return allocate( size );
+}
+
+void* operator new[]( std::size_t size )
+{
+  return allocate( size );
+}
+
+void* operator new( std::size_t size, const std::nothrow_t& ) throw()
+{
+  ++allocations;
+  return std::malloc( size == 0 ? 1 : size );
+}
+
+void* operator new[]( std::size_t size, const std::nothrow_t& ) throw()
+{
+  ++allocations;
+  return std::malloc( size == 0 ? 1 : size );
+}
+
+void operator delete( void* p ) throw()
+{
+  std::free( p );
+}
+
+void operator delete[]( void* p ) throw()
+{
+  std::free( p );
+}
+
+void operator delete( void* p, const std::nothrow_t& ) throw()
+{
+  std::free( p );
+}
+
+void operator delete[]( void* p, const std::nothrow_t& ) throw()
+{
+  std::free( p );
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+/*
+* BOOST includes
+*/
+#include <boost/cstdint.hpp>
+
+namespace naoqi
+{
+namespace bench
+{
+
+/**
+* @brief Number of allocations made so far by the calling thread
+* @note counted by the operator new of naoqi_driver_bench, which replaces the global one
+*/
+boost::uint64_t threadAllocations();
+
+} // bench
+} // naoqi
+
+#endif
@@ -0,0 +1,394 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+/*
+* LOCAL includes
+*/
+#include <naoqi_driver/message_actions.h>
+#include "../src/converters/diagnostics.hpp"
+#include "../src/converters/imu.hpp"
+#include "../src/converters/joint_state.hpp"
+#include "../src/converters/laser.hpp"
+#include "../src/converters/memory_list.hpp"
+#include "../src/converters/sonar.hpp"
+#include "../src/tools/audio_codec.hpp"
+#include "../src/tools/audio_resampler.hpp"
+#include "../src/tools/from_any_value.hpp"
+#include "allocation_counter.hpp"
+#include "fake_naoqi.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+/*
+* ROS includes
+*/
+#include <ros/ros.h>
+#include <tf2_ros/buffer.h>
+
+/*
+* BENCHMARK includes
+*/
+#include <benchmark/benchmark.h>
+
+/*
+* The conversion kernels of the converters, fed with data fetched once from a FakeNaoqi,
+* so that no libqi call is measured. Each case reports its allocations per tick in "allocs".
+*/
+
+namespace
+{
+
+/** One fake NAOqi per robot type, kept for the whole run */
+naoqi::bench::FakeNaoqi& fakeNaoqi( const std::string& robot )
+{
+  static std::map<std::string, boost::shared_ptr<naoqi::bench::FakeNaoqi> > fakes;
+  boost::shared_ptr<naoqi::bench::FakeNaoqi>& fake = fakes[robot];
+  if ( !fake )
+  {
+    ros::Time::init();
+    naoqi::bench::FakeNaoqiConfig config;
+    config.robot = robot;
+    fake = boost::make_shared<naoqi::bench::FakeNaoqi>( config );
+  }
+  return *fake;
+}
+
+const std::string robots[] = { "nao", "juliette", "romeo" };
+
+/** Callback standing for the publishers and recorders */
+template <class T>
+void sink( T& msg )
+{
+  benchmark::DoNotOptimize( &msg );
+}
+
+void sinkJointStates( sensor_msgs::JointState& js, std::vector<geometry_msgs::TransformStamped>& tf )
+{
+  benchmark::DoNotOptimize( &js );
+  benchmark::DoNotOptimize( &tf );
+}
+
+std::vector<naoqi::message_actions::MessageAction> publishOnly()
+{
+  return std::vector<naoqi::message_actions::MessageAction>( 1, naoqi::message_actions::PUBLISH );
+}
+
+/** Allocations made by the calling thread while the benchmark ran, divided by its iterations */
+class AllocationReport
+{
+public:
+  AllocationReport( benchmark::State& state ):
+    state_( state ),
+    start_( naoqi::bench::threadAllocations() )
+  {}
+
+  ~AllocationReport()
+  {
+    const double iterations = state_.iterations() > 0 ? state_.iterations() : 1;
+    state_.counters["allocs"] = ( naoqi::bench::threadAllocations() - start_ ) / iterations;
+  }
+
+private:
+  benchmark::State& state_;
+  boost::uint64_t start_;
+};
+
+/** Whether decodeAudio gives back exactly what encodeAudio was given */
+bool audioRoundTrips( const std::vector<int16_t>& samples, size_t channels )
+{
+  const size_t samples_per_channel = samples.size() / channels;
+  std::vector<boost::uint8_t> encoded;
+  naoqi::tools::AudioCodecScratch scratch;
+  naoqi::tools::encodeAudio( samples.empty() ? NULL : &samples[0], samples_per_channel, channels, encoded, scratch );
+  std::vector<int16_t> decoded;
+  return naoqi::tools::decodeAudio( encoded.empty() ? NULL : &encoded[0], encoded.size(), samples_per_channel, channels, decoded )
+      && decoded == samples;
+}
+
+/**
+* Check that the audio codec is lossless on the cases most likely to break it
+* @return a description of the first case failing, NULL if none does
+*/
+const char* audioCodecError()
+{
+  // noise over the whole range, where the residuals are the widest
+  boost::uint32_t seed = 12345;
+  std::vector<int16_t> noise( 4 * 4096 );
+  for ( size_t i=0; i<noise.size(); ++i )
+  {
+    seed = seed * 1103515245u + 12345u;
+    noise[i] = static_cast<int16_t>( seed >> 16 );
+  }
+  if ( !audioRoundTrips( std::vector<int16_t>( noise.begin(), noise.begin() + 4096 ), 1 ) )
+  {
+    return "the audio codec is not lossless on mono noise";
+  }
+  if ( !audioRoundTrips( noise, 4 ) )
+  {
+    return "the audio codec is not lossless on 4 channels of noise";
+  }
+
+  // full scale alternating, the largest steps a predictor can see
+  std::vector<int16_t> alternating( 4 * 4096 );
+  for ( size_t i=0; i<alternating.size(); ++i )
+  {
+    alternating[i] = ( i / 4 ) % 2 == 0 ? 32767 : -32768;
+  }
+  if ( !audioRoundTrips( alternating, 4 ) )
+  {
+    return "the audio codec is not lossless on full scale alternating samples";
+  }
+
+  // fewer samples than the order of the predictors
+  for ( size_t samples_per_channel=1; samples_per_channel<=4; ++samples_per_channel )
+  {
+    if ( !audioRoundTrips( std::vector<int16_t>( noise.begin(), noise.begin() + 4 * samples_per_channel ), 4 ) )
+    {
+      return "the audio codec is not lossless on a frame shorter than its predictors";
+    }
+  }
+  return NULL;
+}
+
+/** Runs the convert step of an AsyncConverter on the answer of one fetch */
+template <class C>
+void convertLoop( benchmark::State& state, C& converter )
+{
+  const std::vector<naoqi::message_actions::MessageAction> actions = publishOnly();
+  qi::AnyValue data = converter.fetch().value();
+  AllocationReport report( state );
+  while ( state.KeepRunning() )
+  {
+    converter.convert( actions, data );
+  }
+}
+
+} // anonymous
+
+/** Projection of the 15 laser segments of Pepper into a LaserScan */
+static void BM_LaserConvert( benchmark::State& state )
+{
+  naoqi::converter::LaserConverter converter( "laser", 10, fakeNaoqi( "juliette" ).session() );
+  converter.registerCallback( naoqi::message_actions::PUBLISH, &sink<sensor_msgs::LaserScan> );
+  convertLoop( state, converter );
+}
+BENCHMARK(BM_LaserConvert);
+
+/** Statuses of the joints and of the battery */
+static void BM_DiagnosticsConvert( benchmark::State& state )
+{
+  naoqi::converter::DiagnosticsConverter converter( "diag", 10, fakeNaoqi( "juliette" ).session() );
+  converter.registerCallback( naoqi::message_actions::PUBLISH, &sink<diagnostic_msgs::DiagnosticArray> );
+  convertLoop( state, converter );
+}
+BENCHMARK(BM_DiagnosticsConvert);
+
+/** Orientation quaternion, angular velocity and acceleration of the torso */
+static void BM_ImuConvert( benchmark::State& state )
+{
+  naoqi::converter::ImuConverter converter( "imu_torso", naoqi::converter::IMU::TORSO, 10, fakeNaoqi( "juliette" ).session() );
+  converter.registerCallback( naoqi::message_actions::PUBLISH, &sink<sensor_msgs::Imu> );
+  convertLoop( state, converter );
+}
+BENCHMARK(BM_ImuConvert);
+
+/**
+* Sonar ranges
+* @param range(0) robot, 0 for a NAO, 1 for a Pepper
+*/
+static void BM_SonarConvert( benchmark::State& state )
+{
+  naoqi::converter::SonarConverter converter( "sonar", 10, fakeNaoqi( robots[state.range(0)] ).session() );
+  converter.registerCallback( naoqi::message_actions::PUBLISH, &sink<std::vector<sensor_msgs::Range> > );
+  convertLoop( state, converter );
+}
+BENCHMARK(BM_SonarConvert)->Arg(0)->Arg(1);
+
+/**
+* Memory list mixing floats, ints and strings
+* @param range(0) number of keys
+*/
+static void BM_MemoryListConvert( benchmark::State& state )
+{
+  std::vector<std::string> keys;
+  for ( int i=0; i<state.range(0); ++i )
+  {
+    switch ( i % 3 )
+    {
+    case 0: keys.push_back( "Device/SubDeviceList/HeadYaw/Position/Sensor/Value" ); break;
+    case 1: keys.push_back( "DCM/Time" ); break;
+    default: keys.push_back( "RobotConfig/Body/Type" ); break;
+    }
+  }
+  naoqi::converter::MemoryListConverter converter( keys, "memory_list", 10, fakeNaoqi( "juliette" ).session() );
+  converter.registerCallback( naoqi::message_actions::PUBLISH, &sink<naoqi_bridge_msgs::MemoryList> );
+  convertLoop( state, converter );
+}
+BENCHMARK(BM_MemoryListConvert)->Arg(8)->Arg(64);
+
+/**
+* Forward kinematics of the joint states into transforms, plus the odometry
+* @param range(0) robot, 0 for a NAO, 1 for a Pepper, 2 for a Romeo
+*/
+static void BM_JointStateConvert( benchmark::State& state )
+{
+  naoqi::bench::FakeNaoqi& naoqi = fakeNaoqi( robots[state.range(0)] );
+  // the driver keeps the buffer, so that the transforms go in it
+  boost::shared_ptr<tf2_ros::Buffer> tf2_buffer = boost::make_shared<tf2_ros::Buffer>();
+  tf2_buffer->setUsingDedicatedThread( true );
+  naoqi::converter::JointStateConverter converter( "joint_states", 50, tf2_buffer, naoqi.session() );
+  converter.reset();
+  converter.registerCallback( naoqi::message_actions::PUBLISH, &sinkJointStates );
+
+  qi::AnyObject motion = naoqi.session()->service( "ALMotion" );
+  const std::vector<double> angles = motion.call<std::vector<double> >( "getAngles", "Body", true );
+  const std::vector<float> odometry = motion.call<std::vector<float> >( "getPosition", "Torso", 1, true );
+  const std::vector<naoqi::message_actions::MessageAction> actions = publishOnly();
+
+  AllocationReport report( state );
+  while ( state.KeepRunning() )
+  {
+    const ros::Time stamp = ros::Time::now();
+    converter.convert( actions, angles, stamp, odometry, stamp );
+  }
+  state.SetLabel( robots[state.range(0)] );
+}
+BENCHMARK(BM_JointStateConvert)->Arg(0)->Arg(1)->Arg(2);
+
+/** Decoding of the answer of ALMemory.getListData for the 90 laser keys */
+static void BM_FromAnyValueToFloatVector( benchmark::State& state )
+{
+  naoqi::converter::LaserConverter converter( "laser", 10, fakeNaoqi( "juliette" ).session() );
+  qi::AnyValue data = converter.fetch().value();
+  AllocationReport report( state );
+  while ( state.KeepRunning() )
+  {
+    std::vector<float> values;
+    naoqi::tools::fromAnyValueToFloatVector( data, values );
+    benchmark::DoNotOptimize( values.data() );
+  }
+}
+BENCHMARK(BM_FromAnyValueToFloatVector);
+
+/** Decoding of string values, as done for the robot info */
+static void BM_FromAnyValueToStringVector( benchmark::State& state )
+{
+  qi::AnyObject memory = fakeNaoqi( "juliette" ).session()->service( "ALMemory" );
+  const std::vector<std::string> keys( 16, "RobotConfig/Body/BaseVersion" );
+  qi::AnyValue data = memory.call<qi::AnyValue>( "getListData", keys );
+  AllocationReport report( state );
+  while ( state.KeepRunning() )
+  {
+    std::vector<std::string> values;
+    naoqi::tools::fromAnyValueToStringVector( data, values );
+    benchmark::DoNotOptimize( values.data() );
+  }
+}
+BENCHMARK(BM_FromAnyValueToStringVector);
+
+/**
+* Decoding of the answer of ALVideoDevice.getImageRemote, without copying the pixels
+* @param range(0) resolution, 1 for QVGA, 2 for VGA
+*/
+static void BM_FromAnyValueToNaoqiImage( benchmark::State& state )
+{
+  qi::AnyObject video = fakeNaoqi( "juliette" ).session()->service( "ALVideoDevice" );
+  const std::string handle = video.call<std::string>( "subscribeCamera", "bench", 0, static_cast<int>( state.range(0) ), 11, 30 );
+  qi::AnyValue image = video.call<qi::AnyValue>( "getImageRemote", handle );
+  video.call<bool>( "unsubscribe", handle );
+  AllocationReport report( state );
+  while ( state.KeepRunning() )
+  {
+    naoqi::tools::NaoqiImage decoded = naoqi::tools::fromAnyValueToNaoqiImage( image );
+    benchmark::DoNotOptimize( decoded.buffer );
+  }
+}
+BENCHMARK(BM_FromAnyValueToNaoqiImage)->Arg(1)->Arg(2);
+
+/**
+* Low-pass filtering and decimation of one channel of a frame of ALAudioDevice (4096 samples at 48 kHz)
+* @param range(0) output sample rate
+*/
+static void BM_AudioResample( benchmark::State& state )
+{
+  naoqi::tools::AudioResampler resampler( 48000, static_cast<int>( state.range(0) ) );
+  std::vector<int16_t> input( 4096 );
+  for ( size_t i=0; i<input.size(); ++i )
+  {
+    input[i] = static_cast<int16_t>( ( i * 7919 ) % 65536 - 32768 );
+  }
+  std::vector<int16_t> output;
+  AllocationReport report( state );
+  while ( state.KeepRunning() )
+  {
+    output.clear();
+    resampler.process( &input[0], input.size(), output );
+    benchmark::DoNotOptimize( &output[0] );
+  }
+  state.SetItemsProcessed( state.iterations() * input.size() );
+}
+BENCHMARK(BM_AudioResample)->Arg(16000)->Arg(8000);
+
+/**
+* Lossless compression of a frame of ALAudioDevice (4 channels of 4096 samples at 48 kHz), a sum of tones and noise
+*/
+static void BM_AudioCompress( benchmark::State& state )
+{
+  naoqi_bridge_msgs::AudioBuffer audio;
+  audio.frequency = 48000;
+  audio.channelMap.resize( 4 );
+  audio.data.resize( 4 * 4096 );
+  for ( size_t i=0; i<audio.data.size(); ++i )
+  {
+    const size_t t = i / 4;
+    audio.data[i] = static_cast<int16_t>( 3000 * std::sin( 0.05 * t ) + 1000 * std::sin( 0.31 * t ) + ( i * 7919 ) % 256 );
+  }
+  // a codec losing samples is not worth measuring, the loop is not entered then
+  const char* error = audioCodecError();
+  if ( error != NULL )
+  {
+    state.SkipWithError( error );
+  }
+  else if ( !audioRoundTrips( audio.data, 4 ) )
+  {
+    state.SkipWithError( "the audio codec is not lossless on the frame of the benchmark" );
+  }
+  naoqi::tools::CompressedAudioBuffer compressed;
+  naoqi::tools::AudioCodecScratch scratch;
+  AllocationReport report( state );
+  while ( state.KeepRunning() )
+  {
+    naoqi::tools::compressAudio( audio, compressed, scratch );
+    benchmark::DoNotOptimize( &compressed.data[0] );
+  }
+  state.SetBytesProcessed( state.iterations() * audio.data.size() * sizeof(int16_t) );
+  state.counters["ratio"] = static_cast<double>( compressed.data.size() ) / ( audio.data.size() * sizeof(int16_t) );
+}
+BENCHMARK(BM_AudioCompress);
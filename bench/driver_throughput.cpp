@@ -0,0 +1,111 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+/*
+* LOCAL includes
+*/
+#include <naoqi_driver/naoqi_driver.hpp>
+#include "../src/tools/converter_statistics.hpp"
+#include "allocation_counter.hpp"
+#include "fake_naoqi.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/filesystem.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+/*
+* ROS includes
+*/
+#include <ros/time.h>
+
+/*
+* BENCHMARK includes
+*/
+#include <benchmark/benchmark.h>
+
+/**
+* The driver recording and buffering every converter enabled by the default boot config, fed by a FakeNaoqi.
+* Reports, per converter, its ticks per second, the latency percentiles of a tick in ms,
+* and the CPU time and the allocations a tick takes from the driver thread.
+* @param range(0) seconds of record
+*/
+static void BM_DriverRecord( benchmark::State& state )
+{
+  naoqi::bench::FakeNaoqi naoqi;
+  naoqi::tools::ThreadUsage::setAllocationCounter( &naoqi::bench::threadAllocations );
+
+  // the bags are written in a scratch folder
+  const boost::filesystem::path cwd = boost::filesystem::current_path();
+  const boost::filesystem::path folder = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path( "naoqi_driver_bench_%%%%%%" );
+  boost::filesystem::create_directories( folder );
+  boost::filesystem::current_path( folder );
+
+  // the driver prints on std::cout, which must only carry the report, e.g. with --benchmark_format=json
+  std::streambuf* const report = std::cout.rdbuf( std::cerr.rdbuf() );
+
+  naoqi::tools::ConverterStatistics::Map stats;
+  std::vector<std::string> summary;
+  while ( state.KeepRunning() )
+  {
+    boost::shared_ptr<naoqi::Driver> driver = boost::make_shared<naoqi::Driver>( naoqi.session(), "naoqi_driver" );
+    driver->init();
+    driver->resetConverterStatistics();
+    driver->startLogging();
+    driver->startRecording();
+    ros::WallDuration( state.range(0) ).sleep();
+    driver->stopRecording();
+    stats = naoqi::tools::ConverterStatistics::instance().snapshot();
+    summary = naoqi::tools::ConverterStatistics::instance().summary();
+    driver->stopService();
+  }
+
+  boost::filesystem::current_path( cwd );
+  boost::filesystem::remove_all( folder );
+  std::cout.rdbuf( report );
+
+  for ( naoqi::tools::ConverterStatistics::Map::const_iterator it = stats.begin(); it != stats.end(); ++it )
+  {
+    const naoqi::tools::ConverterTickStatistics& s = it->second;
+    const double ticks = s.latency.calls;
+    state.counters[it->first + ".rate"] = s.rate();
+    // a converter which never ticked, e.g. suspended, has no per tick figures
+    if ( ticks > 0 )
+    {
+      state.counters[it->first + ".p50_ms"] = s.latency.percentile(0.5) / 1000.;
+      state.counters[it->first + ".p99_ms"] = s.latency.percentile(0.99) / 1000.;
+      state.counters[it->first + ".cpu_ms"] = s.cpu_us / ticks / 1000.;
+      state.counters[it->first + ".allocs"] = s.allocations / ticks;
+    }
+  }
+  // human readable, next to the report
+  for ( std::vector<std::string>::const_iterator it = summary.begin(); it != summary.end(); ++it )
+  {
+    std::cerr << *it << std::endl;
+  }
+}
+BENCHMARK(BM_DriverRecord)->Arg(10)->Iterations(1)->UseRealTime()->Unit(benchmark::kSecond);
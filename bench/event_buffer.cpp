@@ -0,0 +1,153 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/*
+* LOCAL includes
+*/
+#include <naoqi_driver/recorder/globalrecorder.hpp>
+#include "../src/recorder/basic_event.hpp"
+#include "../src/recorder/dump.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+/*
+* ROS includes
+*/
+#include <naoqi_bridge_msgs/AudioBuffer.h>
+#include <ros/ros.h>
+
+/*
+* BENCHMARK includes
+*/
+#include <benchmark/benchmark.h>
+
+namespace
+{
+
+/** 4 channels at 48 kHz, as sent by ALAudioDevice */
+const int frequency = 48000;
+const int channels = 4;
+
+class AudioEvents
+{
+public:
+  /**
+  * @param frames number of frames of each chunk
+  */
+  AudioEvents( size_t frames ):
+    gr_( boost::make_shared<naoqi::recorder::GlobalRecorder>( "/naoqi_driver/" ) ),
+    recorder_( "audio" ),
+    period_( static_cast<double>(frames) / frequency ),
+    stamp_( 1000, 0 )
+  {
+    ros::Time::init();
+    gr_->setBufferBudget( 256*1024*1024, 64*1024*1024, std::map<std::string, size_t>() );
+    recorder_.reset( gr_, 0 );
+    msg_.frequency = frequency;
+    msg_.channelMap.resize( channels, 0 );
+    msg_.data.resize( channels * frames, 42 );
+  }
+
+  void bufferize()
+  {
+    stamp_ = stamp_ + ros::Duration( period_ );
+    msg_.header.stamp = stamp_;
+    recorder_.bufferize( msg_ );
+  }
+
+  naoqi::recorder::BasicEventRecorder<naoqi_bridge_msgs::AudioBuffer>& recorder()
+  {
+    return recorder_;
+  }
+
+  const ros::Time& stamp() const
+  {
+    return stamp_;
+  }
+
+  double period() const
+  {
+    return period_;
+  }
+
+private:
+  boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr_;
+  naoqi::recorder::BasicEventRecorder<naoqi_bridge_msgs::AudioBuffer> recorder_;
+  naoqi_bridge_msgs::AudioBuffer msg_;
+  double period_;
+  ros::Time stamp_;
+};
+
+} // anonymous
+
+/**
+* Steady state of the audio buffer: each chunk pushed expires the ones older than the buffer duration
+* @param range(0) frames per chunk
+*/
+static void BM_EventBufferize( benchmark::State& state )
+{
+  AudioEvents events( state.range(0) );
+  // reach the steady state first
+  const size_t warmup = static_cast<size_t>( 2 * naoqi::helpers::recorder::bufferDefaultDuration / events.period() );
+  for ( size_t i=0; i<warmup; ++i )
+  {
+    events.bufferize();
+  }
+  while ( state.KeepRunning() )
+  {
+    events.bufferize();
+  }
+  state.SetItemsProcessed( state.iterations() );
+  state.SetBytesProcessed( state.iterations() * state.range(0) * channels * sizeof(int16_t) );
+}
+BENCHMARK(BM_EventBufferize)->Arg(64)->Arg(256)->Arg(1024)->Arg(4096);
+
+/**
+* Snapshot of a full audio buffer and extraction of its events, as done by minidump
+* @param range(0) frames per chunk
+*/
+static void BM_EventSnapshot( benchmark::State& state )
+{
+  AudioEvents events( state.range(0) );
+  const size_t count = static_cast<size_t>( naoqi::helpers::recorder::bufferDefaultDuration / events.period() );
+  while ( state.KeepRunning() )
+  {
+    state.PauseTiming();
+    for ( size_t i=0; i<count; ++i )
+    {
+      events.bufferize();
+    }
+    state.ResumeTiming();
+
+    std::vector<naoqi::recorder::DumpRecord> records;
+    events.recorder().snapshot( events.stamp() )( records );
+    benchmark::DoNotOptimize( records.data() );
+  }
+  state.SetItemsProcessed( state.iterations() * count );
+}
+BENCHMARK(BM_EventSnapshot)->Arg(64)->Arg(1024)->Unit(benchmark::kMillisecond);
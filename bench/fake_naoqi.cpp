@@ -0,0 +1,568 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+/*
+* LOCAL includes
+*/
+#include "fake_naoqi.hpp"
+#include "../src/tools/alvisiondefinitions.h"
+#include "../src/tools/robot_description.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/functional/hash.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+/*
+* ALDEBARAN includes
+*/
+#include <qi/anyobject.hpp>
+#include <qi/buffer.hpp>
+#include <qicore/loglistener.hpp>
+#include <qicore/logmanager.hpp>
+
+/*
+* ROS includes
+*/
+#include <ros/time.h>
+#include <urdf/model.h>
+
+namespace naoqi
+{
+namespace bench
+{
+
+namespace
+{
+
+const double two_pi = 6.283185307179586;
+
+/** Joints moved by ALMotion: the ones of the URDF of the robot which are neither fixed nor mimicking another one */
+std::vector<std::string> bodyNames( const std::string& type )
+{
+  const robot::Robot robot = type == "nao" ? robot::NAO : type == "romeo" ? robot::ROMEO : robot::PEPPER;
+  urdf::Model model;
+  model.initString( tools::getRobotDescription( robot ) );
+  std::vector<std::string> names;
+  for ( std::map<std::string, boost::shared_ptr<urdf::Joint> >::const_iterator it = model.joints_.begin(); it != model.joints_.end(); ++it )
+  {
+    if ( it->second->type != urdf::Joint::FIXED && !it->second->mimic )
+    {
+      names.push_back( it->first );
+    }
+  }
+  return names;
+}
+
+/** Synthetic signal in [-1,1], sampled at rate, each key having its own phase */
+float wave( const std::string& key, double time, float rate )
+{
+  const double sample = std::floor( time * rate ) / rate;
+  const double phase = static_cast<double>( boost::hash<std::string>()(key) % 1000 ) / 1000.;
+  return static_cast<float>( std::sin( two_pi * ( 0.5 * sample + phase ) ) );
+}
+
+inline bool startsWith( const std::string& s, const std::string& prefix )
+{
+  return s.compare( 0, prefix.size(), prefix ) == 0;
+}
+
+} // anonymous
+
+FakeNaoqiConfig::FakeNaoqiConfig():
+  robot( "juliette" ),
+  memory_rate( 100.f ),
+  audio_frames( 4096 )
+{}
+
+/**
+* @brief Object returned by ALMemory.subscriber, never triggered
+*/
+class FakeMemorySubscriber
+{
+public:
+  qi::Signal<qi::AnyValue> signal;
+};
+QI_REGISTER_OBJECT(FakeMemorySubscriber, signal)
+
+/**
+* @brief ALMemory: the configuration keys are strings, DCM/Time counts milliseconds, every other key is a float
+*/
+class FakeMemory
+{
+public:
+  FakeMemory( const FakeNaoqiConfig& config ):
+    config_( config )
+  {}
+
+  qi::AnyValue getData( const std::string& key )
+  {
+    return value( key, ros::WallTime::now().toSec() );
+  }
+
+  std::vector<qi::AnyValue> getListData( const std::vector<std::string>& keys )
+  {
+    const double time = ros::WallTime::now().toSec();
+    std::vector<qi::AnyValue> values;
+    values.reserve( keys.size() );
+    for ( std::vector<std::string>::const_iterator it = keys.begin(); it != keys.end(); ++it )
+    {
+      values.push_back( value( *it, time ) );
+    }
+    return values;
+  }
+
+  qi::AnyObject subscriber( const std::string& key )
+  {
+    return qi::AnyObject( boost::make_shared<FakeMemorySubscriber>() );
+  }
+
+  void subscribeToEvent( const std::string& event, const std::string& module, const std::string& method )
+  {
+  }
+
+  void unsubscribeToEvent( const std::string& event, const std::string& module )
+  {
+  }
+
+private:
+  qi::AnyValue value( const std::string& key, double time ) const
+  {
+    if ( key == "RobotConfig/Body/Type" )
+    {
+      return qi::AnyValue::from( config_.robot );
+    }
+    if ( startsWith( key, "RobotConfig/" ) || startsWith( key, "Device/DeviceList/" ) )
+    {
+      return qi::AnyValue::from( std::string("fake") );
+    }
+    if ( key == "DCM/Time" )
+    {
+      return qi::AnyValue::from( static_cast<int>( std::fmod( time, 1e6 ) * 1000 ) );
+    }
+    return qi::AnyValue::from( wave( key, time, config_.memory_rate ) );
+  }
+
+  FakeNaoqiConfig config_;
+};
+QI_REGISTER_OBJECT(FakeMemory, getData, getListData, subscriber, subscribeToEvent, unsubscribeToEvent)
+
+/**
+* @brief ALMotion of a robot standing still, its joints slowly waving
+*/
+class FakeMotion
+{
+public:
+  FakeMotion( const FakeNaoqiConfig& config ):
+    config_( config ),
+    joints_( bodyNames( config.robot ) )
+  {}
+
+  std::vector<std::string> getBodyNames( const std::string& name )
+  {
+    if ( name == "JointActuators" )
+    {
+      std::vector<std::string> actuators;
+      for ( std::vector<std::string>::const_iterator it = joints_.begin(); it != joints_.end(); ++it )
+      {
+        if ( !startsWith( *it, "Wheel" ) )
+        {
+          actuators.push_back( *it );
+        }
+      }
+      return actuators;
+    }
+    return joints_;
+  }
+
+  std::vector<float> getAngles( const qi::AnyValue& names, bool useSensors )
+  {
+    const double time = ros::WallTime::now().toSec();
+    std::vector<float> angles;
+    angles.reserve( joints_.size() );
+    for ( std::vector<std::string>::const_iterator it = joints_.begin(); it != joints_.end(); ++it )
+    {
+      angles.push_back( 0.1f * wave( *it, time, config_.memory_rate ) );
+    }
+    return angles;
+  }
+
+  std::vector<float> getPosition( const std::string& name, int space, bool useSensors )
+  {
+    return std::vector<float>( 6, 0.f );
+  }
+
+  std::vector<std::vector<qi::AnyValue> > getRobotConfig()
+  {
+    std::vector<std::vector<qi::AnyValue> > config( 2 );
+    config[0].push_back( qi::AnyValue::from( std::string("Model Type") ) );
+    config[1].push_back( qi::AnyValue::from( std::string("juliette_y20") ) );
+    config[0].push_back( qi::AnyValue::from( std::string("Head Version") ) );
+    config[1].push_back( qi::AnyValue::from( std::string("VERSION_20") ) );
+    config[0].push_back( qi::AnyValue::from( std::string("Body Version") ) );
+    config[1].push_back( qi::AnyValue::from( std::string("VERSION_20") ) );
+    config[0].push_back( qi::AnyValue::from( std::string("Arm Version") ) );
+    config[1].push_back( qi::AnyValue::from( std::string("VERSION_20") ) );
+    config[0].push_back( qi::AnyValue::from( std::string("Laser") ) );
+    config[1].push_back( qi::AnyValue::from( true ) );
+    config[0].push_back( qi::AnyValue::from( std::string("Extended Arms") ) );
+    config[1].push_back( qi::AnyValue::from( false ) );
+    config[0].push_back( qi::AnyValue::from( std::string("Number of Legs") ) );
+    config[1].push_back( qi::AnyValue::from( 0 ) );
+    return config;
+  }
+
+  void move( float x, float y, float theta )
+  {
+  }
+
+  void moveTo( float x, float y, float theta )
+  {
+  }
+
+  void setAngles( const qi::AnyValue& names, const qi::AnyValue& angles, float speed )
+  {
+  }
+
+  void changeAngles( const qi::AnyValue& names, const qi::AnyValue& angles, float speed )
+  {
+  }
+
+private:
+  FakeNaoqiConfig config_;
+  std::vector<std::string> joints_;
+};
+QI_REGISTER_OBJECT(FakeMotion, getBodyNames, getAngles, getPosition, getRobotConfig, move, moveTo, setAngles, changeAngles)
+
+/**
+* @brief ALVideoDevice: each handle gets a new frame at the frame rate it was subscribed with
+*/
+class FakeVideoDevice
+{
+  struct Camera
+  {
+    boost::mutex mutex;
+    int source;
+    int colorspace;
+    int width;
+    int height;
+    int layers;
+    int fps;
+    double last_frame;
+    std::vector<unsigned char> pixels;
+  };
+
+public:
+  std::string subscribeCamera( const std::string& name, int source, int resolution, int colorspace, int fps )
+  {
+    boost::shared_ptr<Camera> camera = boost::make_shared<Camera>();
+    camera->source = source;
+    camera->colorspace = colorspace;
+    camera->width = 160 << resolution;
+    camera->height = 120 << resolution;
+    camera->layers = colorspace == AL::kRGBColorSpace ? 3 : ( colorspace == AL::kDepthColorSpace || colorspace == AL::kInfraredColorSpace ) ? 2 : 1;
+    camera->fps = fps > 0 ? fps : 1;
+    camera->last_frame = -1;
+    camera->pixels.resize( camera->width * camera->height * camera->layers );
+
+    boost::mutex::scoped_lock lock( mutex_ );
+    std::ostringstream handle;
+    handle << name << "_" << cameras_.size();
+    cameras_[handle.str()] = camera;
+    return handle.str();
+  }
+
+  bool unsubscribe( const std::string& handle )
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    return cameras_.erase( handle ) > 0;
+  }
+
+  qi::AnyValue getImageRemote( const std::string& handle )
+  {
+    boost::shared_ptr<Camera> camera;
+    {
+      boost::mutex::scoped_lock lock( mutex_ );
+      std::map<std::string, boost::shared_ptr<Camera> >::const_iterator it = cameras_.find( handle );
+      if ( it == cameras_.end() )
+      {
+        return qi::AnyValue();
+      }
+      camera = it->second;
+    }
+
+    boost::mutex::scoped_lock lock( camera->mutex );
+    // wait for the next frame when the current one was already taken
+    double frame = std::floor( ros::WallTime::now().toSec() * camera->fps );
+    if ( frame <= camera->last_frame )
+    {
+      frame = camera->last_frame + 1;
+      ros::WallDuration( frame / camera->fps - ros::WallTime::now().toSec() ).sleep();
+    }
+    camera->last_frame = frame;
+    std::fill( camera->pixels.begin(), camera->pixels.end(), static_cast<unsigned char>( frame ) );
+
+    qi::Buffer buffer;
+    buffer.write( &camera->pixels[0], camera->pixels.size() );
+    const ros::WallTime stamp = ros::WallTime::now();
+    std::vector<qi::AnyValue> image;
+    image.push_back( qi::AnyValue::from( camera->width ) );
+    image.push_back( qi::AnyValue::from( camera->height ) );
+    image.push_back( qi::AnyValue::from( camera->layers ) );
+    image.push_back( qi::AnyValue::from( camera->colorspace ) );
+    image.push_back( qi::AnyValue::from( static_cast<int>( stamp.sec ) ) );
+    image.push_back( qi::AnyValue::from( static_cast<int>( stamp.nsec / 1000 ) ) );
+    image.push_back( qi::AnyValue::from( buffer ) );
+    image.push_back( qi::AnyValue::from( camera->source ) );
+    image.push_back( qi::AnyValue::from( 0.f ) );
+    image.push_back( qi::AnyValue::from( 0.f ) );
+    image.push_back( qi::AnyValue::from( 0.f ) );
+    image.push_back( qi::AnyValue::from( 0.f ) );
+    return qi::AnyValue::from( image );
+  }
+
+private:
+  boost::mutex mutex_;
+  std::map<std::string, boost::shared_ptr<Camera> > cameras_;
+};
+QI_REGISTER_OBJECT(FakeVideoDevice, subscribeCamera, unsubscribe, getImageRemote)
+
+/**
+* @brief ALAudioDevice: once subscribed, sends 4 channels at 48 kHz to the processRemote method of its subscriber
+* @note the chunks go through the session of the driver, the subscriber being registered there
+*/
+class FakeAudioDevice
+{
+public:
+  FakeAudioDevice( const FakeNaoqiConfig& config, const qi::SessionPtr& session ):
+    config_( config ),
+    session_( session )
+  {}
+
+  ~FakeAudioDevice()
+  {
+    stop();
+  }
+
+  void setClientPreferences( const std::string& name, int frequency, int channels, int deinterleaved )
+  {
+  }
+
+  void subscribe( const std::string& name )
+  {
+    stop();
+    thread_ = boost::thread( &FakeAudioDevice::send, this, name );
+  }
+
+  void unsubscribe( const std::string& name )
+  {
+    stop();
+  }
+
+  void stop()
+  {
+    thread_.interrupt();
+    if ( thread_.joinable() )
+    {
+      thread_.join();
+    }
+  }
+
+private:
+  void send( const std::string& name )
+  {
+    static const int channels = 4;
+    static const int frequency = 48000;
+    qi::AnyObject subscriber = session_->service( name );
+    std::vector<int16_t> samples( channels * config_.audio_frames );
+    const ros::WallDuration period( static_cast<double>( config_.audio_frames ) / frequency );
+    ros::WallTime next = ros::WallTime::now();
+    boost::uint64_t frame = 0;
+    try
+    {
+      while ( true )
+      {
+        next += period;
+        ros::WallDuration( next - ros::WallTime::now() ).sleep();
+        boost::this_thread::interruption_point();
+
+        // 440 Hz on every channel
+        for ( int i=0; i<config_.audio_frames; ++i, ++frame )
+        {
+          const int16_t sample = static_cast<int16_t>( 8000 * std::sin( two_pi * 440 * frame / frequency ) );
+          for ( int c=0; c<channels; ++c )
+          {
+            samples[i*channels + c] = sample;
+          }
+        }
+        qi::Buffer buffer;
+        buffer.write( &samples[0], samples.size() * sizeof(int16_t) );
+        const ros::WallTime stamp = ros::WallTime::now();
+        std::vector<int> timestamp( 2 );
+        timestamp[0] = stamp.sec;
+        timestamp[1] = stamp.nsec / 1000;
+        subscriber.call<void>( "processRemote", channels, config_.audio_frames, qi::AnyValue::from( timestamp ), qi::AnyValue::from( buffer ) );
+      }
+    }
+    catch ( const boost::thread_interrupted& )
+    {
+    }
+  }
+
+  FakeNaoqiConfig config_;
+  qi::SessionPtr session_;
+  boost::thread thread_;
+};
+QI_REGISTER_OBJECT(FakeAudioDevice, setClientPreferences, subscribe, unsubscribe)
+
+/**
+* @brief Services only switched on and off by the converters
+*/
+class FakeSonar
+{
+public:
+  void subscribe( const std::string& name )
+  {
+  }
+
+  void unsubscribe( const std::string& name )
+  {
+  }
+};
+QI_REGISTER_OBJECT(FakeSonar, subscribe, unsubscribe)
+
+class FakeBodyTemperature
+{
+public:
+  void setEnableNotifications( bool enable )
+  {
+  }
+};
+QI_REGISTER_OBJECT(FakeBodyTemperature, setEnableNotifications)
+
+class FakeRobotModel
+{
+public:
+  int _getMicrophoneConfig()
+  {
+    return 0;
+  }
+};
+QI_REGISTER_OBJECT(FakeRobotModel, _getMicrophoneConfig)
+
+class FakeTextToSpeech
+{
+public:
+  void say( const std::string& text )
+  {
+  }
+};
+QI_REGISTER_OBJECT(FakeTextToSpeech, say)
+
+/**
+* @brief LogManager whose listener never receives anything
+*/
+class FakeLogListener : public qi::LogListener
+{
+public:
+  void setLevel( qi::LogLevel level )
+  {
+  }
+
+  void addFilter( const std::string& filter, qi::LogLevel level )
+  {
+  }
+
+  void clearFilters()
+  {
+  }
+};
+
+class FakeLogManager : public qi::LogManager
+{
+public:
+  FakeLogManager():
+    listener_( new FakeLogListener )
+  {}
+
+  void log( const std::vector<qi::LogMessage>& messages )
+  {
+  }
+
+  qi::LogListenerPtr createListener()
+  {
+    return qi::LogListenerPtr( new FakeLogListener );
+  }
+
+  qi::LogListenerPtr getListener()
+  {
+    return listener_;
+  }
+
+  int addProvider( qi::LogProviderPtr provider )
+  {
+    return 0;
+  }
+
+  void removeProvider( int id )
+  {
+  }
+
+private:
+  qi::LogListenerPtr listener_;
+};
+
+FakeNaoqi::FakeNaoqi( const FakeNaoqiConfig& config ):
+  server_( qi::makeSession() ),
+  client_( qi::makeSession() ),
+  audio_( boost::make_shared<FakeAudioDevice>( config, client_ ) )
+{
+  server_->listenStandalone( "tcp://127.0.0.1:0" ).value();
+  server_->registerService( "ALMemory", boost::make_shared<FakeMemory>( config ) ).value();
+  server_->registerService( "ALMotion", boost::make_shared<FakeMotion>( config ) ).value();
+  server_->registerService( "ALVideoDevice", boost::make_shared<FakeVideoDevice>() ).value();
+  server_->registerService( "ALAudioDevice", audio_ ).value();
+  server_->registerService( "ALSonar", boost::make_shared<FakeSonar>() ).value();
+  server_->registerService( "ALBodyTemperature", boost::make_shared<FakeBodyTemperature>() ).value();
+  server_->registerService( "ALRobotModel", boost::make_shared<FakeRobotModel>() ).value();
+  server_->registerService( "ALTextToSpeech", boost::make_shared<FakeTextToSpeech>() ).value();
+  server_->registerService( "LogManager", qi::LogManagerPtr( new FakeLogManager ) ).value();
+  client_->connect( server_->endpoints()[0] ).value();
+}
+
+FakeNaoqi::~FakeNaoqi()
+{
+  audio_->stop();
+  client_->close();
+  server_->close();
+}
+
+} // bench
+} // naoqi
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef FAKE_NAOQI_HPP
+#define FAKE_NAOQI_HPP
+
+/*
+* STANDARD includes
+*/
+#include <string>
+
+/*
+* BOOST includes
+*/
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+/*
+* ALDEBARAN includes
+*/
+#include <qi/session.hpp>
+
+namespace naoqi
+{
+namespace bench
+{
+
+class FakeAudioDevice;
+
+/**
+* @brief Pace of the synthetic data served by FakeNaoqi
+*/
+struct FakeNaoqiConfig
+{
+  FakeNaoqiConfig();
+
+  /** value of RobotConfig/Body/Type, "juliette" gives a Pepper and all its converters */
+  std::string robot;
+  /** rate at which the values of ALMemory change, as refreshed by the DCM */
+  float memory_rate;
+  /** frames per channel of each chunk sent by ALAudioDevice, at 48 kHz */
+  int audio_frames;
+};
+
+/**
+* @brief In-process NAOqi serving the services the converters use, with synthetic data
+* @note the services live in a standalone session listening on the loopback,
+* the driver gets a second session connected to it, so that every call goes
+* through the libqi serialization and a socket as it does on a robot.
+* ALMemory values follow a sine wave sampled at memory_rate,
+* ALVideoDevice serves a new frame at the frame rate each camera was subscribed with and blocks until then,
+* ALAudioDevice pushes its chunks to its subscriber at the pace of the sample rate.
+*/
+class FakeNaoqi : private boost::noncopyable
+{
+public:
+  explicit FakeNaoqi( const FakeNaoqiConfig& config = FakeNaoqiConfig() );
+
+  ~FakeNaoqi();
+
+  /** Session to give to the Driver */
+  inline qi::SessionPtr session() const
+  {
+    return client_;
+  }
+
+private:
+  qi::SessionPtr server_;
+  qi::SessionPtr client_;
+  boost::shared_ptr<FakeAudioDevice> audio_;
+};
+
+} // bench
+} // naoqi
+
+#endif
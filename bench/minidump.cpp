@@ -0,0 +1,222 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/*
+* LOCAL includes
+*/
+#include <naoqi_driver/recorder/globalrecorder.hpp>
+#include "../src/recorder/dump.hpp"
+#include "../src/recorder/serialized_buffer.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+/*
+* ROS includes
+*/
+#include <naoqi_bridge_msgs/AudioBuffer.h>
+#include <ros/ros.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/JointState.h>
+
+/*
+* BENCHMARK includes
+*/
+#include <benchmark/benchmark.h>
+
+namespace
+{
+
+/** 10 s of four cameras, joint_states and audio, as buffered by the recorders with the default boot config */
+const float duration = 10.0f;
+
+sensor_msgs::Image makeImage( size_t width, size_t height, const std::string& encoding, size_t pixel_size )
+{
+  sensor_msgs::Image image;
+  image.width = width;
+  image.height = height;
+  image.encoding = encoding;
+  image.step = width * pixel_size;
+  image.data.resize( image.step * height, 42 );
+  return image;
+}
+
+class SyntheticBuffers
+{
+public:
+  SyntheticBuffers():
+    gr_( boost::make_shared<naoqi::recorder::GlobalRecorder>( "/naoqi_driver/" ) ),
+    front_( makeImage( 640, 480, "rgb8", 3 ) ),
+    bottom_( makeImage( 640, 480, "rgb8", 3 ) ),
+    depth_( makeImage( 320, 240, "16UC1", 2 ) ),
+    ir_( makeImage( 320, 240, "16UC1", 2 ) )
+  {
+    ros::Time::init();
+    gr_->setBufferBudget( 1024*1024*1024, 128*1024*1024, std::map<std::string, size_t>() );
+
+    joint_states_.name.resize( 26, "Joint" );
+    joint_states_.position.resize( 26, 0.5 );
+    joint_states_.velocity.resize( 26, 0.5 );
+    joint_states_.effort.resize( 26, 0.5 );
+
+    // 4 channels at 48 kHz, in frames of 170 ms
+    audio_.frequency = 48000;
+    audio_.channelMap.resize( 4, 0 );
+    audio_.data.resize( 4 * 8192, 42 );
+
+    addBuffer<sensor_msgs::Image>( "camera/front/image_raw" );
+    addBuffer<sensor_msgs::Image>( "camera/bottom/image_raw" );
+    addBuffer<sensor_msgs::Image>( "camera/depth/image_raw" );
+    addBuffer<sensor_msgs::Image>( "camera/ir/image_raw" );
+    addBuffer<sensor_msgs::JointState>( "joint_states" );
+    addBuffer<naoqi_bridge_msgs::AudioBuffer>( "audio" );
+  }
+
+  /** Buffer the messages of the last duration seconds, at the recorder rates of the default boot config */
+  void fill()
+  {
+    const ros::Time start( 1000, 0 );
+    fill( 0, front_, 5.0f, start );
+    fill( 1, bottom_, 5.0f, start );
+    fill( 2, depth_, 5.0f, start );
+    fill( 3, ir_, 5.0f, start );
+    fill( 4, joint_states_, 15.0f, start );
+    fill( 5, audio_, 48000.0f / 8192, start );
+  }
+
+  std::vector<naoqi::recorder::DumpSnapshot> snapshot()
+  {
+    std::vector<naoqi::recorder::DumpSnapshot> snapshots;
+    for ( size_t i=0; i<buffers_.size(); ++i )
+    {
+      snapshots.push_back( boost::bind( &naoqi::recorder::SerializedBuffer::Snapshot::collect, buffers_[i]->snapshot(), _1 ) );
+    }
+    return snapshots;
+  }
+
+  size_t bytes() const
+  {
+    size_t bytes = 0;
+    for ( size_t i=0; i<buffers_.size(); ++i )
+    {
+      bytes += buffers_[i]->bytes();
+    }
+    return bytes;
+  }
+
+  const boost::shared_ptr<naoqi::recorder::GlobalRecorder>& globalRecorder() const
+  {
+    return gr_;
+  }
+
+private:
+  template <class T>
+  void addBuffer( const std::string& topic )
+  {
+    boost::shared_ptr<naoqi::recorder::SerializedBuffer> buffer = boost::make_shared<naoqi::recorder::SerializedBuffer>();
+    channels_.push_back( buffer->addChannel<T>( topic ) );
+    buffer->reset( gr_, topic );
+    buffers_.push_back( buffer );
+  }
+
+  template <class T>
+  void fill( size_t index, const T& msg, float frequency, const ros::Time& start )
+  {
+    const size_t count = static_cast<size_t>( duration * frequency );
+    for ( size_t i=0; i<count; ++i )
+    {
+      buffers_[index]->push( channels_[index], msg, start + ros::Duration( i / frequency ) );
+    }
+  }
+
+  boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr_;
+  std::vector< boost::shared_ptr<naoqi::recorder::SerializedBuffer> > buffers_;
+  std::vector<size_t> channels_;
+
+  sensor_msgs::Image front_;
+  sensor_msgs::Image bottom_;
+  sensor_msgs::Image depth_;
+  sensor_msgs::Image ir_;
+  sensor_msgs::JointState joint_states_;
+  naoqi_bridge_msgs::AudioBuffer audio_;
+};
+
+} // anonymous
+
+/**
+* Take the messages out of the snapshots and merge them, the GlobalRecorder is not recording so nothing reaches the disk
+*/
+static void BM_MinidumpCollect( benchmark::State& state )
+{
+  SyntheticBuffers buffers;
+  size_t bytes = 0;
+  while ( state.KeepRunning() )
+  {
+    state.PauseTiming();
+    buffers.fill();
+    bytes += buffers.bytes();
+    std::vector<naoqi::recorder::DumpSnapshot> snapshots = buffers.snapshot();
+    state.ResumeTiming();
+
+    naoqi::recorder::writeSnapshots( buffers.globalRecorder(), snapshots );
+  }
+  state.SetBytesProcessed( bytes );
+}
+BENCHMARK(BM_MinidumpCollect)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/**
+* Whole minidump, down to the ROSbag written in the working directory
+*/
+static void BM_MinidumpWrite( benchmark::State& state )
+{
+  SyntheticBuffers buffers;
+  size_t bytes = 0;
+  while ( state.KeepRunning() )
+  {
+    state.PauseTiming();
+    buffers.fill();
+    bytes += buffers.bytes();
+    std::vector<naoqi::recorder::DumpSnapshot> snapshots = buffers.snapshot();
+    state.ResumeTiming();
+
+    buffers.globalRecorder()->startRecord( "bench" );
+    naoqi::recorder::writeSnapshots( buffers.globalRecorder(), snapshots );
+    buffers.globalRecorder()->stopRecord();
+
+    state.PauseTiming();
+    std::vector<std::string> files = buffers.globalRecorder()->getBagFiles();
+    for ( size_t i=0; i<files.size(); ++i )
+    {
+      boost::filesystem::remove( files[i] );
+    }
+    state.ResumeTiming();
+  }
+  state.SetBytesProcessed( bytes );
+}
+BENCHMARK(BM_MinidumpWrite)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/*
+* LOCAL includes
+*/
+#include <naoqi_driver/recorder/globalrecorder.hpp>
+#include "../src/recorder/serialized_buffer.hpp"
+#include "../src/tools/serialized_message.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+/*
+* ROS includes
+*/
+#include <ros/ros.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/Imu.h>
+#include <sensor_msgs/JointState.h>
+#include <sensor_msgs/LaserScan.h>
+
+/*
+* BENCHMARK includes
+*/
+#include <benchmark/benchmark.h>
+
+/*
+* A message published, recorded and buffered at the same tick, without the network and the disk:
+* roscpp serializes it for its remote subscribers, the GlobalRecorder copies it in its queue
+* and serializes it in the ROSbag, the buffer of the recorder serializes it in its ring.
+* Once serialized by the converter, the three of them only copy its bytes.
+*/
+
+namespace
+{
+
+void makeMessage( sensor_msgs::Imu& msg )
+{
+  msg.header.frame_id = "torso";
+  msg.orientation.w = 1.;
+}
+
+/** the 61 rays of the three lasers of Pepper */
+void makeMessage( sensor_msgs::LaserScan& msg )
+{
+  msg.header.frame_id = "base_footprint";
+  msg.ranges.resize( 61, 1.f );
+}
+
+void makeMessage( sensor_msgs::JointState& msg )
+{
+  msg.name.resize( 26, "HeadYaw" );
+  msg.position.resize( 26, 0.5 );
+}
+
+void makeMessage( sensor_msgs::Image& msg )
+{
+  msg.header.frame_id = "CameraTop_optical_frame";
+  msg.width = 640;
+  msg.height = 480;
+  msg.encoding = "rgb8";
+  msg.step = 640 * 3;
+  msg.data.resize( msg.step * msg.height, 42 );
+}
+
+/** What the GlobalRecorder writer thread does with a queued message */
+template <class M>
+void serializeInBag( const M& msg, std::vector<uint8_t>& bag )
+{
+  bag.resize( ros::serialization::serializationLength( msg ) );
+  ros::serialization::OStream stream( &bag[0], bag.size() );
+  ros::serialization::serialize( stream, msg );
+}
+
+template <class T>
+class Consumers
+{
+public:
+  Consumers():
+    gr_( boost::make_shared<naoqi::recorder::GlobalRecorder>( "/naoqi_driver/" ) ),
+    type_( naoqi::tools::messageTypeOf<T>() ),
+    stamp_( 1000, 0 )
+  {
+    ros::Time::init();
+    gr_->setBufferBudget( 256*1024*1024, 64*1024*1024, std::map<std::string, size_t>() );
+    channel_ = buffer_.addChannel<T>( "topic" );
+    buffer_.reset( gr_, "topic" );
+    makeMessage( msg_ );
+  }
+
+  /** each consumer serializes the message */
+  void consume()
+  {
+    tick();
+    ros::SerializedMessage wire = ros::serialization::serializeMessage( msg_ );
+    benchmark::DoNotOptimize( wire.buf.get() );
+    const T queued = msg_;
+    serializeInBag( queued, bag_ );
+    buffer_.push( channel_, msg_, stamp_ );
+    buffer_.removeOlderThan( stamp_ - ros::Duration( 10. ) );
+  }
+
+  /** the converter serializes the message once for the three of them */
+  void consumeSerialized()
+  {
+    tick();
+    const naoqi::tools::SerializedMessage serialized = naoqi::tools::serializeMessage( msg_, type_ );
+    ros::SerializedMessage wire = ros::serialization::serializeMessage( serialized );
+    benchmark::DoNotOptimize( wire.buf.get() );
+    const naoqi::tools::SerializedMessage queued = serialized;
+    serializeInBag( queued, bag_ );
+    buffer_.push( channel_, serialized, stamp_ );
+    buffer_.removeOlderThan( stamp_ - ros::Duration( 10. ) );
+  }
+
+  size_t size() const
+  {
+    return ros::serialization::serializationLength( msg_ );
+  }
+
+private:
+  void tick()
+  {
+    stamp_ = stamp_ + ros::Duration( 0.1 );
+    msg_.header.stamp = stamp_;
+  }
+
+  boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr_;
+  naoqi::recorder::SerializedBuffer buffer_;
+  size_t channel_;
+  boost::shared_ptr<const naoqi::tools::MessageType> type_;
+  std::vector<uint8_t> bag_;
+  ros::Time stamp_;
+  T msg_;
+};
+
+} // anonymous
+
+/**
+* One message published, recorded and buffered
+* @param range(0) 0 when each consumer serializes it, 1 when the converter serializes it once
+*/
+template <class T>
+static void BM_PublishRecordLog( benchmark::State& state )
+{
+  Consumers<T> consumers;
+  while ( state.KeepRunning() )
+  {
+    if ( state.range(0) == 0 )
+    {
+      consumers.consume();
+    }
+    else
+    {
+      consumers.consumeSerialized();
+    }
+  }
+  state.SetBytesProcessed( state.iterations() * consumers.size() );
+}
+BENCHMARK_TEMPLATE(BM_PublishRecordLog, sensor_msgs::Imu)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_PublishRecordLog, sensor_msgs::LaserScan)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_PublishRecordLog, sensor_msgs::JointState)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_PublishRecordLog, sensor_msgs::Image)->Arg(0)->Arg(1);
@@ -22,6 +22,11 @@
 
 #include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/type_traits/is_base_of.hpp>
+
+#include <qi/anyvalue.hpp>
+#include <qi/future.hpp>
 
 #include <ros/ros.h>
 #include <naoqi_driver/message_actions.h>
@@ -31,6 +36,16 @@ namespace naoqi
 namespace converter
 {
 
+/**
+* @brief Tag for converters which split their work in two steps
+* @note such a converter implements, next to callAll:
+* - qi::Future<qi::AnyValue> fetch() which only issues the libqi request
+* - void convert( actions, qi::AnyValue& data ) which builds and dispatches the messages
+* so that the driver can have the requests of several converters in flight at once
+*/
+class AsyncConverter
+{
+};
 
 /**
 * @brief Converter concept interface
@@ -49,7 +64,7 @@ public:
   */
   template<typename T>
   Converter( T conv ):
-    convPtr_( boost::make_shared<ConverterModel<T> >(conv) )
+    convPtr_( boost::make_shared<typename ModelOf<T>::type>(conv) )
   {}
 
   /**
@@ -87,6 +102,39 @@ public:
     before = after;
   }
 
+  /**
+  * @brief whether fetch() really issues a request or is only the synchronous adapter
+  */
+  bool isAsynchronous() const
+  {
+    return convPtr_->isAsynchronous();
+  }
+
+  /**
+  * @brief start the libqi request of this converter without waiting for its answer
+  * @note synchronous converters return an already finished future,
+  * their request is made in convert()
+  */
+  qi::Future<qi::AnyValue> fetch()
+  {
+    return convPtr_->fetch();
+  }
+
+  /**
+  * @brief continuation of fetch(): wait for the data and dispatch it to the actions
+  */
+  void convert( const std::vector<message_actions::MessageAction>& actions, const qi::Future<qi::AnyValue>& data )
+  {
+    if ( actions.size() > 0 )
+    {
+      convPtr_->convert(actions, data);
+    }
+
+    ros::Time after = ros::Time::now();
+    lapse_time = after - before;
+    before = after;
+  }
+
   ros::Duration lapseTime() const
   {
     return lapse_time;
@@ -115,6 +163,9 @@ private:
     virtual float frequency() const = 0;
     virtual void reset() = 0;
     virtual void callAll( const std::vector<message_actions::MessageAction>& actions ) = 0;
+    virtual bool isAsynchronous() const = 0;
+    virtual qi::Future<qi::AnyValue> fetch() = 0;
+    virtual void convert( const std::vector<message_actions::MessageAction>& actions, const qi::Future<qi::AnyValue>& data ) = 0;
   };
 
 
@@ -148,9 +199,71 @@ private:
       converter_->callAll( actions );
     }
 
+    /**
+    * synchronous adapter: nothing to fetch beforehand, everything happens in callAll
+    */
+    bool isAsynchronous() const
+    {
+      return false;
+    }
+
+    qi::Future<qi::AnyValue> fetch()
+    {
+      return qi::Future<qi::AnyValue>( qi::AnyValue() );
+    }
+
+    void convert( const std::vector<message_actions::MessageAction>& actions, const qi::Future<qi::AnyValue>& )
+    {
+      converter_->callAll( actions );
+    }
+
     T converter_;
   };
 
+  /**
+  * model of the converters tagged with AsyncConverter
+  */
+  template<typename T>
+  struct AsyncConverterModel : public ConverterModel<T>
+  {
+    AsyncConverterModel( const T& other ):
+      ConverterModel<T>( other )
+    {}
+
+    bool isAsynchronous() const
+    {
+      return true;
+    }
+
+    qi::Future<qi::AnyValue> fetch()
+    {
+      return this->converter_->fetch();
+    }
+
+    void convert( const std::vector<message_actions::MessageAction>& actions, const qi::Future<qi::AnyValue>& data )
+    {
+      // the driver reports the failed requests, there is nothing to convert
+      if ( data.hasError() )
+      {
+        return;
+      }
+      qi::AnyValue value = data.value();
+      this->converter_->convert( actions, value );
+    }
+  };
+
+  /**
+  * picks the model according to the tag of the converter held by T (a shared pointer)
+  */
+  template<typename T>
+  struct ModelOf
+  {
+    typedef typename boost::mpl::if_<
+      boost::is_base_of<AsyncConverter, typename T::element_type>,
+      AsyncConverterModel<T>,
+      ConverterModel<T> >::type type;
+  };
+
   boost::shared_ptr<ConverterConcept> convPtr_;
 
 }; // class converter
@@ -26,6 +26,7 @@
 #include <ros/ros.h>
 #include <naoqi_driver/message_actions.h>
 #include <naoqi_driver/recorder/globalrecorder.hpp>
+#include <naoqi_driver/recorder/record_profile.hpp>
 #include <naoqi_driver/tools.hpp>
 
 namespace naoqi
@@ -74,9 +75,9 @@ public:
     eventPtr_->stopProcess();
   }
 
-  void writeDump( const ros::Time& time )
+  recorder::DumpSnapshot snapshot( const ros::Time& time )
   {
-    eventPtr_->writeDump(time);
+    return eventPtr_->snapshot(time);
   }
 
   void setBufferDuration(float duration)
@@ -84,6 +85,11 @@ public:
     eventPtr_->setBufferDuration(duration);
   }
 
+  void setProfile(const recorder::RecordProfile& profile)
+  {
+    eventPtr_->setProfile(profile);
+  }
+
   void isRecording(bool state)
   {
     eventPtr_->isRecording(state);
@@ -111,8 +117,9 @@ private:
     virtual void resetRecorder(boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr) = 0;
     virtual void startProcess() = 0;
     virtual void stopProcess() = 0;
-    virtual void writeDump(const ros::Time& time) = 0;
+    virtual recorder::DumpSnapshot snapshot(const ros::Time& time) = 0;
     virtual void setBufferDuration(float duration) = 0;
+    virtual void setProfile(const recorder::RecordProfile& profile) = 0;
     virtual void isRecording(bool state) = 0;
     virtual void isPublishing(bool state) = 0;
     virtual void isDumping(bool state) = 0;
@@ -149,9 +156,9 @@ private:
       converter_->stopProcess();
     }
 
-    void writeDump( const ros::Time& time )
+    recorder::DumpSnapshot snapshot( const ros::Time& time )
     {
-      converter_->writeDump(time);
+      return converter_->snapshot(time);
     }
 
     void setBufferDuration(float duration)
@@ -159,6 +166,11 @@ private:
       converter_->setBufferDuration(duration);
     }
 
+    void setProfile(const recorder::RecordProfile& profile)
+    {
+      converter_->setProfile(profile);
+    }
+
     void isRecording(bool state)
     {
       converter_->isRecording(state);
@@ -58,6 +58,11 @@ namespace recorder
 {
   class GlobalRecorder;
 }
+namespace converter
+{
+  class ReplayClock;
+}
+class AudioEventRegister;
 /**
 * @brief Interface for naoqi driver which is registered as a naoqi2 Module,
 * once the external roscore ip is set, this class will advertise and publish ros messages
@@ -83,9 +88,10 @@ public:
   void stopRosLoop();
   /**
    * @brief Write a ROSbag with the last bufferized data (10s by default)
+   * @note the buffers are snapshot and written by a background thread, the returned future holds the path of the ROSbag
    */
-  std::string minidump(const std::string& prefix);
-  std::string minidumpConverters(const std::string& prefix, const std::vector<std::string>& names);
+  qi::Future<std::string> minidump(const std::string& prefix);
+  qi::Future<std::string> minidumpConverters(const std::string& prefix, const std::vector<std::string>& names);
 
   void setBufferDuration(float duration);
   float getBufferDuration();
@@ -146,6 +152,11 @@ public:
    */
   std::vector<std::string> getSubscribedPublishers() const;
 
+  /**
+   * @brief get the converters taken out of the ROS loop because nothing publishes, records or logs their data
+   */
+  std::vector<std::string> getSuspendedConverters();
+
   std::string _whoIsYourDaddy()
   {
     return "A sugar bear";
@@ -207,6 +218,12 @@ public:
   */
   void startRecordingConverters(const std::vector<std::string>& names);
 
+  /**
+  * @brief qicli call function to start recording given topics in a ROSbag, each one through its record profile
+  * @param profile JSON object giving a RecordProfile per converter name (decimation, max_rate, window, strip)
+  */
+  void startRecordingConvertersProfile(const std::vector<std::string>& names, const std::string& profile);
+
   /**
   * @brief qicli call function to stop recording all registered publisher in a ROSbag
   */
@@ -227,6 +244,71 @@ public:
 
   std::vector<std::string> getFilesList();
 
+  /**
+   * @brief qicli call function to get the latency, payload and error counters of the libqi calls made by the converters
+   * @note only filled when the driver is built with NAOQI_DRIVER_RPC_STATS
+   */
+  std::vector<std::string> getRpcStatistics();
+
+  void resetRpcStatistics();
+
+  /**
+   * @brief qicli call function to get the tick rate, latency, CPU time and allocations of each converter
+   * @note only filled when the driver is built with NAOQI_DRIVER_CONVERTER_STATS
+   */
+  std::vector<std::string> getConverterStatistics();
+
+  void resetConverterStatistics();
+
+  /**
+   * @brief qicli call function to write the last events of the timeline of each thread as Chrome trace-event JSON
+   * @param path file to write, naoqi_driver.trace.json in the working directory if empty
+   * @note only filled when the driver is built with NAOQI_DRIVER_TRACE
+   * @return the path of the file, or the reason why there is none
+   */
+  std::string dumpTrace(const std::string& path);
+
+  /**
+   * @brief qicli call function to get the depth of the bag writer queue, the bytes written and the dropped messages
+   */
+  std::vector<std::string> getRecorderStatistics();
+
+  /**
+   * @brief qicli call function to write in a ROSbag the buffers that the previous run left in its black box
+   */
+  std::string recoverBlackBox();
+
+  /**
+   * @brief qicli call function to play a ROSbag back in place of the NAOqi converters
+   * @param path ROSbag to replay, a minidump or a record
+   * @param speed 1 for real time, N for N times faster, 0 to go as fast as the driver can
+   * @note the messages go through the publishers, the recorders and the scheduling of the ROS loop,
+   * the NAOqi converters and events are dropped
+   * @return false if the ROSbag cannot be read, the converters are then kept
+   */
+  bool startReplay(const std::string& path, float speed);
+
+  /**
+   * @brief qicli call function to get, per replayed topic, the messages sent, their rate and how late they went out
+   */
+  std::vector<std::string> getReplayStatistics();
+
+  /**
+   * @brief qicli call function to get the audio frames received, the ones dropped because the audio worker was behind and its queue depth
+   */
+  std::vector<std::string> getAudioStatistics();
+
+  /**
+   * @brief qicli call function to get the NAOqi logs received, the ones dropped because the log converter was behind and the ones waiting for it
+   */
+  std::vector<std::string> getLogStatistics();
+
+  /**
+   * @brief qicli call function to write a copy of a ROSbag in which the compressed audio is decoded back to naoqi_bridge_msgs/AudioBuffer
+   * @return the path of the new ROSbag, or the reason why there is none
+   */
+  std::string decodeAudioBag(const std::string& path);
+
   void removeAllFiles();
 
   void removeFiles(std::vector<std::string> files);
@@ -240,13 +322,21 @@ private:
   bool record_enabled_;
   bool log_enabled_;
   bool keep_looping;
+  bool dump_in_progress_;
 
   const size_t freq_;
   boost::thread publisherThread_;
+  boost::thread dumpThread_;
   //ros::Rate r_;
 
   boost::shared_ptr<recorder::GlobalRecorder> recorder_;
 
+  /** clock of the ROSbag being replayed, if any */
+  boost::shared_ptr<converter::ReplayClock> replay_clock_;
+
+  /** audio event, kept to read its statistics */
+  boost::shared_ptr<AudioEventRegister> audio_register_;
+
   /* boot config */
   boost::property_tree::ptree boot_config_;
   void loadBootConfig();
@@ -254,6 +344,7 @@ private:
   void registerDefaultConverter();
   void registerDefaultSubscriber();
   void registerDefaultServices();
+  void registerReplayConverters(const std::string& path, float speed);
   void insertEventConverter(const std::string& key, event::Event event);
 
   template <typename T1, typename T2, typename T3>
@@ -269,10 +360,36 @@ private:
 
   void rosLoop();
 
+  qi::Future<std::string> startDump( const std::string& prefix, const std::vector<recorder::DumpSnapshot>& dumps );
+  void writeDump( const std::string& prefix, const std::vector<recorder::DumpSnapshot>& dumps, qi::Promise<std::string> promise );
+
+  /**
+   * @brief decide which actions (publish, record, log) a converter has to perform now
+   * @return false when the recording state could not be read, an empty list of actions is then no reason to suspend the converter
+   */
+  bool getActions( const converter::Converter& conv, std::vector<message_actions::MessageAction>& actions );
+
+  /**
+   * @brief ask the ROS loop to put a suspended converter back in the queue, called when its publisher gets a first subscriber
+   */
+  void wakeConverter( const std::string& name );
+
+  /**
+   * @brief ask the ROS loop to put all the suspended converters back in the queue, called when publishing, recording or logging starts
+   */
+  void wakeConverters();
+
+  /**
+   * @brief put back in the queue the converters woken up since the last call, mutex_conv_queue_ has to be held
+   */
+  void resumeConverters();
+
   boost::scoped_ptr<ros::NodeHandle> nhPtr_;
   boost::mutex mutex_reinit_;
   boost::mutex mutex_conv_queue_;
   boost::mutex mutex_record_;
+  boost::mutex mutex_dump_;
+  boost::mutex mutex_wake_;
 
   std::vector< converter::Converter > converters_;
   std::map< std::string, publisher::Publisher > pub_map_;
@@ -306,9 +423,33 @@ private:
     size_t conv_index_;
   };
 
+  /** Converter of a batch whose request has been issued and still has to be converted */
+  struct PendingConversion {
+    PendingConversion(size_t conv_index) :
+       conv_index_(conv_index),
+       idle_(false)
+    {
+    }
+
+    size_t conv_index_;
+    /** actions to perform, none if the converter is not needed right now */
+    std::vector<message_actions::MessageAction> actions_;
+    /** true when nothing consumes the data of the converter, it is then suspended instead of being rescheduled */
+    bool idle_;
+    /** answer of the request started by Converter::fetch */
+    qi::Future<qi::AnyValue> data_;
+  };
+
   /** Priority queue to process the publishers according to their frequency */
   std::priority_queue<ScheduledConverter> conv_queue_;
 
+  /** Converters out of the queue until a subscriber comes or publishing, recording or logging starts, guarded by mutex_conv_queue_ */
+  std::vector<size_t> suspended_;
+
+  /** Converters to wake up, read by the ROS loop, guarded by mutex_wake_ */
+  std::vector<std::string> wake_requests_;
+  bool wake_all_;
+
   /** tf2 buffer that will be shared between different publishers/subscribers
    * This is only for performance improvements
    */
@@ -20,6 +20,7 @@
 
 #include <string>
 
+#include <boost/function.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
 
@@ -37,6 +38,10 @@ namespace publisher
 * which each instance has to implement
 * @note a type erasure pattern in implemented here to avoid strict inheritance,
 * thus each possible publisher instance has to implement the virtual functions mentioned in the concept
+* @note the messages are handed to a publisher by the callbacks of its converter, not through this interface.
+* Besides publish( const T& ), a publisher may offer publishShared( const boost::shared_ptr<const T>& ):
+* roscpp then gives the message as is to the subscribers in the same process (e.g. nodelets) and only serializes it
+* for the remote ones. Such a message must never change once published, the converters take it from a tools::MessagePool.
 */
 class Publisher
 {
@@ -69,6 +74,16 @@ public:
     return pubPtr_->isSubscribed();
   }
 
+  /**
+  * @brief sets the function called when the first subscriber comes
+  * @note isSubscribed() reads a flag kept by the subscriber status callbacks of the publisher,
+  * this function is called from the same callbacks, in the thread spinning ROS, so that a suspended converter gets woken up
+  */
+  void onSubscribe( const boost::function<void ()>& callback )
+  {
+    pubPtr_->onSubscribe( callback );
+  }
+
   /**
   * @brief initializes/resets the publisher into ROS with a given nodehandle,
   * this will be called at first for initialization or again when master uri has changed
@@ -113,6 +128,7 @@ private:
     virtual ~PublisherConcept(){}
     virtual bool isInitialized() const = 0;
     virtual bool isSubscribed() const = 0;
+    virtual void onSubscribe( const boost::function<void ()>& callback ) = 0;
     virtual void reset( ros::NodeHandle& nh ) = 0;
     virtual std::string topic() const = 0;
   };
@@ -143,6 +159,11 @@ private:
       return publisher_->isSubscribed();
     }
 
+    void onSubscribe( const boost::function<void ()>& callback )
+    {
+      publisher_->onSubscribe( callback );
+    }
+
     void reset( ros::NodeHandle& nh )
     {
       publisher_->reset( nh );
@@ -26,12 +26,21 @@
 /*
 * STANDARD includes
 */
+#include <deque>
+#include <map>
 #include <string>
+#include <vector>
 
 /*
 * BOOST includes
 */
+# include <boost/atomic.hpp>
+# include <boost/bind.hpp>
+# include <boost/cstdint.hpp>
+# include <boost/function.hpp>
+# include <boost/thread/condition_variable.hpp>
 # include <boost/thread/mutex.hpp>
+# include <boost/thread/thread.hpp>
 
 /*
 * ROS includes
@@ -44,9 +53,23 @@
 
 namespace naoqi
 {
+namespace tools
+{
+  struct SerializedMessage;
+}
 namespace recorder
 {
 
+class BagStorage;
+class BlackBox;
+
+struct DumpRecord;
+
+/**
+* @brief Appends the messages a recorder had buffered when it was snapshot, see writeSnapshots
+*/
+typedef boost::function<void (std::vector<DumpRecord>&)> DumpSnapshot;
+
 /**
 * @brief GlobalRecorder concept interface
 * @note this defines an private concept struct,
@@ -59,13 +82,96 @@ class GlobalRecorder
 
 public:
 
+  /**
+  * @brief What write() does when the queue of the writer thread is full
+  */
+  enum OverflowPolicy
+  {
+    BLOCK,       // wait for the writer thread to make room
+    DROP_OLDEST, // discard the oldest queued messages
+    DROP_NEWEST  // discard the message being written
+  };
+
   /**
   * @brief Constructor for recorder interface
   */
   GlobalRecorder(const std::string& prefix_topic);
 
+  ~GlobalRecorder();
+
+  /**
+  * @brief Set the size of the write queue and its overflow policy
+  * @param max_bytes serialized size of the queued messages above which the policy applies
+  */
+  void setWriteQueue(size_t max_bytes, OverflowPolicy policy);
+
+  /**
+  * @brief Set the chunk compression of the next bags
+  */
+  void setCompression(rosbag::compression::CompressionType compression);
+
+  /**
+  * @brief Split the next records into numbered bags
+  * @param max_bytes size above which a new bag is started, 0 to disable
+  * @param max_duration time in seconds after which a new bag is started, 0 to disable
+  */
+  void setRotation(boost::uint64_t max_bytes, double max_duration);
+
+  /**
+  * @brief Bags of the current record, or of the last one if none is running
+  */
+  std::vector<std::string> getBagFiles();
+
+  /**
+  * @brief Set the memory shared by the buffers of all the recorders
+  * @param total_bytes global budget
+  * @param topic_bytes capacity asked by a buffer whose topic is not in topics_bytes
+  * @param topics_bytes capacity asked per topic
+  */
+  void setBufferBudget(size_t total_bytes, size_t topic_bytes, const std::map<std::string, size_t>& topics_bytes);
+
+  /**
+  * @brief Reserve the capacity of the buffer of a topic
+  * @return the number of bytes granted, less than asked when the global budget is exhausted
+  */
+  size_t reserveBuffer(const std::string& topic);
+
+  /**
+  * @brief Give back bytes reserved by reserveBuffer
+  */
+  void releaseBuffer(size_t bytes);
+
+  /**
+  * @brief Number of bytes reserved by the buffers of the recorders
+  */
+  size_t bufferBytesReserved();
+
+  /**
+  * @brief Keep the buffers of the recorders in a memory mapped file, so that they survive a crash
+  * @note a black box left by a previous run is first renamed to path.previous, see recoverBlackBox
+  * @note to be called before the recorders are registered
+  */
+  void enableBlackBox(const std::string& path, size_t size);
+
+  /**
+  * @brief The black box holding the buffers, empty if they are on the heap
+  */
+  const boost::shared_ptr<BlackBox>& blackBox() const;
+
+  /**
+  * @brief Write in a new ROSbag the buffers saved in the black box of the previous run
+  * @return the path of the ROSbag, or the reason why there is none
+  */
+  std::string recoverBlackBox();
+
+  /**
+  * @brief Bags of the recording directory, with the bytes they take
+  */
+  const boost::shared_ptr<BagStorage>& storage() const;
+
   /**
   * @brief Initialize the recording of the ROSbag
+  * @throw std::runtime_error if a record is already started, its bag is never shared
   */
   void startRecord(const std::string& prefix_bag = "");
 
@@ -76,9 +182,14 @@ public:
 
   /**
   * @brief Insert data into the ROSbag
+  * @note the message is copied and queued, the disk access is done by the writer thread
   */
   template <class T>
   void write(const std::string& topic, const T& msg, const ros::Time& time = ros::Time::now() ) {
+    // no copy of the message when no bag is opened, push checks again under the lock
+    if (!_isStarted) {
+      return;
+    }
     std::string ros_topic;
     if (topic[0]!='/')
     {
@@ -89,25 +200,114 @@ public:
       ros_topic = topic;
     }
     ros::Time time_msg = time;
-    boost::mutex::scoped_lock writeLock( _processMutex );
-    if (_isStarted) {
-      _bag.write(ros_topic, time_msg, msg);
-    }
+    WriteRequest request;
+    request.size = ros::serialization::serializationLength(msg);
+    request.write = boost::bind(&GlobalRecorder::writeToBag<T>, _1, ros_topic, time_msg, msg);
+    push(request);
   }
 
   void write(const std::string& topic, const std::vector<geometry_msgs::TransformStamped>& msgtf);
 
+  /**
+  * @brief Insert a serialized message into the ROSbag, waiting for room in the queue whatever the overflow policy
+  * @note used to write the minidumps and the recovered black box, which must not lose records
+  */
+  void writeSerialized(const std::string& topic, const tools::SerializedMessage& msg, const ros::Time& time);
+
   /**
   * @brief Check if the ROSbag is opened
   */
   bool isStarted();
 
+  /**
+  * @brief Number of messages waiting for the writer thread
+  */
+  size_t queueDepth();
+
+  /**
+  * @brief Serialized size of the messages written since the construction
+  */
+  boost::uint64_t bytesWritten();
+
+  /**
+  * @brief Number of messages discarded by the overflow policy since the construction
+  */
+  boost::uint64_t droppedMessages();
+
+  /**
+  * @brief Number of messages the writer thread failed to write in the bag since the construction
+  */
+  boost::uint64_t failedMessages();
+
 private:
+  /** Deferred bag write, executed by the writer thread */
+  struct WriteRequest
+  {
+    boost::function<void (rosbag::Bag&)> write;
+    size_t size;
+  };
+
+  template <class T>
+  static void writeToBag(rosbag::Bag& bag, const std::string& topic, const ros::Time& time, const T& msg)
+  {
+    bag.write(topic, time, msg);
+  }
+
+  /** Queue a request for the writer thread, applying the overflow policy unless block is set */
+  void push(const WriteRequest& request, bool block = false);
+
+  /** Open the bag of the given index of the record, only called by startRecord and the writer thread */
+  void openBag(size_t index);
+
+  /** Close the current bag and go on with the next one if the size or duration limit is reached */
+  void rotateIfNeeded();
+
+  /** Writer thread: drains the queue into the bag until the record is stopped */
+  void writerLoop();
+
   std::string _prefix_topic;
   boost::mutex _processMutex;
   rosbag::Bag _bag;
   std::string _nameBag;
-  bool _isStarted;
+  /** written under _queueMutex, read without it to skip the copies when no bag is opened */
+  boost::atomic<bool> _isStarted;
+
+  // BAG FILES
+  /** path of the bags of the record without the extension */
+  std::string _baseNameBag;
+  std::vector<std::string> _bagFiles;
+  boost::mutex _bagFilesMutex;
+  rosbag::compression::CompressionType _compression;
+  boost::uint64_t _rotationMaxBytes;
+  ros::WallDuration _rotationMaxDuration;
+  ros::WallTime _bagOpenTime;
+
+  // BUFFER BUDGET
+  boost::mutex _budgetMutex;
+  size_t _budgetTotal;
+  size_t _budgetTopicDefault;
+  std::map<std::string, size_t> _budgetTopics;
+  size_t _budgetReserved;
+
+  // STORAGE
+  boost::shared_ptr<BagStorage> _storage;
+
+  // BLACK BOX
+  boost::shared_ptr<BlackBox> _blackBox;
+  std::string _previousBlackBox;
+
+  // WRITE QUEUE
+  boost::thread _writerThread;
+  boost::mutex _queueMutex;
+  boost::condition_variable _queueNotEmpty;
+  boost::condition_variable _queueNotFull;
+  std::deque<WriteRequest> _queue;
+  size_t _queueBytes;
+  size_t _queueMaxBytes;
+  OverflowPolicy _overflowPolicy;
+  boost::uint64_t _bytesWritten;
+  boost::uint64_t _droppedMessages;
+  boost::uint64_t _failedMessages;
 
   // TOPICS
   std::vector<Topics> _topics;
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RECORD_PROFILE_HPP
+#define RECORD_PROFILE_HPP
+
+/*
+* STANDARD includes
+*/
+#include <set>
+#include <string>
+
+/*
+* ROS includes
+*/
+#include <ros/ros.h>
+
+namespace naoqi
+{
+namespace recorder
+{
+
+/**
+* @brief How a topic is recorded by startRecording, the default records everything
+*/
+struct RecordProfile
+{
+  RecordProfile():
+    decimation( 1 ),
+    max_rate( 0 ),
+    window_start( 0 ),
+    window_end( 0 )
+  {}
+
+  /** keep one message out of decimation */
+  int decimation;
+  /** maximum number of messages per second, 0 for no limit */
+  float max_rate;
+  /** seconds after the start of the record before which nothing is recorded */
+  float window_start;
+  /** seconds after the start of the record after which nothing is recorded, 0 for no end */
+  float window_end;
+  /** parts of the messages not recorded, their names depend on the recorder */
+  std::set<std::string> strip;
+};
+
+/**
+* @brief Applies a RecordProfile to the messages of a recorder, before they are given to the GlobalRecorder
+* @note not thread safe, the profile is set before the recorder is subscribed
+*/
+class RecordFilter
+{
+
+public:
+  RecordFilter():
+    counter_( 0 )
+  {}
+
+  /**
+  * @brief Apply a profile from now on, the time window starts now
+  */
+  void setProfile( const RecordProfile& profile )
+  {
+    profile_ = profile;
+    counter_ = 0;
+    last_ = ros::Time();
+    start_ = ros::Time::now();
+  }
+
+  /**
+  * @brief Tell whether a message stamped at stamp is recorded
+  */
+  bool accept( const ros::Time& stamp )
+  {
+    const ros::Time& time = stamp.isZero() ? ros::Time::now() : stamp;
+    if ( profile_.window_start > 0 && time < start_ + ros::Duration( profile_.window_start ) )
+    {
+      return false;
+    }
+    if ( profile_.window_end > 0 && time > start_ + ros::Duration( profile_.window_end ) )
+    {
+      return false;
+    }
+    if ( profile_.decimation > 1 && counter_++ % profile_.decimation != 0 )
+    {
+      return false;
+    }
+    if ( profile_.max_rate > 0 && !last_.isZero() && ( time - last_ ).toSec() < 1.0 / profile_.max_rate )
+    {
+      return false;
+    }
+    last_ = time;
+    return true;
+  }
+
+  /**
+  * @brief Tell whether a part of the messages is not recorded
+  */
+  inline bool strips( const std::string& part ) const
+  {
+    return profile_.strip.count( part ) > 0;
+  }
+
+private:
+  RecordProfile profile_;
+  int counter_;
+  ros::Time last_;
+  ros::Time start_;
+
+}; // class
+
+} // recorder
+} // naoqi
+
+#endif
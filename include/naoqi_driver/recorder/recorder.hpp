@@ -30,6 +30,7 @@
 #include <geometry_msgs/TransformStamped.h>
 
 #include "naoqi_driver/recorder/globalrecorder.hpp"
+#include "naoqi_driver/recorder/record_profile.hpp"
 
 namespace naoqi
 {
@@ -95,9 +96,12 @@ public:
     recPtr_->reset( gr, frequency );
   }
 
-  void writeDump(const ros::Time& time)
+  /**
+  * @brief Take the buffered messages out of the recorder, to be written later without blocking it
+  */
+  DumpSnapshot snapshot(const ros::Time& time)
   {
-    recPtr_->writeDump(time);
+    return recPtr_->snapshot(time);
   }
 
   void setBufferDuration(float duration)
@@ -105,6 +109,14 @@ public:
     recPtr_->setBufferDuration(duration);
   }
 
+  /**
+  * @brief Set how the messages are recorded, to be called before subscribe
+  */
+  void setProfile(const RecordProfile& profile)
+  {
+    recPtr_->setProfile(profile);
+  }
+
   friend bool operator==( const Recorder& lhs, const Recorder& rhs )
   {
     // decision made for OR-comparison since we want to be more restrictive
@@ -125,8 +137,9 @@ private:
     virtual void subscribe(bool state) = 0;
     virtual bool isSubscribed() const = 0;
     virtual std::string topic() const = 0;
-    virtual void writeDump(const ros::Time& time) = 0;
+    virtual DumpSnapshot snapshot(const ros::Time& time) = 0;
     virtual void setBufferDuration(float duration) = 0;
+    virtual void setProfile(const RecordProfile& profile) = 0;
     virtual void reset( boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr, float frequency ) = 0;
   };
 
@@ -166,9 +179,9 @@ private:
       return recorder_->topic();
     }
 
-    void writeDump(const ros::Time& time)
+    DumpSnapshot snapshot(const ros::Time& time)
     {
-      recorder_->writeDump(time);
+      return recorder_->snapshot(time);
     }
 
     void setBufferDuration(float duration)
@@ -176,6 +189,11 @@ private:
       recorder_->setBufferDuration(duration);
     }
 
+    void setProfile(const RecordProfile& profile)
+    {
+      recorder_->setProfile(profile);
+    }
+
     T recorder_;
   };
 
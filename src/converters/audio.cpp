@@ -47,12 +47,26 @@ void AudioEventConverter::registerCallback( const message_actions::MessageAction
   callbacks_[action] = cb;
 }
 
-void AudioEventConverter::callAll(const std::vector<message_actions::MessageAction>& actions, naoqi_bridge_msgs::AudioBuffer& msg)
+void AudioEventConverter::registerSharedCallback( const message_actions::MessageAction action, SharedCallback_t cb )
 {
-  msg_ = msg;
+  shared_callbacks_[action] = cb;
+}
+
+void AudioEventConverter::callAll(const std::vector<message_actions::MessageAction>& actions, const boost::shared_ptr<naoqi_bridge_msgs::AudioBuffer>& msg)
+{
+  // the message comes from the pool of the audio event, it is given as is to every callback
   for_each( message_actions::MessageAction action, actions )
   {
-    callbacks_[action](msg_);
+    NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
+    std::map<message_actions::MessageAction, SharedCallback_t>::const_iterator shared = shared_callbacks_.find(action);
+    if ( shared != shared_callbacks_.end() )
+    {
+      shared->second(msg);
+    }
+    else
+    {
+      callbacks_[action](*msg);
+    }
   }
 }
 
@@ -43,6 +43,8 @@ class AudioEventConverter : public BaseConverter<AudioEventConverter>
 
   typedef boost::function<void(naoqi_bridge_msgs::AudioBuffer&) > Callback_t;
 
+  typedef boost::function<void(const boost::shared_ptr<const naoqi_bridge_msgs::AudioBuffer>&) > SharedCallback_t;
+
 public:
   AudioEventConverter(const std::string& name, const float& frequency, const qi::SessionPtr& session);
 
@@ -52,12 +54,15 @@ public:
 
   void registerCallback( const message_actions::MessageAction action, Callback_t cb );
 
-  void callAll(const std::vector<message_actions::MessageAction>& actions, naoqi_bridge_msgs::AudioBuffer& msg);
+  /** Register a callback taking the message itself rather than a reference, it replaces the other one for this action */
+  void registerSharedCallback( const message_actions::MessageAction action, SharedCallback_t cb );
+
+  void callAll(const std::vector<message_actions::MessageAction>& actions, const boost::shared_ptr<naoqi_bridge_msgs::AudioBuffer>& msg);
 
 private:
   /** Registered Callbacks **/
   std::map<message_actions::MessageAction, Callback_t> callbacks_;
-  naoqi_bridge_msgs::AudioBuffer msg_;
+  std::map<message_actions::MessageAction, SharedCallback_t> shared_callbacks_;
 };
 
 }
@@ -122,7 +122,7 @@ const sensor_msgs::CameraInfo& getCameraInfo( int camera_source, int resolution
 
 CameraConverter::CameraConverter( const std::string& name, const float& frequency, const qi::SessionPtr& session, const int& camera_source, const int& resolution )
   : BaseConverter( name, frequency, session ),
-    p_video_( session->service("ALVideoDevice") ),
+    p_video_( session->service("ALVideoDevice"), "ALVideoDevice" ),
     camera_source_(camera_source),
     resolution_(resolution),
     // change in case of depth camera
@@ -189,17 +189,37 @@ void CameraConverter::registerCallback( const message_actions::MessageAction act
   callbacks_[action] = cb;
 }
 
+void CameraConverter::registerSerializedCallback( const message_actions::MessageAction action, SerializedCallbacks_t::Callback_t cb )
+{
+  serialized_callbacks_.registerCallback( action, cb );
+}
+
 void CameraConverter::callAll( const std::vector<message_actions::MessageAction>& actions )
 {
+  qi::Future<qi::AnyValue> image_future = fetch();
+  if ( image_future.hasError() )
+  {
+    std::cerr << name_ << " " << image_future.error() << std::endl;
+    return;
+  }
+  qi::AnyValue image_anyvalue = image_future.value();
+  convert( actions, image_anyvalue );
+}
 
+qi::Future<qi::AnyValue> CameraConverter::fetch()
+{
   if (handle_.empty() )
   {
     std::cerr << name_ << "Camera Handle is empty - cannot retrieve image" << std::endl;
     std::cerr << name_ << "Might be a NAOqi problem. Try to restart the ALVideoDevice." << std::endl;
-    return;
+    return qi::makeFutureError<qi::AnyValue>("no camera handle");
   }
 
-  qi::AnyValue image_anyvalue = p_video_.call<qi::AnyValue>("getImageRemote", handle_);
+  return p_video_.async<qi::AnyValue>("getImageRemote", handle_);
+}
+
+void CameraConverter::convert( const std::vector<message_actions::MessageAction>& actions, qi::AnyValue& image_anyvalue )
+{
   tools::NaoqiImage image;
   try{
       image = tools::fromAnyValueToNaoqiImage(image_anyvalue);
@@ -220,9 +240,16 @@ void CameraConverter::callAll( const std::vector<message_actions::MessageAction>
   //msg_->header.stamp.nsec = image.timestamp_us*1000;
   camera_info_.header.stamp = msg_->header.stamp;
 
+  // serialized once when the image is recorded and buffered at the same tick
+  const bool serialize_once = serialized_callbacks_.shared( actions );
+  tools::SerializedMessage serialized;
   for_each( const message_actions::MessageAction& action, actions )
   {
-    callbacks_[action]( msg_, camera_info_ );
+    NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
+    if ( !serialize_once || !serialized_callbacks_.call( action, *msg_, msg_->header.stamp, serialized, camera_info_ ) )
+    {
+      callbacks_[action]( msg_, camera_info_ );
+    }
   }
 }
 
@@ -22,6 +22,7 @@
 * LOCAL includes
 */
 #include "converter_base.hpp"
+#include "serialized_callbacks.hpp"
 #include <naoqi_driver/message_actions.h>
 
 /*
@@ -34,11 +35,14 @@ namespace naoqi
 namespace converter
 {
 
-class CameraConverter : public BaseConverter<CameraConverter>
+class CameraConverter : public BaseConverter<CameraConverter>, public AsyncConverter
 {
 
   typedef boost::function<void(sensor_msgs::ImagePtr, sensor_msgs::CameraInfo)> Callback_t;
 
+  typedef SerializedCallbacks<sensor_msgs::Image,
+    boost::function<void(const tools::SerializedMessage&, const ros::Time&, const sensor_msgs::CameraInfo&)> > SerializedCallbacks_t;
+
 public:
   CameraConverter( const std::string& name, const float& frequency, const qi::SessionPtr& session, const int& camera_source, const int& resolution );
 
@@ -48,13 +52,21 @@ public:
 
   void registerCallback( const message_actions::MessageAction action, Callback_t cb );
 
+  /** Register a callback taking the image serialized, used instead of the other one when it goes to several actions */
+  void registerSerializedCallback( const message_actions::MessageAction action, SerializedCallbacks_t::Callback_t cb );
+
   void callAll( const std::vector<message_actions::MessageAction>& actions );
 
+  qi::Future<qi::AnyValue> fetch();
+
+  void convert( const std::vector<message_actions::MessageAction>& actions, qi::AnyValue& data );
+
 private:
   std::map<message_actions::MessageAction, Callback_t> callbacks_;
+  SerializedCallbacks_t serialized_callbacks_;
 
   /** VideoDevice (Proxy) configurations */
-  qi::AnyObject p_video_;
+  tools::InstrumentedObject p_video_;
   int camera_source_;
   int resolution_;
   int colorspace_;
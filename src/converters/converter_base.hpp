@@ -23,6 +23,8 @@
 */
 #include <naoqi_driver/tools.hpp>
 #include "../helpers/driver_helpers.hpp"
+#include "../tools/instrumented_object.hpp"
+#include "../tools/trace.hpp"
 
 /*
 * ALDEBARAN includes
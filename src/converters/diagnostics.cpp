@@ -53,13 +53,13 @@ namespace converter
 
 DiagnosticsConverter::DiagnosticsConverter( const std::string& name, float frequency, const qi::SessionPtr& session ):
     BaseConverter( name, frequency, session ),
-    p_memory_(session->service("ALMemory")),
+    p_memory_( session->service("ALMemory"), "ALMemory" ),
     temperature_warn_level_(68),
     temperature_error_level_(74)
 {
   // Allow for temperature reporting (for CPU)
   if ((robot_ == robot::PEPPER) || (robot_ == robot::NAO)) {
-    p_body_temperature_ = session->service("ALBodyTemperature");
+    p_body_temperature_ = tools::InstrumentedObject( session->service("ALBodyTemperature"), "ALBodyTemperature" );
     p_body_temperature_.call<void>("setEnableNotifications", true);
   }
 
@@ -90,14 +90,28 @@ DiagnosticsConverter::DiagnosticsConverter( const std::string& name, float frequ
 
 void DiagnosticsConverter::callAll( const std::vector<message_actions::MessageAction>& actions )
 {
-  diagnostic_msgs::DiagnosticArray msg;
-  msg.header.stamp = ros::Time::now();
+  try {
+    qi::AnyValue anyvalues = fetch().value();
+    convert(actions, anyvalues);
+  } catch (const std::exception& e) {
+    std::cerr << "Exception caught in DiagnosticsConverter: " << e.what() << std::endl;
+  }
+}
 
+qi::Future<qi::AnyValue> DiagnosticsConverter::fetch()
+{
   // Get all the keys
   //qi::details::printMetaObject(std::cout, p_memory_.metaObject());
+  return p_memory_.async<qi::AnyValue>("getListData", all_keys_);
+}
+
+void DiagnosticsConverter::convert( const std::vector<message_actions::MessageAction>& actions, qi::AnyValue& anyvalues )
+{
+  diagnostic_msgs::DiagnosticArray msg;
+  msg.header.stamp = ros::Time::now();
+
   std::vector<float> values;
   try {
-      qi::AnyValue anyvalues = p_memory_.call<qi::AnyValue>("getListData", all_keys_);
       tools::fromAnyValueToFloatVector(anyvalues, values);
   } catch (const std::exception& e) {
     std::cerr << "Exception caught in DiagnosticsConverter: " << e.what() << std::endl;
@@ -262,6 +276,7 @@ void DiagnosticsConverter::callAll( const std::vector<message_actions::MessageAc
 
   for_each( message_actions::MessageAction action, actions )
   {
+    NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
     callbacks_[action]( msg);
   }
 
@@ -39,7 +39,7 @@ namespace converter
  * It does not use the DiagnostricsUpdater for optimization.
  * A full diagnostic_msgs/DiagnosticArray is built and sent to requesting nodes
  */
-class DiagnosticsConverter : public BaseConverter<DiagnosticsConverter>
+class DiagnosticsConverter : public BaseConverter<DiagnosticsConverter>, public AsyncConverter
 {
 
   typedef boost::function<void(diagnostic_msgs::DiagnosticArray&) > Callback_t;
@@ -51,6 +51,10 @@ public:
 
   void callAll( const std::vector<message_actions::MessageAction>& actions );
 
+  qi::Future<qi::AnyValue> fetch();
+
+  void convert( const std::vector<message_actions::MessageAction>& actions, qi::AnyValue& data );
+
   void registerCallback( const message_actions::MessageAction action, Callback_t cb );
 
 private:
@@ -62,9 +66,9 @@ private:
   std::vector<std::string> battery_status_keys_;
 
   /** Proxy to ALMemory */
-  qi::AnyObject p_memory_;
+  tools::InstrumentedObject p_memory_;
   /** Proxy to ALBodyTemperature */
-  qi::AnyObject p_body_temperature_;
+  tools::InstrumentedObject p_body_temperature_;
 
   float temperature_warn_level_;
   float temperature_error_level_;
@@ -40,7 +40,7 @@ namespace converter {
 
   ImuConverter::ImuConverter(const std::string& name, const IMU::Location& location,  const float& frequency, const qi::SessionPtr& session):
     BaseConverter(name, frequency, session),
-    p_memory_(session->service("ALMemory"))
+    p_memory_( session->service("ALMemory"), "ALMemory" )
   {
     if(location == IMU::TORSO){
       msg_imu_.header.frame_id = "base_link";
@@ -85,13 +85,32 @@ namespace converter {
     callbacks_[action] = cb;
   }
 
+  void ImuConverter::registerSerializedCallback( const message_actions::MessageAction action, SerializedCallbacks<sensor_msgs::Imu>::Callback_t cb )
+  {
+    serialized_callbacks_.registerCallback( action, cb );
+  }
+
   void ImuConverter::callAll(const std::vector<message_actions::MessageAction>& actions)
+  {
+    try {
+      qi::AnyValue data = fetch().value();
+      convert(actions, data);
+    } catch (const std::exception& e) {
+      std::cerr << "Exception caught in ImuConverter: " << e.what() << std::endl;
+    }
+  }
+
+  qi::Future<qi::AnyValue> ImuConverter::fetch()
   {
     // Get inertial data
+    return p_memory_.async<qi::AnyValue>("getListData", data_names_list_);
+  }
+
+  void ImuConverter::convert(const std::vector<message_actions::MessageAction>& actions, qi::AnyValue& data)
+  {
     std::vector<float> memData;
     try {
-        qi::AnyValue anyvalues = p_memory_.call<qi::AnyValue>("getListData", data_names_list_);
-        tools::fromAnyValueToFloatVector(anyvalues, memData);
+        tools::fromAnyValueToFloatVector(data, memData);
     } catch (const std::exception& e) {
       std::cerr << "Exception caught in ImuConverter: " << e.what() << std::endl;
       return;
@@ -126,9 +145,16 @@ namespace converter {
     msg_imu_.linear_acceleration_covariance[0] = -1;
 
 
+    // serialized once when the message is published, recorded and buffered at the same tick
+    const bool serialize_once = serialized_callbacks_.shared( actions );
+    tools::SerializedMessage serialized;
     for_each( message_actions::MessageAction action, actions )
     {
-      callbacks_[action]( msg_imu_ );
+      NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
+      if ( !serialize_once || !serialized_callbacks_.call( action, msg_imu_, msg_imu_.header.stamp, serialized ) )
+      {
+        callbacks_[action]( msg_imu_ );
+      }
     }
   }
 
@@ -22,6 +22,7 @@
 * LOCAL includes
 */
 #include "converter_base.hpp"
+#include "serialized_callbacks.hpp"
 #include <naoqi_driver/message_actions.h>
 
 /*
@@ -42,7 +43,7 @@ enum Location{
 
 }
 
-class ImuConverter : public BaseConverter<ImuConverter>
+class ImuConverter : public BaseConverter<ImuConverter>, public AsyncConverter
 {
 
   typedef boost::function<void(sensor_msgs::Imu&) > Callback_t;
@@ -56,15 +57,23 @@ public:
 
   void registerCallback( const message_actions::MessageAction action, Callback_t cb );
 
+  /** Register a callback taking the IMU message serialized, used instead of the other one when it goes to several actions */
+  void registerSerializedCallback( const message_actions::MessageAction action, SerializedCallbacks<sensor_msgs::Imu>::Callback_t cb );
+
   virtual void callAll(const std::vector<message_actions::MessageAction>& actions);
 
+  qi::Future<qi::AnyValue> fetch();
+
+  void convert(const std::vector<message_actions::MessageAction>& actions, qi::AnyValue& data);
+
 private:
   sensor_msgs::Imu msg_imu_;
-  qi::AnyObject p_memory_;
+  tools::InstrumentedObject p_memory_;
   std::vector<std::string> data_names_list_;
 
   /** Registered Callbacks **/
   std::map<message_actions::MessageAction, Callback_t> callbacks_;
+  SerializedCallbacks<sensor_msgs::Imu> serialized_callbacks_;
 };
 
 }
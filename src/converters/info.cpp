@@ -35,7 +35,7 @@ namespace converter
 
 InfoConverter::InfoConverter( const std::string& name, float frequency, const qi::SessionPtr& session )
   : BaseConverter( name, frequency, session ),
-    p_memory_( session->service("ALMemory") )
+    p_memory_( session->service("ALMemory"), "ALMemory" )
 {
   keys_.push_back("RobotConfig/Head/FullHeadId");
   keys_.push_back("Device/DeviceList/ChestBoard/BodyId");
@@ -88,6 +88,7 @@ void InfoConverter::callAll( const std::vector<message_actions::MessageAction>&
   }
   for_each( const message_actions::MessageAction& action, actions )
   {
+    NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
     callbacks_[action](msg);
   }
 }
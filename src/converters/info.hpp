@@ -51,7 +51,7 @@ public:
 
 private:
   /** Memory (Proxy) configurations */
-  qi::AnyObject p_memory_;
+  tools::InstrumentedObject p_memory_;
 
   /** The keys to get from ALMemory */
   std::vector<std::string> keys_;
@@ -42,10 +42,11 @@ namespace converter
 
 JointStateConverter::JointStateConverter( const std::string& name, const float& frequency, const BufferPtr& tf2_buffer, const qi::SessionPtr& session ):
   BaseConverter( name, frequency, session ),
-  p_motion_( session->service("ALMotion") ),
+  p_motion_( session->service("ALMotion"), "ALMotion" ),
   tf2_buffer_(tf2_buffer)
 {
   robot_desc_ = tools::getRobotDescription( robot_ );
+  joint_states_ = boost::make_shared<tools::MessagePool<sensor_msgs::JointState> >( msg_joint_states_, 2 );
 }
 
 JointStateConverter::~JointStateConverter()
@@ -76,6 +77,7 @@ void JointStateConverter::reset()
   }
   // pre-fill joint states message
   msg_joint_states_.name = p_motion_.call<std::vector<std::string> >("getBodyNames", "Body" );
+  joint_states_ = boost::make_shared<tools::MessagePool<sensor_msgs::JointState> >( msg_joint_states_, 2 );
 }
 
 void JointStateConverter::registerCallback( const message_actions::MessageAction action, Callback_t cb )
@@ -83,19 +85,44 @@ void JointStateConverter::registerCallback( const message_actions::MessageAction
   callbacks_[action] = cb;
 }
 
+void JointStateConverter::registerSharedCallback( const message_actions::MessageAction action, SharedCallback_t cb )
+{
+  shared_callbacks_[action] = cb;
+}
+
+void JointStateConverter::registerSerializedCallback( const message_actions::MessageAction action, SerializedCallbacks_t::Callback_t cb )
+{
+  serialized_callbacks_.registerCallback( action, cb );
+}
+
 void JointStateConverter::callAll( const std::vector<message_actions::MessageAction>& actions )
 {
   // get joint state values
   std::vector<double> al_joint_angles = p_motion_.call<std::vector<double> >("getAngles", "Body", true );
   const ros::Time& stamp = ros::Time::now();
 
+  /*
+   * can be called via getRobotPosture
+   * but this would require a proper URDF 
+   * with a base_link and base_footprint in the base
+   */
+  std::vector<float> al_odometry_data = p_motion_.call<std::vector<float> >( "getPosition", "Torso", 1, true );
+  const ros::Time& odom_stamp = ros::Time::now();
+
+  convert( actions, al_joint_angles, stamp, al_odometry_data, odom_stamp );
+}
+
+void JointStateConverter::convert( const std::vector<message_actions::MessageAction>& actions,
+                                   const std::vector<double>& al_joint_angles, const ros::Time& stamp,
+                                   const std::vector<float>& al_odometry_data, const ros::Time& odom_stamp )
+{
   /**
    * JOINT STATE PUBLISHER
    */
-  msg_joint_states_.header.stamp = stamp;
-
-  // STUPID CONVERTION FROM FLOAT TO DOUBLE ARRAY --> OPTIMIZE THAT!
-  msg_joint_states_.position = std::vector<double>( al_joint_angles.begin(), al_joint_angles.end() );
+  // a message still held by a subscriber in the same process is left as it is
+  const boost::shared_ptr<sensor_msgs::JointState> msg_joint_states = joint_states_->acquire();
+  msg_joint_states->header.stamp = stamp;
+  msg_joint_states->position.assign( al_joint_angles.begin(), al_joint_angles.end() );
 
   /**
    * ROBOT STATE PUBLISHER
@@ -106,9 +133,9 @@ void JointStateConverter::callAll( const std::vector<message_actions::MessageAct
 //  std::transform( msg_joint_states_.name.begin(), msg_joint_states_.name.end(), msg_joint_states_.position.begin(),
 //                  std::inserter( joint_state_map, joint_state_map.end() ),
 //                  std::make_pair);
-  std::vector<double>::const_iterator itPos = msg_joint_states_.position.begin();
-  for(std::vector<std::string>::const_iterator itName = msg_joint_states_.name.begin();
-      itName != msg_joint_states_.name.end();
+  std::vector<double>::const_iterator itPos = msg_joint_states->position.begin();
+  for(std::vector<std::string>::const_iterator itName = msg_joint_states->name.begin();
+      itName != msg_joint_states->name.end();
       ++itName, ++itPos)
   {
     joint_state_map[*itName] = *itPos;
@@ -131,14 +158,6 @@ void JointStateConverter::callAll( const std::vector<message_actions::MessageAct
   /**
    * ODOMETRY
    */
-
-  /*
-   * can be called via getRobotPosture
-   * but this would require a proper URDF 
-   * with a base_link and base_footprint in the base
-   */
-  std::vector<float> al_odometry_data = p_motion_.call<std::vector<float> >( "getPosition", "Torso", 1, true );
-  const ros::Time& odom_stamp = ros::Time::now();
   const float& odomX  =  al_odometry_data[0];
   const float& odomY  =  al_odometry_data[1];
   const float& odomZ  =  al_odometry_data[2];
@@ -174,13 +193,34 @@ void JointStateConverter::callAll( const std::vector<message_actions::MessageAct
     tf2_buffer_.reset();
   }
 
+  // serialized once when the joint states are recorded and buffered at the same tick
+  const bool serialize_once = serialized_callbacks_.shared( actions );
+  tools::SerializedMessage serialized;
   for_each( message_actions::MessageAction action, actions )
   {
-    callbacks_[action]( msg_joint_states_, tf_transforms_ );
+    NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
+    std::map<message_actions::MessageAction, SharedCallback_t>::const_iterator shared = shared_callbacks_.find(action);
+    if ( shared != shared_callbacks_.end() )
+    {
+      shared->second( msg_joint_states, tf_transforms_ );
+    }
+    else if ( !serialize_once || !serialized_callbacks_.call( action, *msg_joint_states, msg_joint_states->header.stamp, serialized, tf_transforms_ ) )
+    {
+      callbacks_[action]( *msg_joint_states, tf_transforms_ );
+    }
   }
 }
 
 
+std::set<std::string> JointStateConverter::fixedFrames() const
+{
+  std::set<std::string> frames;
+  for (std::map<std::string, robot_state_publisher::SegmentPair>::const_iterator seg=segments_fixed_.begin(); seg != segments_fixed_.end(); seg++){
+    frames.insert(seg->second.tip);
+  }
+  return frames;
+}
+
 // Copied from robot state publisher
 void JointStateConverter::setTransforms(const std::map<std::string, double>& joint_positions, const ros::Time& time, const std::string& tf_prefix)
 {
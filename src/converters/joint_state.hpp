@@ -22,9 +22,16 @@
 * LOCAL includes
 */
 #include "converter_base.hpp"
+#include "serialized_callbacks.hpp"
+#include "../tools/message_pool.hpp"
 #include "../tools/robot_description.hpp"
 #include <naoqi_driver/message_actions.h>
 
+/*
+* STANDARD includes
+*/
+#include <set>
+
 /*
 * ROS includes
 */
@@ -42,6 +49,11 @@ class JointStateConverter : public BaseConverter<JointStateConverter>
 
   typedef boost::function<void(sensor_msgs::JointState&, std::vector<geometry_msgs::TransformStamped>&) > Callback_t;
 
+  typedef boost::function<void(const boost::shared_ptr<const sensor_msgs::JointState>&, std::vector<geometry_msgs::TransformStamped>&) > SharedCallback_t;
+
+  typedef SerializedCallbacks<sensor_msgs::JointState,
+    boost::function<void(const tools::SerializedMessage&, const ros::Time&, const std::vector<geometry_msgs::TransformStamped>&)> > SerializedCallbacks_t;
+
   typedef boost::shared_ptr<tf2_ros::Buffer> BufferPtr;
 
   typedef std::map<std::string, boost::shared_ptr<urdf::JointMimic> > MimicMap;
@@ -55,8 +67,26 @@ public:
 
   void registerCallback( const message_actions::MessageAction action, Callback_t cb );
 
+  /** Register a callback taking the joint states themselves rather than a reference, it replaces the other one for this action */
+  void registerSharedCallback( const message_actions::MessageAction action, SharedCallback_t cb );
+
+  /** Register a callback taking the joint states serialized, used instead of the plain one when they go to several actions */
+  void registerSerializedCallback( const message_actions::MessageAction action, SerializedCallbacks_t::Callback_t cb );
+
   void callAll( const std::vector<message_actions::MessageAction>& actions );
 
+  /** Child frames of the fixed segments of the robot description, known once the converter is reset */
+  std::set<std::string> fixedFrames() const;
+
+  /**
+  * @brief Build the joint states and the transforms from the data given by ALMotion, then dispatch them
+  * @param al_joint_angles angles of the joints, in the order of getBodyNames("Body")
+  * @param al_odometry_data position of the torso in the world frame (x, y, z, wx, wy, wz)
+  */
+  void convert( const std::vector<message_actions::MessageAction>& actions,
+                const std::vector<double>& al_joint_angles, const ros::Time& stamp,
+                const std::vector<float>& al_odometry_data, const ros::Time& odom_stamp );
+
 private:
 
   /** blatently copied from robot state publisher */
@@ -69,10 +99,12 @@ private:
   BufferPtr tf2_buffer_;
 
   /** Motion Proxy **/
-  qi::AnyObject p_motion_;
+  tools::InstrumentedObject p_motion_;
 
   /** Registered Callbacks **/
   std::map<message_actions::MessageAction, Callback_t> callbacks_;
+  std::map<message_actions::MessageAction, SharedCallback_t> shared_callbacks_;
+  SerializedCallbacks_t serialized_callbacks_;
 
   /** Robot Description in xml format **/
   std::string robot_desc_;
@@ -80,9 +112,12 @@ private:
   /** MimicJoint List **/
   MimicMap mimic_;
 
-  /** JointState Message **/
+  /** JointState Message, prototype of the pool **/
   sensor_msgs::JointState msg_joint_states_;
 
+  /** JointState Messages shared with the publisher, a message is only refilled once nobody holds it **/
+  boost::shared_ptr<tools::MessagePool<sensor_msgs::JointState> > joint_states_;
+
   /** Transform Messages **/
   std::vector<geometry_msgs::TransformStamped> tf_transforms_;
 
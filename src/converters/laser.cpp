@@ -130,7 +130,7 @@ static const char* laserMemoryKeys[] = {
 
 LaserConverter::LaserConverter( const std::string& name, const float& frequency, const qi::SessionPtr& session ):
   BaseConverter( name, frequency, session ),
-  p_memory_(session->service("ALMemory"))
+  p_memory_( session->service("ALMemory"), "ALMemory" )
 {
 }
 
@@ -139,14 +139,33 @@ void LaserConverter::registerCallback( message_actions::MessageAction action, Ca
   callbacks_[action] = cb;
 }
 
+void LaserConverter::registerSerializedCallback( message_actions::MessageAction action, SerializedCallbacks<sensor_msgs::LaserScan>::Callback_t cb )
+{
+  serialized_callbacks_.registerCallback( action, cb );
+}
+
 void LaserConverter::callAll( const std::vector<message_actions::MessageAction>& actions )
+{
+  try {
+      qi::AnyValue data = fetch().value();
+      convert( actions, data );
+  } catch (const std::exception& e) {
+    std::cerr << "Exception caught in LaserConverter: " << e.what() << std::endl;
+  }
+}
+
+qi::Future<qi::AnyValue> LaserConverter::fetch()
 {
   static const std::vector<std::string> laser_keys_value(laserMemoryKeys, laserMemoryKeys+90);
 
+  return p_memory_.async<qi::AnyValue>("getListData", laser_keys_value);
+}
+
+void LaserConverter::convert( const std::vector<message_actions::MessageAction>& actions, qi::AnyValue& data )
+{
   std::vector<float> result_value;
   try {
-      qi::AnyValue anyvalues = p_memory_.call<qi::AnyValue>("getListData", laser_keys_value);
-      tools::fromAnyValueToFloatVector(anyvalues, result_value);
+      tools::fromAnyValueToFloatVector(data, result_value);
   } catch (const std::exception& e) {
     std::cerr << "Exception caught in LaserConverter: " << e.what() << std::endl;
     return;
@@ -204,9 +223,16 @@ void LaserConverter::callAll( const std::vector<message_actions::MessageAction>&
     msg_.ranges[pos] = dist;
   }
 
+  // serialized once when the scan is published, recorded and buffered at the same tick
+  const bool serialize_once = serialized_callbacks_.shared( actions );
+  tools::SerializedMessage serialized;
   for_each( message_actions::MessageAction action, actions )
   {
-    callbacks_[action](msg_);
+    NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
+    if ( !serialize_once || !serialized_callbacks_.call( action, msg_, msg_.header.stamp, serialized ) )
+    {
+      callbacks_[action](msg_);
+    }
   }
 }
 
@@ -22,6 +22,7 @@
 * LOCAL includes
 */
 #include "converter_base.hpp"
+#include "serialized_callbacks.hpp"
 #include <naoqi_driver/message_actions.h>
 
 /*
@@ -34,7 +35,7 @@ namespace naoqi
 namespace converter
 {
 
-class LaserConverter : public BaseConverter<LaserConverter>
+class LaserConverter : public BaseConverter<LaserConverter>, public AsyncConverter
 {
 
   typedef boost::function<void(sensor_msgs::LaserScan&)> Callback_t;
@@ -44,15 +45,23 @@ public:
 
   void registerCallback( message_actions::MessageAction action, Callback_t cb );
 
+  /** Register a callback taking the scan serialized, used instead of the other one when the scan goes to several actions */
+  void registerSerializedCallback( message_actions::MessageAction action, SerializedCallbacks<sensor_msgs::LaserScan>::Callback_t cb );
+
   void callAll( const std::vector<message_actions::MessageAction>& actions );
 
+  qi::Future<qi::AnyValue> fetch();
+
+  void convert( const std::vector<message_actions::MessageAction>& actions, qi::AnyValue& data );
+
   void reset( );
 
 private:
 
-  qi::AnyObject p_memory_;
+  tools::InstrumentedObject p_memory_;
 
   std::map<message_actions::MessageAction, Callback_t> callbacks_;
+  SerializedCallbacks<sensor_msgs::LaserScan> serialized_callbacks_;
   sensor_msgs::LaserScan msg_;
 }; // class
 
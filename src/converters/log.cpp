@@ -16,15 +16,21 @@
 */
 
 #include "log.hpp"
+#include "../tools/mpsc_ring.hpp"
+#include <naoqi_driver/tools.hpp>
 
 #include <qicore/logmessage.hpp>
-#include <queue>
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
 
 #include <std_msgs/String.h>
 
-#include <boost/algorithm/string.hpp>
-#include <boost/thread/mutex.hpp>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
 
 #include <ros/console.h>
 
@@ -35,96 +41,126 @@ namespace naoqi
 namespace converter
 {
 
-/** mutex to change the logs list */
-boost::mutex MUTEX_LOGS;
-/** list of ogs in which the NAOqi callback will write its logs */
-std::queue<rosgraph_msgs::Log> LOGS;
-/** Generic Log Level used to store all the correspondences between the libqi and ROS log levels */
-class LogLevel
+/** A libqi log as it was received, it is only turned into a ROS log on the publish side */
+struct LogRecord
 {
-public:
-  LogLevel(qi::LogLevel qi, rosgraph_msgs::Log::_level_type ros_msg, ros::console::levels::Level ros_console) :
-      qi_(qi), ros_msg_(ros_msg), ros_console_(ros_console)
-  {
-    all_.push_back(*this);
-  }
+  qi::LogLevel level;
+  qi::os::timeval timestamp;
+  std::string source;
+  std::string category;
+  std::string message;
+};
+
+/** logs written by the NAOqi callback, read by the converter; the strings of a slot keep their capacity */
+tools::MpscRing<LogRecord> LOGS( 1024 );
+/** logs received from libqi, and dropped because the converter was behind */
+boost::atomic<boost::uint64_t> LOGS_RECEIVED( 0 );
+boost::atomic<boost::uint64_t> LOGS_DROPPED( 0 );
+/** logs stopped by the filter of the converter, because of their category or of its rate limit */
+boost::atomic<boost::uint64_t> LOGS_FILTERED( 0 );
+boost::atomic<boost::uint64_t> LOGS_SUPPRESSED( 0 );
 
-  static const LogLevel& get_from_qi(qi::LogLevel qi)
+/** ROS level of each libqi level, indexed by qi::LogLevel */
+const rosgraph_msgs::Log::_level_type ROS_LEVELS[] =
+{
+  rosgraph_msgs::Log::DEBUG, // Silent
+  rosgraph_msgs::Log::FATAL,
+  rosgraph_msgs::Log::ERROR,
+  rosgraph_msgs::Log::WARN,
+  rosgraph_msgs::Log::INFO,
+  rosgraph_msgs::Log::DEBUG, // Verbose
+  rosgraph_msgs::Log::DEBUG
+};
+
+inline rosgraph_msgs::Log::_level_type rosLevel( qi::LogLevel level )
+{
+  const size_t index = static_cast<size_t>( level );
+  return index < sizeof(ROS_LEVELS)/sizeof(ROS_LEVELS[0]) ? ROS_LEVELS[index] : rosgraph_msgs::Log::DEBUG;
+}
+
+/** libqi level matching a level of the ROS console */
+inline qi::LogLevel qiLevel( ros::console::levels::Level level )
+{
+  switch ( level )
   {
-    for_each(const LogLevel& log_level, all_)
-      if (log_level.qi_ == qi)
-        return log_level;
+  case ros::console::levels::Debug: return qi::LogLevel_Debug;
+  case ros::console::levels::Info: return qi::LogLevel_Info;
+  case ros::console::levels::Warn: return qi::LogLevel_Warning;
+  case ros::console::levels::Error: return qi::LogLevel_Error;
+  case ros::console::levels::Fatal: return qi::LogLevel_Fatal;
+  default: return qi::LogLevel_Info;
   }
+}
 
-  static const LogLevel& get_from_ros_msg(rosgraph_msgs::Log::_level_type ros_msg)
+/** Turn a record into a ROS log, reusing the strings of log */
+void toRos( const LogRecord& record, rosgraph_msgs::Log& log )
+{
+  // source is file:function:line
+  const std::string& source = record.source;
+  const size_t file_end = source.find( ':' );
+  const size_t function_end = file_end == std::string::npos ? std::string::npos : source.find( ':', file_end + 1 );
+  log.file.assign( source, 0, file_end );
+  if ( file_end != std::string::npos )
   {
-    for_each(const LogLevel& log_level, all_)
-      if (log_level.ros_msg_ == ros_msg)
-        return log_level;
+    log.function.assign( source, file_end + 1, function_end == std::string::npos ? std::string::npos : function_end - file_end - 1 );
   }
-
-  static const LogLevel& get_from_ros_console(ros::console::levels::Level ros_console)
+  else
   {
-    for_each(const LogLevel& log_level, all_)
-      if (log_level.ros_console_ == ros_console)
-        return log_level;
+    log.function.clear();
   }
+  log.line = function_end == std::string::npos ? 0 : std::atoi( source.c_str() + function_end + 1 );
+  log.level = rosLevel( record.level );
+  log.name = record.category;
+  log.msg = record.message;
+  log.header.stamp = ros::Time( record.timestamp.tv_sec, record.timestamp.tv_usec * 1000 );
+}
 
-  qi::LogLevel qi_;
-  rosgraph_msgs::Log::_level_type ros_msg_;
-  ros::console::levels::Level ros_console_;
-
-private:
-  static std::vector<LogLevel> all_;
-};
-
-std::vector<LogLevel> LogLevel::all_ = std::vector<LogLevel>();
-
-/** Callback called for each libqi log message
+/** Callback called for each libqi log message, on the logging thread of libqi: it only filters the log then copies it in a slot
  */
-void logCallback(const qi::LogMessage& msg)
-{
-  // Convert the NAOqi log to a ROS log
-  rosgraph_msgs::Log log;
-
-  std::vector<std::string> results;
-  boost::split(results, msg.source, boost::is_any_of(":"));
-  log.file = results[0];
-  log.function = results[1];
-  log.line = atoi(results[2].c_str());
-  log.level = LogLevel::get_from_qi(msg.level).ros_msg_;
-  log.name = msg.category;
-  log.msg = msg.message;
-  log.header.stamp = ros::Time(msg.timestamp.tv_sec, msg.timestamp.tv_usec);
-
-  // If we are not publishing, the queue will increase, so we have to prevent an explosion
-  // We only keep a log if it's within 5 second of the last publish (totally arbitrary)
-  boost::mutex::scoped_lock lock( MUTEX_LOGS );
-  while (LOGS.size() > 1000)
+void logCallback(const qi::LogMessage& msg, const boost::shared_ptr<tools::LogFilter>& filter)
+{
+  ++LOGS_RECEIVED;
+  const tools::LogFilter::Decision decision = filter->process( msg.category, ros::WallTime::now().toSec() );
+  if ( decision != tools::LogFilter::PASS )
   {
-    LOGS.pop();
+    // the suppressed logs are also counted per category by the filter, for the summary of the converter
+    if ( decision == tools::LogFilter::FILTERED )
+    {
+      ++LOGS_FILTERED;
+    }
+    else
+    {
+      ++LOGS_SUPPRESSED;
+    }
+    return;
+  }
+  boost::uint64_t ticket;
+  LogRecord* record = LOGS.claim( ticket );
+  if ( record == NULL )
+  {
+    // the converter does not keep up, e.g. when nobody publishes: the newest logs are dropped and counted,
+    // the oldest ones it left in the ring are discarded when it resumes
+    ++LOGS_DROPPED;
+    return;
   }
-  LOGS.push(log);
+  record->level = msg.level;
+  record->timestamp = msg.timestamp;
+  record->source = msg.source;
+  record->category = msg.category;
+  record->message = msg.message;
+  LOGS.commit( ticket );
 }
 
-LogConverter::LogConverter( const std::string& name, float frequency, const qi::SessionPtr& session )
+LogConverter::LogConverter( const std::string& name, float frequency, const qi::SessionPtr& session, const tools::LogFilterConfig& filter )
   : BaseConverter( name, frequency, session ),
     logger_( session->service("LogManager") ),
     // Default log level is info
-    log_level_(qi::LogLevel_Info)
+    log_level_(qi::LogLevel_Info),
+    filter_( boost::make_shared<tools::LogFilter>( filter ) )
 {
-  // Define the log equivalents
-  LogLevel(qi::LogLevel_Silent, rosgraph_msgs::Log::DEBUG, ros::console::levels::Debug);
-  LogLevel(qi::LogLevel_Fatal, rosgraph_msgs::Log::FATAL, ros::console::levels::Fatal);
-  LogLevel(qi::LogLevel_Error, rosgraph_msgs::Log::ERROR, ros::console::levels::Error);
-  LogLevel(qi::LogLevel_Warning, rosgraph_msgs::Log::WARN, ros::console::levels::Warn);
-  LogLevel(qi::LogLevel_Info, rosgraph_msgs::Log::INFO, ros::console::levels::Info);
-  LogLevel(qi::LogLevel_Verbose, rosgraph_msgs::Log::DEBUG, ros::console::levels::Debug);
-  LogLevel(qi::LogLevel_Debug, rosgraph_msgs::Log::DEBUG, ros::console::levels::Debug);
-
   listener_ = logger_->getListener();
   set_qi_logger_level();
-  listener_->onLogMessage.connect(logCallback);
+  listener_->onLogMessage.connect( boost::function<void (const qi::LogMessage&)>( boost::bind( &logCallback, _1, filter_ ) ) );
 }
 
 void LogConverter::registerCallback( const message_actions::MessageAction action, Callback_t cb )
@@ -134,16 +170,54 @@ void LogConverter::registerCallback( const message_actions::MessageAction action
 
 void LogConverter::callAll( const std::vector<message_actions::MessageAction>& actions )
 {
-  while ( !LOGS.empty() )
+  // after a pause, e.g. nobody wanted the logs, the ring is full of logs of the beginning of the pause:
+  // they are dropped instead of flooding /rosout with stale logs, only the ones of the last period are kept
+  const ros::WallTime now = ros::WallTime::now();
+  if ( frequency_ > 0 && !last_call_.isZero() && now - last_call_ > ros::WallDuration( 2.0 / frequency_ ) )
+  {
+    const ros::WallTime oldest = now - ros::WallDuration( 1.0 / frequency_ );
+    while ( const LogRecord* record = LOGS.front() )
+    {
+      if ( ros::WallTime( record->timestamp.tv_sec, record->timestamp.tv_usec * 1000 ) >= oldest )
+      {
+        break;
+      }
+      LOGS.pop();
+      ++LOGS_DROPPED;
+    }
+  }
+  last_call_ = now;
+
+  // the slot is given back before the callbacks, so that the logging thread can reuse it right away
+  while ( const LogRecord* record = LOGS.front() )
   {
-    rosgraph_msgs::Log& log_msg = LOGS.front();
+    toRos( *record, log_msg_ );
+    LOGS.pop();
     for_each( const message_actions::MessageAction& action, actions)
     {
-      callbacks_[action](log_msg);
+      NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
+      callbacks_[action](log_msg_);
     }
+  }
+
+  // one line per category that went over its rate limit since the last call
+  suppressed_.clear();
+  filter_->takeSuppressed( suppressed_ );
+  for ( size_t i=0; i<suppressed_.size(); ++i )
+  {
+    std::ostringstream summary;
+    summary << suppressed_[i].second << " messages suppressed";
+    log_msg_.header.stamp = ros::Time::now();
+    log_msg_.level = rosgraph_msgs::Log::WARN;
+    log_msg_.name = suppressed_[i].first;
+    log_msg_.msg = summary.str();
+    log_msg_.file.clear();
+    log_msg_.function.clear();
+    log_msg_.line = 0;
+    for_each( const message_actions::MessageAction& action, actions)
     {
-      boost::mutex::scoped_lock lock( MUTEX_LOGS );
-      LOGS.pop();
+      NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
+      callbacks_[action](log_msg_);
     }
   }
   set_qi_logger_level();
@@ -153,6 +227,71 @@ void LogConverter::reset( )
 {
 }
 
+boost::uint64_t LogConverter::receivedLogs()
+{
+  return LOGS_RECEIVED;
+}
+
+boost::uint64_t LogConverter::droppedLogs()
+{
+  return LOGS_DROPPED;
+}
+
+size_t LogConverter::pendingLogs()
+{
+  return LOGS.size();
+}
+
+boost::uint64_t LogConverter::filteredLogs()
+{
+  return LOGS_FILTERED;
+}
+
+boost::uint64_t LogConverter::suppressedLogs()
+{
+  return LOGS_SUPPRESSED;
+}
+
+tools::LogFilterConfig LogConverter::readFilter( const boost::property_tree::ptree& config )
+{
+  tools::LogFilterConfig filter;
+  boost::optional<const boost::property_tree::ptree&> allow = config.get_child_optional( "allow" );
+  if ( allow )
+  {
+    for_each( const boost::property_tree::ptree::value_type& glob, *allow )
+    {
+      filter.allow.push_back( glob.second.get_value<std::string>() );
+    }
+  }
+  boost::optional<const boost::property_tree::ptree&> deny = config.get_child_optional( "deny" );
+  if ( deny )
+  {
+    for_each( const boost::property_tree::ptree::value_type& glob, *deny )
+    {
+      filter.deny.push_back( glob.second.get_value<std::string>() );
+    }
+  }
+  boost::optional<const boost::property_tree::ptree&> rate_limits = config.get_child_optional( "rate_limits" );
+  if ( rate_limits )
+  {
+    for_each( const boost::property_tree::ptree::value_type& limit, *rate_limits )
+    {
+      tools::LogRateLimit rate_limit;
+      rate_limit.category = limit.second.get<std::string>( "category", "*" );
+      rate_limit.rate = limit.second.get( "rate", rate_limit.rate );
+      rate_limit.burst = limit.second.get( "burst", rate_limit.burst );
+      if ( rate_limit.rate <= 0.f || rate_limit.burst < 1.f )
+      {
+        std::cerr << BOLDRED << "Log rate limit of " << rate_limit.category << ": the rate must be positive and the burst at least 1"
+                  << RESETCOLOR << std::endl;
+        continue;
+      }
+      filter.rate_limits.push_back( rate_limit );
+    }
+  }
+  return filter;
+}
+
 void LogConverter::set_qi_logger_level( )
 {
   // Check that the log level is above or equal to the current one
@@ -164,7 +303,7 @@ void LogConverter::set_qi_logger_level( )
   if (iter == loggers.end())
     return;
 
-  qi::LogLevel new_level = LogLevel::get_from_ros_console(iter->second).qi_;
+  qi::LogLevel new_level = qiLevel(iter->second);
   // Only change the log level if it has changed (otherwise, there is a flood of warnings)
   if (new_level == log_level_)
       return;
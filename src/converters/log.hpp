@@ -19,13 +19,18 @@
 #define CONVERTERS_LOG_HPP
 
 #include <rosgraph_msgs/Log.h>
+#include <ros/time.h>
 
 #include <naoqi_driver/message_actions.h>
 #include "converter_base.hpp"
+#include "../tools/log_filter.hpp"
 
 #include <qicore/logmanager.hpp>
 #include <qicore/loglistener.hpp>
 
+#include <boost/cstdint.hpp>
+#include <boost/property_tree/ptree.hpp>
+
 namespace naoqi
 {
 namespace converter
@@ -37,7 +42,8 @@ class LogConverter : public BaseConverter<LogConverter>
   typedef boost::function<void(rosgraph_msgs::Log&) > Callback_t;
 
 public:
-  LogConverter( const std::string& name, float frequency, const qi::SessionPtr& sessions );
+  LogConverter( const std::string& name, float frequency, const qi::SessionPtr& sessions,
+                const tools::LogFilterConfig& filter = tools::LogFilterConfig() );
 
   void reset( );
 
@@ -45,6 +51,25 @@ public:
 
   void callAll( const std::vector<message_actions::MessageAction>& actions );
 
+  /** Logs received from libqi since the driver started */
+  static boost::uint64_t receivedLogs();
+
+  /** Logs dropped because the converter was behind: the newest ones when the ring of logs was full,
+   * then the stale ones left in the ring when the converter resumes after a pause */
+  static boost::uint64_t droppedLogs();
+
+  /** Logs waiting for the converter */
+  static size_t pendingLogs();
+
+  /** Logs stopped because their category is denied or not allowed */
+  static boost::uint64_t filteredLogs();
+
+  /** Logs stopped by the rate limit of their category */
+  static boost::uint64_t suppressedLogs();
+
+  /** Read the allow and deny lists and the rate limits of converters.logs in the boot config */
+  static tools::LogFilterConfig readFilter( const boost::property_tree::ptree& config );
+
 private:
   /** Function that sets the NAOqi log level to the ROS one */
   void set_qi_logger_level();
@@ -55,6 +80,13 @@ private:
   qi::LogListenerPtr listener_;
 
   std::map<message_actions::MessageAction, Callback_t> callbacks_;
+  /** reused from log to log, so that its strings keep their capacity */
+  rosgraph_msgs::Log log_msg_;
+  /** shared with the logging callback of libqi */
+  boost::shared_ptr<tools::LogFilter> filter_;
+  std::vector<std::pair<std::string, boost::uint64_t> > suppressed_;
+  /** last time the logs were drained, to tell a pause of the converter */
+  ros::WallTime last_call_;
 };
 
 } //publisher
@@ -34,7 +34,7 @@ namespace converter
 MemoryBoolConverter::MemoryBoolConverter( const std::string& name, const float& frequency, const qi::SessionPtr& session, const std::string& memory_key )
   : BaseConverter( name, frequency, session ),
     memory_key_(memory_key),
-    p_memory_( session->service("ALMemory") )
+    p_memory_( session->service("ALMemory"), "ALMemory" )
 {}
 
 void MemoryBoolConverter::registerCallback( message_actions::MessageAction action, Callback_t cb )
@@ -61,6 +61,7 @@ void MemoryBoolConverter::callAll( const std::vector<message_actions::MessageAct
   if (convert()) {
     for_each( message_actions::MessageAction action, actions )
     {
+      NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
       callbacks_[action]( msg_ );
     }
   }
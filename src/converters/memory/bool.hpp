@@ -55,7 +55,7 @@ private:
   /** Memory key to retrieve data */
   std::string memory_key_;
   /** Memory (Proxy) configurations */
-  qi::AnyObject p_memory_;
+  tools::InstrumentedObject p_memory_;
 
   std::map<message_actions::MessageAction, Callback_t> callbacks_;
   naoqi_bridge_msgs::BoolStamped msg_;
@@ -34,7 +34,7 @@ namespace converter
 MemoryFloatConverter::MemoryFloatConverter( const std::string& name, const float& frequency, const qi::SessionPtr& session, const std::string& memory_key )
   : BaseConverter( name, frequency, session ),
     memory_key_(memory_key),
-    p_memory_( session->service("ALMemory") )
+    p_memory_( session->service("ALMemory"), "ALMemory" )
 {}
 
 void MemoryFloatConverter::registerCallback( message_actions::MessageAction action, Callback_t cb )
@@ -65,6 +65,7 @@ void MemoryFloatConverter::callAll( const std::vector<message_actions::MessageAc
   if (convert()) {
     for_each( message_actions::MessageAction action, actions )
     {
+      NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
       callbacks_[action]( msg_ );
     }
   }
@@ -32,7 +32,7 @@ namespace converter {
 
 MemoryListConverter::MemoryListConverter(const std::vector<std::string>& key_list, const std::string &name, const float &frequency, const qi::SessionPtr &session):
     BaseConverter(name, frequency, session),
-    p_memory_(session->service("ALMemory")),
+    p_memory_( session->service("ALMemory"), "ALMemory" ),
     _key_list(key_list)
 {}
 
@@ -41,9 +41,16 @@ void MemoryListConverter::reset(){
 }
 
 void MemoryListConverter::callAll(const std::vector<message_actions::MessageAction> &actions){
+  qi::AnyValue memData_anyvalue = fetch().value();
+  convert(actions, memData_anyvalue);
+}
+
+qi::Future<qi::AnyValue> MemoryListConverter::fetch(){
   // Get inertial data
-  qi::AnyValue memData_anyvalue = p_memory_.call<qi::AnyValue>("getListData", _key_list);
+  return p_memory_.async<qi::AnyValue>("getListData", _key_list);
+}
 
+void MemoryListConverter::convert(const std::vector<message_actions::MessageAction> &actions, qi::AnyValue &memData_anyvalue){
   // Reset message
   _msg = naoqi_bridge_msgs::MemoryList();
   ros::Time now = ros::Time::now();
@@ -78,6 +85,7 @@ void MemoryListConverter::callAll(const std::vector<message_actions::MessageActi
 
   for_each( message_actions::MessageAction action, actions )
   {
+    NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
     callbacks_[action]( _msg);
   }
 }
@@ -33,7 +33,7 @@ namespace naoqi {
 
 namespace converter {
 
-class MemoryListConverter : public BaseConverter<MemoryListConverter>
+class MemoryListConverter : public BaseConverter<MemoryListConverter>, public AsyncConverter
 {
   typedef boost::function<void(naoqi_bridge_msgs::MemoryList&) > Callback_t;
 
@@ -46,10 +46,14 @@ public:
 
   virtual void callAll(const std::vector<message_actions::MessageAction>& actions );
 
+  qi::Future<qi::AnyValue> fetch();
+
+  void convert(const std::vector<message_actions::MessageAction>& actions, qi::AnyValue& data);
+
 private:
   std::vector<std::string> _key_list;
   naoqi_bridge_msgs::MemoryList _msg;
-  qi::AnyObject p_memory_;
+  tools::InstrumentedObject p_memory_;
   std::vector<std::string> data_names_list_;
 
   /** Registered Callbacks **/
@@ -0,0 +1,192 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+/*
+* LOCAL includes
+*/
+#include "replay.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+/*
+* BOOST includes
+*/
+#include <boost/foreach.hpp>
+#include <boost/make_shared.hpp>
+#define for_each BOOST_FOREACH
+
+/*
+* ROS includes
+*/
+#include <rosbag/query.h>
+
+namespace naoqi
+{
+namespace converter
+{
+
+ReplayClock::ReplayClock( const ros::Time& begin, float speed ):
+  begin_( begin ),
+  speed_( speed ),
+  started_( false )
+{}
+
+void ReplayClock::startIfNeeded()
+{
+  if ( !started_ )
+  {
+    start_ = ros::WallTime::now();
+    started_ = true;
+  }
+}
+
+ros::Time ReplayClock::bagTime()
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  startIfNeeded();
+  if ( isMaxSpeed() )
+  {
+    return ros::TIME_MAX;
+  }
+  return begin_ + ros::Duration( ( ros::WallTime::now() - start_ ).toSec() * speed_ );
+}
+
+ros::WallTime ReplayClock::dueTime( const ros::Time& bag_time )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  startIfNeeded();
+  if ( isMaxSpeed() )
+  {
+    // every message is due as soon as the replay starts
+    return start_;
+  }
+  return start_ + ros::WallDuration( ( bag_time - begin_ ).toSec() / speed_ );
+}
+
+void ReplayClock::record( const std::string& topic, const ros::Time& bag_time, const ros::WallTime& now, size_t bytes )
+{
+  const ros::WallTime due = dueTime( bag_time );
+  const boost::uint64_t late_us = now > due ? ( now - due ).toNSec() / 1000 : 0;
+  boost::mutex::scoped_lock lock( mutex_ );
+  lateness_[topic].add( late_us, bytes, false );
+}
+
+std::vector<std::string> ReplayClock::summary() const
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  const double elapsed = started_ ? ( ros::WallTime::now() - start_ ).toSec() : 0.;
+  std::vector<std::string> lines;
+  for ( std::map<std::string, tools::RpcMethodStatistics>::const_iterator it = lateness_.begin(); it != lateness_.end(); ++it )
+  {
+    const tools::RpcMethodStatistics& s = it->second;
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(2)
+         << it->first
+         << " messages=" << s.calls
+         << " rate=" << ( elapsed > 0 ? s.calls / elapsed : 0. ) << "Hz"
+         << " bytes=" << s.payload_bytes
+         << " late_p50=" << s.percentile(0.5) / 1000. << "ms"
+         << " late_p99=" << s.percentile(0.99) / 1000. << "ms"
+         << " late_max=" << s.max_us / 1000. << "ms";
+    lines.push_back( line.str() );
+  }
+  return lines;
+}
+
+ReplayConverter::ReplayConverter( const std::string& path, const std::string& topic, float frequency,
+                                  const boost::shared_ptr<ReplayClock>& clock, const qi::SessionPtr& session )
+  : BaseConverter( topic, frequency, session ),
+    path_( path ),
+    clock_( clock ),
+    done_( false )
+{}
+
+void ReplayConverter::registerCallback( const message_actions::MessageAction action, Callback_t cb )
+{
+  callbacks_[action] = cb;
+}
+
+boost::shared_ptr<const tools::MessageType> ReplayConverter::messageType( const rosbag::ConnectionInfo& connection )
+{
+  boost::shared_ptr<tools::MessageType> type = boost::make_shared<tools::MessageType>();
+  type->datatype = connection.datatype;
+  type->md5sum = connection.md5sum;
+  type->definition = connection.msg_def;
+  return type;
+}
+
+void ReplayConverter::reset()
+{
+  bag_ = boost::make_shared<rosbag::Bag>();
+  bag_->open( path_, rosbag::bagmode::Read );
+  view_ = boost::make_shared<rosbag::View>( *bag_, rosbag::TopicQuery( name_ ) );
+  it_ = view_->begin();
+  done_ = false;
+  const std::vector<const rosbag::ConnectionInfo*> connections = view_->getConnections();
+  if ( !connections.empty() )
+  {
+    type_ = messageType( *connections.front() );
+  }
+}
+
+void ReplayConverter::callAll( const std::vector<message_actions::MessageAction>& actions )
+{
+  if ( !view_ || done_ )
+  {
+    return;
+  }
+
+  const ros::Time until = clock_->bagTime();
+  while ( it_ != view_->end() && it_->getTime() <= until )
+  {
+    const rosbag::MessageInstance& instance = *it_;
+    tools::SerializedMessage msg;
+    msg.type = type_;
+    msg.size = instance.size();
+    msg.data.reset( new uint8_t[msg.size] );
+    ros::serialization::OStream stream( msg.data.get(), msg.size );
+    instance.write( stream );
+
+    for_each( const message_actions::MessageAction& action, actions )
+    {
+      NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
+      callbacks_[action]( msg );
+    }
+    clock_->record( name_, instance.getTime(), ros::WallTime::now(), msg.size );
+
+    ++it_;
+    if ( clock_->isMaxSpeed() )
+    {
+      break;
+    }
+  }
+
+  if ( it_ == view_->end() )
+  {
+    std::cout << "Replay of " << name_ << " is over" << std::endl;
+    done_ = true;
+  }
+}
+
+} // converter
+} // naoqi
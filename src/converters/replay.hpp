@@ -0,0 +1,144 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef REPLAY_CONVERTER_HPP
+#define REPLAY_CONVERTER_HPP
+
+/*
+* LOCAL includes
+*/
+#include "converter_base.hpp"
+#include "../tools/rpc_statistics.hpp"
+#include "../tools/serialized_message.hpp"
+#include <naoqi_driver/message_actions.h>
+
+/*
+* STANDARD includes
+*/
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+/*
+* ROS includes
+*/
+#include <ros/time.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+
+namespace naoqi
+{
+namespace converter
+{
+
+/**
+* @brief Maps the time of a ROSbag on the wall clock, shared by the converters replaying it
+* @note the clock starts with the first message asked, so that opening the bags is not replayed as a delay.
+* It also gathers, per topic, how late each message went out compared to its time in the bag.
+*/
+class ReplayClock : private boost::noncopyable
+{
+public:
+  /**
+  * @param begin time of the first message of the bag
+  * @param speed 1 for real time, N for N times faster, 0 or less to go as fast as the driver can
+  */
+  ReplayClock( const ros::Time& begin, float speed );
+
+  /** Time of the bag reached now, ros::TIME_MAX at maximum speed */
+  ros::Time bagTime();
+
+  /** Wall time at which a message of the bag is due */
+  ros::WallTime dueTime( const ros::Time& bag_time );
+
+  inline bool isMaxSpeed() const
+  {
+    return speed_ <= 0.f;
+  }
+
+  inline float speed() const
+  {
+    return speed_;
+  }
+
+  /** Account for a message of a topic sent at now */
+  void record( const std::string& topic, const ros::Time& bag_time, const ros::WallTime& now, size_t bytes );
+
+  /** One human readable line per topic: messages, bytes and lateness percentiles */
+  std::vector<std::string> summary() const;
+
+private:
+  void startIfNeeded();
+
+  const ros::Time begin_;
+  const float speed_;
+  bool started_;
+  ros::WallTime start_;
+
+  mutable boost::mutex mutex_;
+  std::map<std::string, tools::RpcMethodStatistics> lateness_;
+};
+
+/**
+* @brief Plays back one topic of a ROSbag (a minidump or a record) in place of a NAOqi converter
+* @note the messages are read already serialized and given as is to the publisher and the recorder.
+* Each tick sends the messages whose time is reached on the ReplayClock, one per tick at maximum speed.
+*/
+class ReplayConverter : public BaseConverter<ReplayConverter>
+{
+
+  typedef boost::function<void(tools::SerializedMessage&)> Callback_t;
+
+public:
+  ReplayConverter( const std::string& path, const std::string& topic, float frequency,
+                   const boost::shared_ptr<ReplayClock>& clock, const qi::SessionPtr& session );
+
+  void registerCallback( const message_actions::MessageAction action, Callback_t cb );
+
+  void callAll( const std::vector<message_actions::MessageAction>& actions );
+
+  /** Open the bag and go back to its first message */
+  void reset();
+
+  /** Type of the messages of the topic, read from the bag */
+  static boost::shared_ptr<const tools::MessageType> messageType( const rosbag::ConnectionInfo& connection );
+
+private:
+  std::string path_;
+  boost::shared_ptr<ReplayClock> clock_;
+  boost::shared_ptr<rosbag::Bag> bag_;
+  boost::shared_ptr<rosbag::View> view_;
+  rosbag::View::iterator it_;
+  boost::shared_ptr<const tools::MessageType> type_;
+  bool done_;
+
+  std::map<message_actions::MessageAction, Callback_t> callbacks_;
+}; // class
+
+} //converter
+} // naoqi
+
+#endif
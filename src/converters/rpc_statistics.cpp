@@ -0,0 +1,98 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/*
+* LOCAL includes
+*/
+#include "rpc_statistics.hpp"
+#include "../tools/rpc_statistics.hpp"
+
+/*
+* ROS includes
+*/
+#include <diagnostic_updater/DiagnosticStatusWrapper.h>
+
+/*
+* BOOST includes
+*/
+#include <boost/foreach.hpp>
+#define for_each BOOST_FOREACH
+
+namespace naoqi
+{
+namespace converter
+{
+
+RpcStatisticsConverter::RpcStatisticsConverter( const std::string& name, float frequency, const qi::SessionPtr& session ):
+  BaseConverter( name, frequency, session )
+{
+}
+
+void RpcStatisticsConverter::reset()
+{
+}
+
+void RpcStatisticsConverter::registerCallback( const message_actions::MessageAction action, Callback_t cb )
+{
+  callbacks_[action] = cb;
+}
+
+void RpcStatisticsConverter::callAll( const std::vector<message_actions::MessageAction>& actions )
+{
+  diagnostic_msgs::DiagnosticArray msg;
+  msg.header.stamp = ros::Time::now();
+
+  const tools::RpcStatistics::Map stats = tools::RpcStatistics::instance().snapshot();
+  for ( tools::RpcStatistics::Map::const_iterator it = stats.begin(); it != stats.end(); ++it )
+  {
+    const tools::RpcMethodStatistics& s = it->second;
+
+    diagnostic_updater::DiagnosticStatusWrapper status;
+    status.name = std::string("naoqi_driver_rpc:") + it->first;
+    status.hardware_id = it->first.substr( 0, it->first.find('.') );
+    if ( s.errors == 0 )
+    {
+      status.level = diagnostic_msgs::DiagnosticStatus::OK;
+      status.message = "OK";
+    }
+    else
+    {
+      status.level = diagnostic_msgs::DiagnosticStatus::WARN;
+      status.message = "Calls failed";
+    }
+
+    status.add("Calls", s.calls);
+    status.add("Errors", s.errors);
+    status.add("Payload Bytes", s.payload_bytes);
+    status.add("Mean Latency (ms)", s.mean() / 1000.);
+    status.add("P50 Latency (ms)", s.percentile(0.5) / 1000.);
+    status.add("P90 Latency (ms)", s.percentile(0.9) / 1000.);
+    status.add("P99 Latency (ms)", s.percentile(0.99) / 1000.);
+    status.add("Max Latency (ms)", s.max_us / 1000.);
+
+    msg.status.push_back(status);
+  }
+
+  for_each( const message_actions::MessageAction& action, actions )
+  {
+    NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
+    callbacks_[action](msg);
+  }
+}
+
+} // converter
+} // naoqi
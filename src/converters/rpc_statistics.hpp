@@ -0,0 +1,63 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RPC_STATISTICS_CONVERTER_HPP
+#define RPC_STATISTICS_CONVERTER_HPP
+
+/*
+* LOCAL includes
+*/
+#include "converter_base.hpp"
+#include <naoqi_driver/message_actions.h>
+
+/*
+* ROS includes
+*/
+#include <diagnostic_msgs/DiagnosticArray.h>
+
+namespace naoqi
+{
+namespace converter
+{
+
+/**
+* @brief Converter turning the libqi call statistics of the other converters into diagnostics
+* @note it does not talk to NAOqi itself, it only reads tools::RpcStatistics
+*/
+class RpcStatisticsConverter : public BaseConverter<RpcStatisticsConverter>
+{
+
+  typedef boost::function<void(diagnostic_msgs::DiagnosticArray&) > Callback_t;
+
+public:
+  RpcStatisticsConverter( const std::string& name, float frequency, const qi::SessionPtr& session );
+
+  void reset();
+
+  void registerCallback( const message_actions::MessageAction action, Callback_t cb );
+
+  void callAll( const std::vector<message_actions::MessageAction>& actions );
+
+private:
+  /** Registered Callbacks **/
+  std::map<message_actions::MessageAction, Callback_t> callbacks_;
+};
+
+} //converter
+} // naoqi
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SERIALIZED_CALLBACKS_HPP
+#define SERIALIZED_CALLBACKS_HPP
+
+/*
+* LOCAL includes
+*/
+#include <naoqi_driver/message_actions.h>
+#include "../tools/serialized_message.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <map>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/function.hpp>
+
+/*
+* ROS includes
+*/
+#include <ros/time.h>
+
+namespace naoqi
+{
+namespace converter
+{
+
+/**
+* @brief Callbacks of a converter taking its message already serialized, so that it is serialized once per tick
+* @note they are registered next to the plain callbacks and only used when at least two actions of a tick have one,
+* e.g. when the message is published, recorded and buffered: it is then serialized for the first of them
+* and the same bytes go to the others. For a single action the plain callback is as cheap.
+* @note Callback may take one more argument sent along with the message, e.g. the camera info of an image
+*/
+template <class T, class Callback = boost::function<void(const tools::SerializedMessage&, const ros::Time&) > >
+class SerializedCallbacks
+{
+public:
+  typedef Callback Callback_t;
+
+  SerializedCallbacks():
+    type_( tools::messageTypeOf<T>() )
+  {}
+
+  void registerCallback( const message_actions::MessageAction action, Callback_t cb )
+  {
+    callbacks_[action] = cb;
+  }
+
+  /** Whether the message of a tick with these actions is worth serializing once */
+  bool shared( const std::vector<message_actions::MessageAction>& actions ) const
+  {
+    size_t count = 0;
+    for ( size_t i=0; i<actions.size(); ++i )
+    {
+      count += callbacks_.count( actions[i] );
+    }
+    return count >= 2;
+  }
+
+  /**
+  * @brief Give msg to the callback of action, serialized in serialized at the first call of the tick
+  * @param serialized empty at the beginning of each tick
+  * @return false if action has no such callback
+  */
+  bool call( const message_actions::MessageAction action, const T& msg, const ros::Time& stamp, tools::SerializedMessage& serialized )
+  {
+    Callback_t* callback = find( action, msg, serialized );
+    if ( callback == NULL )
+    {
+      return false;
+    }
+    (*callback)( serialized, stamp );
+    return true;
+  }
+
+  /** Same as call, for the callbacks taking extra along with the message */
+  template <class Extra>
+  bool call( const message_actions::MessageAction action, const T& msg, const ros::Time& stamp, tools::SerializedMessage& serialized, const Extra& extra )
+  {
+    Callback_t* callback = find( action, msg, serialized );
+    if ( callback == NULL )
+    {
+      return false;
+    }
+    (*callback)( serialized, stamp, extra );
+    return true;
+  }
+
+private:
+  /** Callback of action, msg is serialized the first time; NULL if action has none */
+  Callback_t* find( const message_actions::MessageAction action, const T& msg, tools::SerializedMessage& serialized )
+  {
+    typename std::map<message_actions::MessageAction, Callback_t>::iterator it = callbacks_.find( action );
+    if ( it == callbacks_.end() )
+    {
+      return NULL;
+    }
+    if ( !serialized.type )
+    {
+      serialized = tools::serializeMessage( msg, type_ );
+    }
+    return &it->second;
+  }
+
+  boost::shared_ptr<const tools::MessageType> type_;
+  std::map<message_actions::MessageAction, Callback_t> callbacks_;
+};
+
+} // converter
+} // naoqi
+
+#endif
@@ -34,8 +34,8 @@ namespace converter
 
 SonarConverter::SonarConverter( const std::string& name, const float& frequency, const qi::SessionPtr& session )
   : BaseConverter( name, frequency, session ),
-    p_memory_( session->service("ALMemory") ),
-    p_sonar_( session->service("ALSonar") ),
+    p_memory_( session->service("ALMemory"), "ALMemory" ),
+    p_sonar_( session->service("ALSonar"), "ALSonar" ),
     is_subscribed_(false)
 {
   std::vector<std::string> keys;
@@ -87,6 +87,16 @@ void SonarConverter::registerCallback( message_actions::MessageAction action, Ca
 }
 
 void SonarConverter::callAll( const std::vector<message_actions::MessageAction>& actions )
+{
+  try {
+      qi::AnyValue data = fetch().value();
+      convert( actions, data );
+  } catch (const std::exception& e) {
+    std::cerr << "Exception caught in SonarConverter: " << e.what() << std::endl;
+  }
+}
+
+qi::Future<qi::AnyValue> SonarConverter::fetch()
 {
   if (!is_subscribed_)
   {
@@ -94,10 +104,14 @@ void SonarConverter::callAll( const std::vector<message_actions::MessageAction>&
     is_subscribed_ = true;
   }
 
+  return p_memory_.async<qi::AnyValue>("getListData", keys_);
+}
+
+void SonarConverter::convert( const std::vector<message_actions::MessageAction>& actions, qi::AnyValue& data )
+{
   std::vector<float> values;
   try {
-      qi::AnyValue anyvalues = p_memory_.call<qi::AnyValue>("getListData", keys_);
-      tools::fromAnyValueToFloatVector(anyvalues, values);
+      tools::fromAnyValueToFloatVector(data, values);
   } catch (const std::exception& e) {
     std::cerr << "Exception caught in SonarConverter: " << e.what() << std::endl;
     return;
@@ -111,6 +125,7 @@ void SonarConverter::callAll( const std::vector<message_actions::MessageAction>&
 
   for_each( message_actions::MessageAction action, actions )
   {
+    NAOQI_TRACE_SCOPE( tools::actionName(action), name_ );
     callbacks_[action]( msgs_ );
   }
 }
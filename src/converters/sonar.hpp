@@ -34,7 +34,7 @@ namespace naoqi
 namespace converter
 {
 
-class SonarConverter : public BaseConverter<SonarConverter>
+class SonarConverter : public BaseConverter<SonarConverter>, public AsyncConverter
 {
 
   typedef boost::function<void(std::vector<sensor_msgs::Range>&)> Callback_t;
@@ -51,14 +51,18 @@ public:
 
   void callAll( const std::vector<message_actions::MessageAction>& actions );
 
+  qi::Future<qi::AnyValue> fetch();
+
+  void convert( const std::vector<message_actions::MessageAction>& actions, qi::AnyValue& data );
+
 
 private:
   std::map<message_actions::MessageAction, Callback_t> callbacks_;
 
   /** Sonar (Proxy) configurations */
-  qi::AnyObject p_sonar_;
+  tools::InstrumentedObject p_sonar_;
   /** Memory (Proxy) configurations */
-  qi::AnyObject p_memory_;
+  tools::InstrumentedObject p_memory_;
   /** Key describeing whether we are subscribed to the ALSonar module */
   bool is_subscribed_;
 
@@ -57,6 +57,7 @@ void TouchEventConverter<T>::callAll(const std::vector<message_actions::MessageA
   msg_ = msg;
   for_each( message_actions::MessageAction action, actions )
   {
+    NAOQI_TRACE_SCOPE( tools::actionName(action), this->name_ );
     callbacks_[action](msg_);
   }
 }
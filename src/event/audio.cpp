@@ -15,9 +15,12 @@
  *
 */
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
 #include <boost/make_shared.hpp>
 
 #include <ros/ros.h>
@@ -28,15 +31,44 @@
 #include <naoqi_driver/message_actions.h>
 
 #include "audio.hpp"
+#include "../tools/trace.hpp"
 
 namespace naoqi
 {
 
+namespace
+{
+
+/** Frequency and order of the microphones asked to ALAudioDevice */
+const int device_frequency = 48000;
+const char* const device_channels[] = { "left", "right", "front", "rear" };
+const size_t device_channel_count = 4;
+
+void collectAll( const std::vector<recorder::DumpSnapshot>& snapshots, std::vector<recorder::DumpRecord>& records )
+{
+  for ( size_t i=0; i<snapshots.size(); ++i )
+  {
+    if ( snapshots[i] )
+    {
+      snapshots[i]( records );
+    }
+  }
+}
+
+} // anonymous
+
 AudioEventRegister::AudioEventRegister()
+  : frames_(ring_frames),
+    frames_received_(0),
+    overruns_(0),
+    max_queue_depth_(0),
+    worker_running_(false),
+    voice_frames_(0)
 {
 }
 
-AudioEventRegister::AudioEventRegister( const std::string& name, const float& frequency, const qi::SessionPtr& session )
+AudioEventRegister::AudioEventRegister( const std::string& name, const float& frequency, const qi::SessionPtr& session,
+                                        const std::vector<AudioProfile>& profiles, const tools::VoiceActivityConfig& vad )
   : serviceId(0),
     p_audio_( session->service("ALAudioDevice")),
     p_robot_model_(session->service("ALRobotModel")),
@@ -44,7 +76,15 @@ AudioEventRegister::AudioEventRegister( const std::string& name, const float& fr
     isStarted_(false),
     isPublishing_(false),
     isRecording_(false),
-    isDumping_(false)
+    isDumping_(false),
+    frames_(ring_frames),
+    frames_received_(0),
+    overruns_(0),
+    max_queue_depth_(0),
+    worker_running_(false),
+    vad_(vad),
+    pre_roll_(vad.pre_roll),
+    voice_frames_(0)
 {
   int micConfig = p_robot_model_.call<int>("_getMicrophoneConfig");
   if(micConfig){
@@ -59,14 +99,61 @@ AudioEventRegister::AudioEventRegister( const std::string& name, const float& fr
     channelMap.push_back(1);
     channelMap.push_back(4);
   }
-  publisher_ = boost::make_shared<publisher::BasicPublisher<naoqi_bridge_msgs::AudioBuffer> >( name );
-  recorder_ = boost::make_shared<recorder::BasicEventRecorder<naoqi_bridge_msgs::AudioBuffer> >( name );
-  converter_ = boost::make_shared<converter::AudioEventConverter>( name, frequency, session );
 
-  converter_->registerCallback( message_actions::PUBLISH, boost::bind(&publisher::BasicPublisher<naoqi_bridge_msgs::AudioBuffer>::publish, publisher_, _1) );
-  converter_->registerCallback( message_actions::RECORD, boost::bind(&recorder::BasicEventRecorder<naoqi_bridge_msgs::AudioBuffer>::write, recorder_, _1) );
-  converter_->registerCallback( message_actions::LOG, boost::bind(&recorder::BasicEventRecorder<naoqi_bridge_msgs::AudioBuffer>::bufferize, recorder_, _1) );
+  if ( vad.enabled )
+  {
+    vad_publisher_ = boost::make_shared<publisher::BasicPublisher<naoqi_bridge_msgs::BoolStamped> >( name + "/vad" );
+  }
+
+  std::vector<AudioProfile> topics = profiles;
+  if ( topics.empty() )
+  {
+    AudioProfile all;
+    all.topic = name;
+    for ( size_t channel=0; channel<device_channel_count; ++channel )
+    {
+      all.channels.push_back( channel );
+    }
+    topics.push_back( all );
+  }
+
+  outputs_.resize( topics.size() );
+  for ( size_t i=0; i<topics.size(); ++i )
+  {
+    AudioOutput& output = outputs_[i];
+    output.profile = topics[i];
+    const std::string& topic = output.profile.topic;
+    output.publisher = boost::make_shared<publisher::BasicPublisher<naoqi_bridge_msgs::AudioBuffer> >( topic );
+    output.recorder = boost::make_shared<recorder::BasicEventRecorder<naoqi_bridge_msgs::AudioBuffer> >( topic );
+    output.converter = boost::make_shared<converter::AudioEventConverter>( topic, frequency, session );
+
+    // the pooled messages are published as they are, the subscribers in the same process get them without a copy
+    output.converter->registerSharedCallback( message_actions::PUBLISH, boost::bind(&publisher::BasicPublisher<naoqi_bridge_msgs::AudioBuffer>::publishShared, output.publisher, _1) );
+    output.converter->registerCallback( message_actions::RECORD, boost::bind(&recorder::BasicEventRecorder<naoqi_bridge_msgs::AudioBuffer>::write, output.recorder, _1) );
+    output.converter->registerCallback( message_actions::LOG, boost::bind(&recorder::BasicEventRecorder<naoqi_bridge_msgs::AudioBuffer>::bufferize, output.recorder, _1) );
 
+    const size_t nb_channels = output.profile.mono ? 1 : output.profile.channels.size();
+    output.resamplers.assign( nb_channels, tools::AudioResampler( device_frequency, output.profile.frequency ) );
+    output.planes.resize( nb_channels );
+    output.resampled.resize( nb_channels );
+    naoqi_bridge_msgs::AudioBuffer prototype;
+    prototype.frequency = output.profile.frequency;
+    for ( size_t c=0; c<nb_channels; ++c )
+    {
+      prototype.channelMap.push_back( channelMap[output.profile.channels[c]] );
+    }
+    output.messages = boost::make_shared< tools::MessagePool<naoqi_bridge_msgs::AudioBuffer> >( prototype, pool_messages );
+
+    if ( output.profile.compressed )
+    {
+      const std::string compressed_topic = topic + "/compressed";
+      output.compressed_recorder = boost::make_shared<recorder::BasicEventRecorder<tools::CompressedAudioBuffer> >( compressed_topic );
+      if ( output.profile.publish_compressed )
+      {
+        output.compressed_publisher = boost::make_shared<publisher::BasicPublisher<tools::CompressedAudioBuffer> >( compressed_topic );
+      }
+    }
+  }
 }
 
 AudioEventRegister::~AudioEventRegister()
@@ -76,12 +163,30 @@ AudioEventRegister::~AudioEventRegister()
 
 void AudioEventRegister::resetPublisher(ros::NodeHandle& nh)
 {
-  publisher_->reset(nh);
+  if ( vad_publisher_ )
+  {
+    vad_publisher_->reset(nh);
+  }
+  for ( size_t i=0; i<outputs_.size(); ++i )
+  {
+    outputs_[i].publisher->reset(nh);
+    if ( outputs_[i].compressed_publisher )
+    {
+      outputs_[i].compressed_publisher->reset(nh);
+    }
+  }
 }
 
 void AudioEventRegister::resetRecorder( boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr )
 {
-  recorder_->reset(gr, converter_->frequency());
+  for ( size_t i=0; i<outputs_.size(); ++i )
+  {
+    outputs_[i].recorder->reset(gr, outputs_[i].converter->frequency());
+    if ( outputs_[i].compressed_recorder )
+    {
+      outputs_[i].compressed_recorder->reset(gr, outputs_[i].converter->frequency());
+    }
+  }
 }
 
 void AudioEventRegister::startProcess()
@@ -89,6 +194,14 @@ void AudioEventRegister::startProcess()
   boost::mutex::scoped_lock start_lock(subscription_mutex_);
   if (!isStarted_)
   {
+    // the worker is not running yet, the frames left by a previous run are dropped
+    while (frames_.front())
+    {
+      frames_.pop();
+    }
+    worker_running_ = true;
+    worker_ = boost::thread( &AudioEventRegister::workerLoop, this );
+
     if(!serviceId)
     {
       serviceId = session_->registerService("ROS-Driver-Audio", shared_from_this());
@@ -116,22 +229,65 @@ void AudioEventRegister::stopProcess()
       session_->unregisterService(serviceId);
       serviceId = 0;
     }
+    {
+      boost::mutex::scoped_lock worker_lock(worker_mutex_);
+      worker_running_ = false;
+    }
+    worker_condition_.notify_one();
+    worker_.join();
+    for ( size_t i=0; i<outputs_.size(); ++i )
+    {
+      outputs_[i].pre_roll.clear();
+    }
     std::cout << "Audio Extractor: Stop" << std::endl;
     isStarted_ = false;
   }
 }
 
-void AudioEventRegister::writeDump(const ros::Time& time)
+recorder::DumpSnapshot AudioEventRegister::snapshot(const ros::Time& time)
 {
   if (isStarted_)
   {
-    recorder_->writeDump(time);
+    if ( outputs_.size() == 1 && !outputs_.front().compressed_recorder )
+    {
+      return outputs_.front().recorder->snapshot(time);
+    }
+    std::vector<recorder::DumpSnapshot> snapshots;
+    for ( size_t i=0; i<outputs_.size(); ++i )
+    {
+      snapshots.push_back( outputs_[i].recorder->snapshot(time) );
+      if ( outputs_[i].compressed_recorder )
+      {
+        snapshots.push_back( outputs_[i].compressed_recorder->snapshot(time) );
+      }
+    }
+    return boost::bind( &collectAll, snapshots, _1 );
   }
+  return recorder::DumpSnapshot();
 }
 
 void AudioEventRegister::setBufferDuration(float duration)
 {
-  recorder_->setBufferDuration(duration);
+  for ( size_t i=0; i<outputs_.size(); ++i )
+  {
+    outputs_[i].recorder->setBufferDuration(duration);
+    if ( outputs_[i].compressed_recorder )
+    {
+      outputs_[i].compressed_recorder->setBufferDuration(duration);
+    }
+  }
+}
+
+void AudioEventRegister::setProfile(const recorder::RecordProfile& profile)
+{
+  for ( size_t i=0; i<outputs_.size(); ++i )
+  {
+    outputs_[i].recorder->setProfile(profile);
+    if ( outputs_[i].compressed_recorder )
+    {
+      outputs_[i].compressed_recorder->setProfile(profile);
+    }
+  }
 }
 
 void AudioEventRegister::isRecording(bool state)
@@ -162,40 +318,336 @@ void AudioEventRegister::unregisterCallback()
 
 void AudioEventRegister::processRemote(int nbOfChannels, int samplesByChannel, qi::AnyValue altimestamp, qi::AnyValue buffer)
 {
-  naoqi_bridge_msgs::AudioBuffer msg = naoqi_bridge_msgs::AudioBuffer();
-  msg.header.stamp = ros::Time::now();
-  msg.frequency = 48000;
-  msg.channelMap = channelMap;
+  NAOQI_TRACE_SCOPE( "event", "audio" );
+  ++frames_received_;
+  boost::uint64_t ticket;
+  AudioFrame* frame = frames_.claim(ticket);
+  if (frame == NULL)
+  {
+    ++overruns_;
+    return;
+  }
 
+  frame->stamp = ros::Time::now();
   std::pair<char*, size_t> buffer_pointer = buffer.asRaw();
+  const int16_t* remoteBuffer = reinterpret_cast<const int16_t*>(buffer_pointer.first);
+  const int bufferSize = nbOfChannels * samplesByChannel;
+  // the slot keeps its capacity, only the first frames allocate
+  frame->data.assign(remoteBuffer, remoteBuffer+bufferSize);
+  frames_.commit(ticket);
 
-  int16_t* remoteBuffer = (int16_t*)buffer_pointer.first;
-  int bufferSize = nbOfChannels * samplesByChannel;
-  msg.data = std::vector<int16_t>(remoteBuffer, remoteBuffer+bufferSize);
+  const size_t depth = frames_.size();
+  size_t max_depth = max_queue_depth_.load();
+  while (depth > max_depth && !max_queue_depth_.compare_exchange_weak(max_depth, depth))
+  {
+  }
+  worker_condition_.notify_one();
+}
 
+void AudioEventRegister::workerLoop()
+{
+  NAOQI_TRACE_THREAD_NAME( "audio" );
   std::vector<message_actions::MessageAction> actions;
-  boost::mutex::scoped_lock callback_lock(processing_mutex_);
-  if (isStarted_) {
-    // CHECK FOR PUBLISH
-    if ( isPublishing_ && publisher_->isSubscribed() )
+  std::vector<message_actions::MessageAction> compressed_actions;
+
+  while (worker_running_)
+  {
+    AudioFrame* frame = frames_.front();
+    if (frame == NULL)
     {
-      actions.push_back(message_actions::PUBLISH);
+      // the producer does not lock to notify, a wakeup lost in between only delays the frame by the timeout
+      boost::mutex::scoped_lock worker_lock(worker_mutex_);
+      if (worker_running_ && frames_.front() == NULL)
+      {
+        worker_condition_.timed_wait(worker_lock, boost::posix_time::milliseconds(20));
+      }
+      continue;
     }
-    // CHECK FOR RECORD
-    if ( isRecording_ )
+
     {
-      actions.push_back(message_actions::RECORD);
+      NAOQI_TRACE_SCOPE( "event", "audio worker" );
+      boost::mutex::scoped_lock callback_lock(processing_mutex_);
+      const bool voice = isStarted_ ? detectVoice( *frame ) : true;
+      for ( size_t i=0; isStarted_ && i<outputs_.size(); ++i )
+      {
+        AudioOutput& output = outputs_[i];
+        actions.clear();
+        compressed_actions.clear();
+        // CHECK FOR PUBLISH
+        if ( isPublishing_ && output.publisher->isSubscribed() )
+        {
+          actions.push_back(message_actions::PUBLISH);
+        }
+        if ( isPublishing_ && output.compressed_publisher && output.compressed_publisher->isSubscribed() )
+        {
+          compressed_actions.push_back(message_actions::PUBLISH);
+        }
+        // a compressed topic is recorded and buffered compressed only
+        std::vector<message_actions::MessageAction>& stored_actions = output.compressed_recorder ? compressed_actions : actions;
+        // CHECK FOR RECORD
+        if ( isRecording_ )
+        {
+          stored_actions.push_back(message_actions::RECORD);
+        }
+        if ( !isDumping_ )
+        {
+          stored_actions.push_back(message_actions::LOG);
+        }
+        if (actions.empty() && compressed_actions.empty())
+        {
+          // nobody takes the audio: what is held for the pre-roll would be stale when somebody comes back
+          output.pre_roll.clear();
+          continue;
+        }
+        // held until the publisher, the recorders and the buffer are done with it
+        boost::shared_ptr<naoqi_bridge_msgs::AudioBuffer> msg = output.messages->acquire();
+        convert( *frame, output, *msg );
+        // the oldest messages go back to the pool, also the ones held before the driver was stopped
+        while ( !output.pre_roll.empty() && msg->header.stamp - output.pre_roll.front()->header.stamp > pre_roll_ )
+        {
+          output.pre_roll.pop_front();
+        }
+        if ( output.profile.gated && !voice )
+        {
+          // kept for the pre-roll
+          output.pre_roll.push_back( msg );
+          continue;
+        }
+        // the voice starts: the audio just before it goes first
+        for ( size_t j=0; j<output.pre_roll.size(); ++j )
+        {
+          dispatch( actions, compressed_actions, output, output.pre_roll[j] );
+        }
+        output.pre_roll.clear();
+        dispatch( actions, compressed_actions, output, msg );
+      }
     }
-    if ( !isDumping_ )
+    frames_.pop();
+  }
+}
+
+void AudioEventRegister::dispatch( const std::vector<message_actions::MessageAction>& actions,
+                                   const std::vector<message_actions::MessageAction>& compressed_actions,
+                                   AudioOutput& output, const boost::shared_ptr<naoqi_bridge_msgs::AudioBuffer>& msg )
+{
+  if (actions.size() >0)
+  {
+    output.converter->callAll( actions, msg );
+  }
+  if (compressed_actions.size() >0)
+  {
+    callCompressed( compressed_actions, output, *msg );
+  }
+}
+
+bool AudioEventRegister::detectVoice( const AudioFrame& frame )
+{
+  if ( !vad_publisher_ || frame.data.empty() )
+  {
+    return true;
+  }
+  bool voice;
+  {
+    NAOQI_TRACE_SCOPE( "event", "voice activity" );
+    voice = vad_.process( &frame.data[0], frame.data.size() / device_channel_count, device_channel_count, device_frequency );
+  }
+  if ( voice )
+  {
+    ++voice_frames_;
+  }
+  if ( isPublishing_ && vad_publisher_->isSubscribed() )
+  {
+    vad_msg_.header.stamp = frame.stamp;
+    vad_msg_.data = voice;
+    vad_publisher_->publish( vad_msg_ );
+  }
+  return voice;
+}
+
+void AudioEventRegister::callCompressed( const std::vector<message_actions::MessageAction>& actions, AudioOutput& output,
+                                         const naoqi_bridge_msgs::AudioBuffer& msg )
+{
+  {
+    NAOQI_TRACE_SCOPE_VALUE( "event", "audio compression", "bytes", msg.data.size()*sizeof(int16_t) );
+    tools::compressAudio( msg, output.compressed, output.codec_scratch );
+  }
+  for ( size_t i=0; i<actions.size(); ++i )
+  {
+    NAOQI_TRACE_SCOPE( tools::actionName(actions[i]), output.compressed_recorder->topic() );
+    switch ( actions[i] )
     {
-      actions.push_back(message_actions::LOG);
+    case message_actions::PUBLISH:
+      output.compressed_publisher->publish( output.compressed );
+      break;
+    case message_actions::RECORD:
+      output.compressed_recorder->write( output.compressed );
+      break;
+    case message_actions::LOG:
+      output.compressed_recorder->bufferize( output.compressed );
+      break;
     }
-    if (actions.size() >0)
+  }
+}
+
+size_t AudioEventRegister::pooledMessages() const
+{
+  size_t count = 0;
+  for ( size_t i=0; i<outputs_.size(); ++i )
+  {
+    count += outputs_[i].messages->size();
+  }
+  return count;
+}
+
+void AudioEventRegister::convert( const AudioFrame& frame, AudioOutput& output, naoqi_bridge_msgs::AudioBuffer& msg )
+{
+  const AudioProfile& profile = output.profile;
+  const size_t samples = frame.data.size() / device_channel_count;
+  const int16_t* data = frame.data.empty() ? NULL : &frame.data[0];
+  msg.header.stamp = frame.stamp;
+
+  // the 4 microphones at full rate are sent as they come
+  if ( !profile.mono && profile.frequency == device_frequency && profile.channels.size() == device_channel_count
+       && profile.channels[0] == 0 && profile.channels[1] == 1 && profile.channels[2] == 2 && profile.channels[3] == 3 )
+  {
+    msg.data.assign( frame.data.begin(), frame.data.end() );
+    return;
+  }
+
+  // deinterleave the kept microphones, or mix them down
+  const size_t nb_kept = profile.channels.size();
+  if ( profile.mono )
+  {
+    std::vector<int16_t>& plane = output.planes[0];
+    plane.resize( samples );
+    for ( size_t s=0; s<samples; ++s )
     {
-      converter_->callAll( actions, msg );
+      const int16_t* in = data + s*device_channel_count;
+      int sum = 0;
+      for ( size_t c=0; c<nb_kept; ++c )
+      {
+        sum += in[profile.channels[c]];
+      }
+      plane[s] = static_cast<int16_t>( sum / static_cast<int>(nb_kept) );
     }
   }
+  else
+  {
+    for ( size_t c=0; c<nb_kept; ++c )
+    {
+      std::vector<int16_t>& plane = output.planes[c];
+      plane.resize( samples );
+      const int16_t* in = data + profile.channels[c];
+      for ( size_t s=0; s<samples; ++s )
+      {
+        plane[s] = in[s*device_channel_count];
+      }
+    }
+  }
+
+  // resample each channel then interleave them again
+  const size_t nb_channels = output.planes.size();
+  for ( size_t c=0; c<nb_channels; ++c )
+  {
+    output.resampled[c].clear();
+    if ( !output.planes[c].empty() )
+    {
+      output.resamplers[c].process( &output.planes[c][0], output.planes[c].size(), output.resampled[c] );
+    }
+  }
+  const size_t out_samples = output.resampled[0].size();
+  msg.data.resize( out_samples * nb_channels );
+  for ( size_t c=0; c<nb_channels; ++c )
+  {
+    const std::vector<int16_t>& plane = output.resampled[c];
+    for ( size_t s=0; s<out_samples; ++s )
+    {
+      msg.data[s*nb_channels + c] = plane[s];
+    }
+  }
+}
 
+tools::VoiceActivityConfig AudioEventRegister::readVoiceActivity( const boost::property_tree::ptree& config )
+{
+  tools::VoiceActivityConfig vad;
+  vad.enabled = config.get( "enabled", vad.enabled );
+  vad.threshold = config.get( "threshold", vad.threshold );
+  vad.min_level = config.get( "min_level", vad.min_level );
+  vad.max_zero_crossing = config.get( "max_zero_crossing", vad.max_zero_crossing );
+  vad.pre_roll = config.get( "pre_roll", vad.pre_roll );
+  vad.hangover = config.get( "hangover", vad.hangover );
+  return vad;
+}
+
+std::vector<AudioProfile> AudioEventRegister::readProfiles( const boost::property_tree::ptree& config )
+{
+  std::vector<AudioProfile> profiles;
+  BOOST_FOREACH( const boost::property_tree::ptree::value_type& topic, config )
+  {
+    AudioProfile profile;
+    profile.topic = topic.first;
+    profile.mono = topic.second.get( "mono", false );
+    profile.frequency = topic.second.get( "frequency", device_frequency );
+    profile.publish_compressed = topic.second.get( "publish_compressed", false );
+    profile.gated = topic.second.get( "gated", false );
+
+    bool valid = true;
+    const std::string compression = topic.second.get<std::string>( "compression", "none" );
+    if ( compression == "lossless" )
+    {
+      profile.compressed = true;
+    }
+    else if ( compression != "none" )
+    {
+      std::cerr << BOLDRED << "Audio profile " << profile.topic << ": unknown compression " << compression
+                << ", expected none or lossless" << RESETCOLOR << std::endl;
+      valid = false;
+    }
+    profile.publish_compressed = profile.compressed && profile.publish_compressed;
+
+    boost::optional<const boost::property_tree::ptree&> channels = topic.second.get_child_optional( "channels" );
+    if ( channels )
+    {
+      BOOST_FOREACH( const boost::property_tree::ptree::value_type& channel, *channels )
+      {
+        const std::string channel_name = channel.second.get_value<std::string>();
+        const char* const* found = std::find( device_channels, device_channels + device_channel_count, channel_name );
+        if ( found == device_channels + device_channel_count )
+        {
+          std::cerr << BOLDRED << "Audio profile " << profile.topic << ": unknown microphone " << channel_name
+                    << ", expected left, right, front or rear" << RESETCOLOR << std::endl;
+          valid = false;
+        }
+        else
+        {
+          profile.channels.push_back( found - device_channels );
+        }
+      }
+    }
+    else
+    {
+      for ( size_t channel=0; channel<device_channel_count; ++channel )
+      {
+        profile.channels.push_back( channel );
+      }
+    }
+    if ( profile.channels.empty() )
+    {
+      std::cerr << BOLDRED << "Audio profile " << profile.topic << " keeps no microphone" << RESETCOLOR << std::endl;
+      valid = false;
+    }
+    if ( profile.frequency <= 0 || device_frequency % profile.frequency != 0 )
+    {
+      std::cerr << BOLDRED << "Audio profile " << profile.topic << ": " << profile.frequency
+                << " Hz is not 48000 Hz divided by an integer" << RESETCOLOR << std::endl;
+      valid = false;
+    }
+    if ( valid )
+    {
+      profiles.push_back( profile );
+    }
+  }
+  return profiles;
 }
 
 }//namespace
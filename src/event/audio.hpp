@@ -18,17 +18,24 @@
 #ifndef AUDIO_EVENT_REGISTER_HPP
 #define AUDIO_EVENT_REGISTER_HPP
 
+#include <deque>
 #include <string>
+#include <vector>
 
+#include <boost/atomic.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/property_tree/ptree.hpp>
 
 #include <qi/session.hpp>
 
 #include <ros/ros.h>
 #include <naoqi_bridge_msgs/AudioBuffer.h>
+#include <naoqi_bridge_msgs/BoolStamped.h>
 
 #include <naoqi_driver/tools.hpp>
 #include <naoqi_driver/recorder/globalrecorder.hpp>
@@ -39,10 +46,44 @@
 #include "../src/publishers/basic.hpp"
 // Recorder
 #include "../recorder/basic_event.hpp"
+// Tools
+#include "../tools/audio_codec.hpp"
+#include "../tools/audio_resampler.hpp"
+#include "../tools/message_pool.hpp"
+#include "../tools/mpsc_ring.hpp"
+#include "../tools/voice_activity.hpp"
 
 namespace naoqi
 {
 
+/**
+* @brief Format of an audio topic, made out of the 48 kHz stream of the 4 microphones given by ALAudioDevice
+*/
+struct AudioProfile
+{
+  AudioProfile():
+    mono( false ),
+    frequency( 48000 ),
+    compressed( false ),
+    publish_compressed( false ),
+    gated( false )
+  {}
+
+  std::string topic;
+  /** microphones kept, in the order of ALAudioDevice: 0 left, 1 right, 2 front, 3 rear */
+  std::vector<size_t> channels;
+  /** mix the kept microphones down to one channel, whose channel map is the one of the first of them */
+  bool mono;
+  /** sample rate of the topic, 48000 divided by an integer */
+  int frequency;
+  /** record and buffer the topic compressed without loss, on <topic>/compressed */
+  bool compressed;
+  /** publish <topic>/compressed too */
+  bool publish_compressed;
+  /** only publish, record and buffer the topic while a voice is detected, from the pre-roll before it */
+  bool gated;
+};
+
 /**
 * @brief GlobalRecorder concept interface
 * @note this defines an private concept struct,
@@ -59,7 +100,13 @@ public:
   * @brief Constructor for recorder interface
   */
   AudioEventRegister();
-  AudioEventRegister( const std::string& name, const float& frequency, const qi::SessionPtr& session );
+  /**
+  * @param profiles topics made out of the one subscription to ALAudioDevice,
+  * when empty the topic name gets the 4 microphones at 48 kHz
+  */
+  AudioEventRegister( const std::string& name, const float& frequency, const qi::SessionPtr& session,
+                      const std::vector<AudioProfile>& profiles = std::vector<AudioProfile>(),
+                      const tools::VoiceActivityConfig& vad = tools::VoiceActivityConfig() );
   ~AudioEventRegister();
 
   void resetPublisher( ros::NodeHandle& nh );
@@ -68,24 +115,130 @@ public:
   void startProcess();
   void stopProcess();
 
-  void writeDump(const ros::Time& time);
+  recorder::DumpSnapshot snapshot(const ros::Time& time);
   void setBufferDuration(float duration);
+  void setProfile(const recorder::RecordProfile& profile);
 
   void isRecording(bool state);
   void isPublishing(bool state);
   void isDumping(bool state);
 
+  /**
+  * @brief Called by ALAudioDevice, only copies the samples in the ring handed to the audio worker
+  * @note when the worker is behind and the ring is full, the frame is dropped and counted as an overrun
+  */
   void processRemote(int nbOfChannels, int samplesByChannel, qi::AnyValue altimestamp, qi::AnyValue buffer);
 
+  /** Frames received from ALAudioDevice */
+  inline boost::uint64_t framesReceived() const
+  {
+    return frames_received_;
+  }
+
+  /** Frames dropped because the ring was full */
+  inline boost::uint64_t overruns() const
+  {
+    return overruns_;
+  }
+
+  /** Frames waiting for the worker */
+  inline size_t queueDepth() const
+  {
+    return frames_.size();
+  }
+
+  /** Most frames that waited for the worker at once */
+  inline size_t maxQueueDepth() const
+  {
+    return max_queue_depth_;
+  }
+
+  inline size_t queueCapacity() const
+  {
+    return frames_.capacity();
+  }
+
+  /** Audio messages made so far, by all the topics */
+  size_t pooledMessages() const;
+
+  /**
+  * @brief Read the profiles of the boot config, e.g. converters.audio.profiles
+  * @note each child is a topic, with "channels" (list of left, right, front, rear), "mono" and "frequency";
+  * an invalid profile is reported and skipped
+  */
+  static std::vector<AudioProfile> readProfiles( const boost::property_tree::ptree& config );
+
+  /** Read the settings of the voice activity detection of the boot config, e.g. converters.audio.vad */
+  static tools::VoiceActivityConfig readVoiceActivity( const boost::property_tree::ptree& config );
+
+  /** Frames in which a voice was detected */
+  inline boost::uint64_t voiceFrames() const
+  {
+    return voice_frames_;
+  }
+
 private:
+  /** Samples of one call of processRemote, waiting for the worker */
+  struct AudioFrame
+  {
+    ros::Time stamp;
+    std::vector<int16_t> data;
+  };
+
+  /** A topic published out of the frames, in the format of its profile */
+  struct AudioOutput
+  {
+    AudioProfile profile;
+    boost::shared_ptr<converter::AudioEventConverter> converter;
+    boost::shared_ptr<publisher::BasicPublisher<naoqi_bridge_msgs::AudioBuffer> > publisher;
+    boost::shared_ptr<recorder::BasicEventRecorder<naoqi_bridge_msgs::AudioBuffer> > recorder;
+    /** one per channel of the topic */
+    std::vector<tools::AudioResampler> resamplers;
+    /** samples of each channel of the topic, kept or mixed down, then resampled; reused from frame to frame */
+    std::vector< std::vector<int16_t> > planes;
+    std::vector< std::vector<int16_t> > resampled;
+    /** messages of the topic, with its frequency and channel map already set */
+    boost::shared_ptr< tools::MessagePool<naoqi_bridge_msgs::AudioBuffer> > messages;
+    /** when the profile is compressed, they replace the recorder of the topic */
+    boost::shared_ptr<publisher::BasicPublisher<tools::CompressedAudioBuffer> > compressed_publisher;
+    boost::shared_ptr<recorder::BasicEventRecorder<tools::CompressedAudioBuffer> > compressed_recorder;
+    tools::CompressedAudioBuffer compressed;
+    /** working memory of the compression, reused from frame to frame */
+    tools::AudioCodecScratch codec_scratch;
+    /** messages of a gated topic held while there is no voice, the last pre-roll seconds of them */
+    std::deque< boost::shared_ptr<naoqi_bridge_msgs::AudioBuffer> > pre_roll;
+  };
+
+  /** Messages made in advance per topic, more are only made when a subscriber in the process holds them all */
+  static const size_t pool_messages = 4;
+
+  /** Frames the ring holds, about 2.7 s of audio with the 4096 samples per channel sent by ALAudioDevice */
+  static const size_t ring_frames = 32;
+
   void registerCallback();
   void unregisterCallback();
   void onEvent();
 
+  /** Audio worker: builds the messages of the frames of the ring and dispatches them */
+  void workerLoop();
+
+  /** Fill a message of output with a frame: channel selection, downmix, then resampling */
+  void convert( const AudioFrame& frame, AudioOutput& output, naoqi_bridge_msgs::AudioBuffer& msg );
+
+  /** Give msg to the callbacks of output and to its compressed publisher and recorder */
+  void dispatch( const std::vector<message_actions::MessageAction>& actions,
+                 const std::vector<message_actions::MessageAction>& compressed_actions,
+                 AudioOutput& output, const boost::shared_ptr<naoqi_bridge_msgs::AudioBuffer>& msg );
+
+  /** Run the voice activity detection on a frame and publish its state, true when it is disabled */
+  bool detectVoice( const AudioFrame& frame );
+
+  /** Compress msg and give it to the compressed publisher and recorder of output */
+  void callCompressed( const std::vector<message_actions::MessageAction>& actions, AudioOutput& output,
+                       const naoqi_bridge_msgs::AudioBuffer& msg );
+
 private:
-  boost::shared_ptr<converter::AudioEventConverter> converter_;
-  boost::shared_ptr<publisher::BasicPublisher<naoqi_bridge_msgs::AudioBuffer> > publisher_;
-  boost::shared_ptr<recorder::BasicEventRecorder<naoqi_bridge_msgs::AudioBuffer> > recorder_;
+  std::vector<AudioOutput> outputs_;
 
   qi::SessionPtr session_;
   qi::AnyObject p_audio_;
@@ -97,6 +250,24 @@ private:
   boost::mutex subscription_mutex_;
   boost::mutex processing_mutex_;
 
+  /** filled by processRemote without any lock, even if libqi ever overlaps two calls */
+  tools::MpscRing<AudioFrame> frames_;
+  boost::atomic<boost::uint64_t> frames_received_;
+  boost::atomic<boost::uint64_t> overruns_;
+  boost::atomic<size_t> max_queue_depth_;
+
+  boost::thread worker_;
+  boost::atomic<bool> worker_running_;
+  boost::mutex worker_mutex_;
+  boost::condition_variable worker_condition_;
+
+  /** voice activity, only used by the worker */
+  tools::VoiceActivityDetector vad_;
+  ros::Duration pre_roll_;
+  boost::shared_ptr<publisher::BasicPublisher<naoqi_bridge_msgs::BoolStamped> > vad_publisher_;
+  naoqi_bridge_msgs::BoolStamped vad_msg_;
+  boost::atomic<boost::uint64_t> voice_frames_;
+
   bool isStarted_;
   bool isPublishing_;
   bool isRecording_;
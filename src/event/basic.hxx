@@ -27,6 +27,8 @@
 #include <naoqi_driver/recorder/globalrecorder.hpp>
 #include <naoqi_driver/message_actions.h>
 
+#include "../tools/trace.hpp"
+
 namespace naoqi
 {
 
@@ -95,12 +97,13 @@ void EventRegister<Converter, Publisher, Recorder>::stopProcess()
 }
 
 template <typename Converter, typename Publisher, typename Recorder>
-void EventRegister<Converter, Publisher, Recorder>::writeDump(const ros::Time& time)
+recorder::DumpSnapshot EventRegister<Converter, Publisher, Recorder>::snapshot(const ros::Time& time)
 {
   if (isStarted_)
   {
-    recorder_->writeDump(time);
+    return recorder_->snapshot(time);
   }
+  return recorder::DumpSnapshot();
 }
 
 template <typename Converter, typename Publisher, typename Recorder>
@@ -109,6 +112,12 @@ void EventRegister<Converter, Publisher, Recorder>::setBufferDuration(float dura
   recorder_->setBufferDuration(duration);
 }
 
+template <typename Converter, typename Publisher, typename Recorder>
+void EventRegister<Converter, Publisher, Recorder>::setProfile(const recorder::RecordProfile& profile)
+{
+  recorder_->setProfile(profile);
+}
+
 template <typename Converter, typename Publisher, typename Recorder>
 void EventRegister<Converter, Publisher, Recorder>::isRecording(bool state)
 {
@@ -146,6 +155,7 @@ void EventRegister<Converter, Publisher, Recorder>::unregisterCallback()
 template <typename Converter, typename Publisher, typename Recorder>
 void EventRegister<Converter, Publisher, Recorder>::onEvent()
 {
+  NAOQI_TRACE_SCOPE( "event", key_ );
   std::vector<message_actions::MessageAction> actions;
   boost::mutex::scoped_lock callback_lock(mutex_);
   if (isStarted_) {
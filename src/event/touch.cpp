@@ -28,6 +28,7 @@
 #include <naoqi_driver/message_actions.h>
 
 #include "touch.hpp"
+#include "../tools/trace.hpp"
 
 namespace naoqi
 {
@@ -123,12 +124,13 @@ void TouchEventRegister<T>::stopProcess()
 }
 
 template<class T>
-void TouchEventRegister<T>::writeDump(const ros::Time& time)
+recorder::DumpSnapshot TouchEventRegister<T>::snapshot(const ros::Time& time)
 {
   if (isStarted_)
   {
-    //recorder_->writeDump(time);
+    //return recorder_->snapshot(time);
   }
+  return recorder::DumpSnapshot();
 }
 
 template<class T>
@@ -137,6 +139,12 @@ void TouchEventRegister<T>::setBufferDuration(float duration)
   //recorder_->setBufferDuration(duration);
 }
 
+template<class T>
+void TouchEventRegister<T>::setProfile(const recorder::RecordProfile& profile)
+{
+  //recorder_->setProfile(profile);
+}
+
 template<class T>
 void TouchEventRegister<T>::isRecording(bool state)
 {
@@ -171,6 +179,7 @@ void TouchEventRegister<T>::unregisterCallback()
 template<class T>
 void TouchEventRegister<T>::touchCallback(std::string &key, qi::AnyValue &value, qi::AnyValue &message)
 {
+  NAOQI_TRACE_SCOPE( "event", key );
   T msg = T();
   
   bool state =  value.toFloat() > 0.5f;
@@ -70,8 +70,9 @@ public:
   void startProcess();
   void stopProcess();
 
-  void writeDump(const ros::Time& time);
+  recorder::DumpSnapshot snapshot(const ros::Time& time);
   void setBufferDuration(float duration);
+  void setProfile(const recorder::RecordProfile& profile);
 
   void isRecording(bool state);
   void isPublishing(bool state);
@@ -109,14 +109,14 @@ inline std::string& getBootConfigFile()
 }
 
 /* URDF loader */
-inline std::string& getURDF( std::string filename )
+inline std::string getURDF( std::string filename )
 {
 #ifdef CATKIN_BUILD
-  static std::string path = ros::package::getPath("naoqi_driver")+"/share/urdf/"+filename;
+  std::string path = ros::package::getPath("naoqi_driver")+"/share/urdf/"+filename;
   std::cout << "found a catkin URDF " << path << std::endl;
   return path;
 #else
-  static std::string path = qi::path::findData( "/urdf/", filename );
+  std::string path = qi::path::findData( "/urdf/", filename );
   std::cout << "found a qibuild URDF " << path << std::endl;
   return path;
 #endif
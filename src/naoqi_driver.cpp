@@ -39,6 +39,8 @@
 #include "converters/memory/int.hpp"
 #include "converters/memory/string.hpp"
 #include "converters/log.hpp"
+#include "converters/replay.hpp"
+#include "converters/rpc_statistics.hpp"
 
 /*
  * PUBLISHERS
@@ -48,6 +50,7 @@
 #include "publishers/info.hpp"
 #include "publishers/joint_state.hpp"
 #include "publishers/log.hpp"
+#include "publishers/replay.hpp"
 #include "publishers/sonar.hpp"
 
 /*
@@ -55,6 +58,10 @@
  */
 #include "tools/robot_description.hpp"
 #include "tools/alvisiondefinitions.h" // for kTop...
+#include "tools/rpc_statistics.hpp"
+#include "tools/converter_statistics.hpp"
+#include "tools/trace.hpp"
+#include "tools/audio_codec.hpp"
 
 /*
  * SUBSCRIBERS
@@ -73,10 +80,13 @@
  * RECORDERS
  */
 #include "recorder/basic.hpp"
+#include "recorder/bag_storage.hpp"
 #include "recorder/basic_event.hpp"
 #include "recorder/camera.hpp"
 #include "recorder/diagnostics.hpp"
+#include "recorder/dump.hpp"
 #include "recorder/joint_state.hpp"
+#include "recorder/replay.hpp"
 #include "recorder/sonar.hpp"
 
 /*
@@ -95,9 +105,17 @@
 #include "helpers/naoqi_helpers.hpp"
 #include "helpers/driver_helpers.hpp"
 
+/*
+ * STANDARD
+ */
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
 /*
  * ROS
  */
+#include <rosbag/view.h>
 #include <tf2_ros/buffer.h>
 
 /*
@@ -107,8 +125,15 @@
 #include <boost/property_tree/json_parser.hpp>
 #define for_each BOOST_FOREACH
 
+/*
+ * ALDEBARAN
+ */
+#include <qi/log.hpp>
+
 #define DEBUG 0
 
+qiLogCategory("ros.Driver");
+
 namespace naoqi
 {
 
@@ -120,6 +145,8 @@ Driver::Driver( qi::SessionPtr session, const std::string& prefix )
   record_enabled_(false),
   log_enabled_(false),
   keep_looping(true),
+  dump_in_progress_(false),
+  wake_all_(false),
   recorder_(boost::make_shared<recorder::GlobalRecorder>(prefix)),
   buffer_duration_(helpers::recorder::bufferDefaultDuration)
 {
@@ -129,6 +156,10 @@ Driver::Driver( qi::SessionPtr session, const std::string& prefix )
 Driver::~Driver()
 {
   std::cout << "naoqi driver is shutting down.." << std::endl;
+  if (dumpThread_.joinable())
+  {
+    dumpThread_.join();
+  }
   // destroy nodehandle?
   if(nhPtr_)
   {
@@ -155,87 +186,203 @@ void Driver::loadBootConfig()
   {
     boost::property_tree::read_json( file_path, boot_config_ );
   }
+
+  // configure the queue of the bag writer thread
+  size_t queue_max_bytes              = boot_config_.get( "recorder.queue_max_bytes", 32*1024*1024 );
+  const std::string& overflow_policy  = boot_config_.get( "recorder.overflow_policy", std::string("block") );
+  recorder::GlobalRecorder::OverflowPolicy policy = recorder::GlobalRecorder::BLOCK;
+  if ( overflow_policy == "drop_oldest" )
+  {
+    policy = recorder::GlobalRecorder::DROP_OLDEST;
+  }
+  else if ( overflow_policy == "drop_newest" )
+  {
+    policy = recorder::GlobalRecorder::DROP_NEWEST;
+  }
+  else if ( overflow_policy != "block" )
+  {
+    std::cerr << BOLDRED << "Unknown recorder overflow policy " << overflow_policy << ", using block" << RESETCOLOR << std::endl;
+  }
+  recorder_->setWriteQueue( queue_max_bytes, policy );
+
+  // compression and rotation of the bags
+  const std::string& compression      = boot_config_.get( "recorder.compression", std::string("none") );
+  size_t split_size                   = boot_config_.get( "recorder.split_size", 0 ); // MB
+  double split_duration               = boot_config_.get( "recorder.split_duration", 0.0 ); // s
+  if ( compression == "lz4" )
+  {
+    recorder_->setCompression( rosbag::compression::LZ4 );
+  }
+  else if ( compression == "bz2" )
+  {
+    recorder_->setCompression( rosbag::compression::BZ2 );
+  }
+  else if ( compression != "none" )
+  {
+    std::cerr << BOLDRED << "Unknown bag compression " << compression << ", using none" << RESETCOLOR << std::endl;
+  }
+  recorder_->setRotation( static_cast<boost::uint64_t>(split_size)*1024*1024, split_duration );
+
+  // memory of the buffers used by minidump, shared between all the topics
+  size_t buffer_max_bytes             = boot_config_.get( "recorder.buffer_max_bytes", 128*1024*1024 );
+  size_t buffer_topic_bytes           = boot_config_.get( "recorder.buffer_topic_bytes", 4*1024*1024 );
+  std::map<std::string, size_t> buffers_bytes;
+  boost::optional<boost::property_tree::ptree&> buffers = boot_config_.get_child_optional( "recorder.buffers" );
+  if ( buffers )
+  {
+    for_each( const boost::property_tree::ptree::value_type& buffer, *buffers )
+    {
+      buffers_bytes[buffer.first] = buffer.second.get_value<size_t>();
+    }
+  }
+  recorder_->setBufferBudget( buffer_max_bytes, buffer_topic_bytes, buffers_bytes );
+
+  // keep those buffers in a file mapped in memory, to get them back after a crash
+  bool blackbox_enabled               = boot_config_.get( "recorder.blackbox.enabled", false );
+  std::string blackbox_file           = boot_config_.get( "recorder.blackbox.file", std::string() );
+  if ( blackbox_enabled )
+  {
+    if ( blackbox_file.empty() )
+    {
+      blackbox_file = boost::filesystem::current_path().string() + "/naoqi_driver.blackbox";
+    }
+    // room for the slice and channel headers on top of the buffers
+    recorder_->enableBlackBox( blackbox_file, buffer_max_bytes + 4*1024*1024 );
+  }
+
+  // bytes the bags may take in the working directory
+  boost::uint64_t storage_max_bytes   = boot_config_.get( "recorder.storage.max_bytes", static_cast<boost::uint64_t>(helpers::filesystem::folderMaximumSize) );
+  bool storage_evict_oldest           = boot_config_.get( "recorder.storage.evict_oldest", false );
+  recorder_->storage()->setQuota( storage_max_bytes, storage_evict_oldest );
+  recorder_->storage()->start();
 }
 
 void Driver::stopService() {
   stopRosLoop();
   converters_.clear();
+  suspended_.clear();
   subscribers_.clear();
   event_map_.clear();
+  audio_register_.reset();
 }
 
 
 void Driver::rosLoop()
 {
-  static std::vector<message_actions::MessageAction> actions;
-
+  // converters whose schedules are that close are processed in the same batch
+  static const ros::Duration batch_window( 0.005 );
+  static std::vector<ScheduledConverter> batch;
+  static std::vector<PendingConversion> pending;
+#ifdef NAOQI_DRIVER_CONVERTER_STATS
+  // usage when the request of each pending conversion was issued, and the part of the thread it took
+  static std::vector<tools::ThreadUsage> starts;
+  static std::vector<tools::ThreadUsage> costs;
+#endif
+
+  NAOQI_TRACE_THREAD_NAME( "ros loop" );
 //  ros::Time::init();
   while( keep_looping )
   {
-    // clear the callback triggers
-    actions.clear();
+    batch.clear();
+    pending.clear();
+#ifdef NAOQI_DRIVER_CONVERTER_STATS
+    starts.clear();
+    costs.clear();
+#endif
     {
       boost::mutex::scoped_lock lock( mutex_conv_queue_ );
+      resumeConverters();
       if (!conv_queue_.empty())
       {
-        // Wait for the next Publisher to be ready
-        size_t conv_index = conv_queue_.top().conv_index_;
-        converter::Converter& conv = converters_[conv_index];
-        ros::Time schedule = conv_queue_.top().schedule_;
-
-        // check the publishing condition
-        // 1. publishing enabled
-        // 2. has to be registered
-        // 3. has to be subscribed
-        PubConstIter pub_it = pub_map_.find( conv.name() );
-        if ( publish_enabled_ &&  pub_it != pub_map_.end() && pub_it->second.isSubscribed() )
+        // Take the next Publisher to be ready and all the ones due right after it
+        const ros::Time schedule = conv_queue_.top().schedule_;
+        while ( !conv_queue_.empty() && conv_queue_.top().schedule_ - schedule <= batch_window )
         {
-          actions.push_back(message_actions::PUBLISH);
+          batch.push_back( conv_queue_.top() );
+          conv_queue_.pop();
         }
+        NAOQI_TRACE_INSTANT( "scheduler", "wakeup" );
 
-        // check the recording condition
-        // 1. recording enabled
-        // 2. has to be registered
-        // 3. has to be subscribed (configured to be recorded)
-        RecConstIter rec_it = rec_map_.find( conv.name() );
+        // issue the requests of the whole batch at once,
+        // so that their round-trips to NAOqi overlap instead of adding up
+        for_each( const ScheduledConverter& scheduled, batch )
         {
-          boost::mutex::scoped_lock lock_record( mutex_record_, boost::try_to_lock );
-          if ( lock_record && record_enabled_ && rec_it != rec_map_.end() && rec_it->second.isSubscribed() )
+          converter::Converter& conv = converters_[scheduled.conv_index_];
+          pending.push_back( PendingConversion( scheduled.conv_index_ ) );
+          pending.back().idle_ = getActions( conv, pending.back().actions_ ) && pending.back().actions_.empty();
+#ifdef NAOQI_DRIVER_CONVERTER_STATS
+          starts.push_back( tools::ThreadUsage::now() );
+#endif
+
+          // only call when we have at least one action to perform
+          if ( !pending.back().actions_.empty() )
           {
-            actions.push_back(message_actions::RECORD);
+            NAOQI_TRACE_SCOPE( "fetch", conv.name() );
+            pending.back().data_ = conv.fetch();
           }
+#ifdef NAOQI_DRIVER_CONVERTER_STATS
+          costs.push_back( tools::ThreadUsage::now() - starts.back() );
+#endif
         }
 
-        // bufferize data in recorder
-        if ( log_enabled_ && rec_it != rec_map_.end() && conv.frequency() != 0)
-        {
-          actions.push_back(message_actions::LOG);
-        }
-
-        // only call when we have at least one action to perform
-        if (actions.size() >0)
+        // synchronous converters do their call here, while the asynchronous ones are in flight
+        for ( size_t i=0; i<pending.size(); ++i )
         {
-          conv.callAll( actions );
+          PendingConversion& conversion = pending[i];
+          if ( !conversion.actions_.empty() )
+          {
+            if ( conversion.data_.hasError() )
+            {
+              qiLogError() << "Exception caught in " << converters_[conversion.conv_index_].name() << ": " << conversion.data_.error();
+            }
+#ifdef NAOQI_DRIVER_CONVERTER_STATS
+            const tools::ThreadUsage before = tools::ThreadUsage::now();
+#endif
+            {
+              NAOQI_TRACE_SCOPE( "convert", converters_[conversion.conv_index_].name() );
+              converters_[conversion.conv_index_].convert( conversion.actions_, conversion.data_ );
+            }
+#ifdef NAOQI_DRIVER_CONVERTER_STATS
+            const tools::ThreadUsage after = tools::ThreadUsage::now();
+            costs[i] += after - before;
+            tools::ConverterStatistics::instance().record( converters_[conversion.conv_index_].name(), starts[i], costs[i], after );
+#endif
+          }
         }
 
         ros::Duration d( schedule - ros::Time::now() );
         if ( d > ros::Duration(0))
         {
+          NAOQI_TRACE_SCOPE( "scheduler", "sleep" );
           d.sleep();
         }
 
         // Schedule for a future time or not
-        conv_queue_.pop();
-        if ( conv.frequency() != 0 )
+        for ( size_t i=0; i<batch.size(); ++i )
         {
-          conv_queue_.push(ScheduledConverter(schedule + ros::Duration(1.0f / conv.frequency()), conv_index));
+          const ScheduledConverter& scheduled = batch[i];
+          const converter::Converter& conv = converters_[scheduled.conv_index_];
+          if ( conv.frequency() == 0 )
+          {
+            continue;
+          }
+          // nobody wants its data: it sleeps until woken up, instead of being called for nothing
+          if ( pending[i].idle_ )
+          {
+            NAOQI_TRACE_INSTANT( "suspend", conv.name() );
+            suspended_.push_back( scheduled.conv_index_ );
+          }
+          else
+          {
+            conv_queue_.push(ScheduledConverter(scheduled.schedule_ + ros::Duration(1.0f / conv.frequency()), scheduled.conv_index_));
+          }
         }
 
       }
       else // conv_queue is empty.
       {
-        // sleep one second
-        ros::Duration(1).sleep();
+        // the converters may all be suspended: spin often enough to hear of a new subscriber
+        ros::Duration(0.1).sleep();
       }
     } // mutex scope
 
@@ -246,26 +393,127 @@ void Driver::rosLoop()
   } // while loop
 }
 
-std::string Driver::minidump(const std::string& prefix)
+bool Driver::getActions( const converter::Converter& conv, std::vector<message_actions::MessageAction>& actions )
+{
+  // check the publishing condition
+  // 1. publishing enabled
+  // 2. has to be registered
+  // 3. has to be subscribed
+  bool decided = true;
+  PubConstIter pub_it = pub_map_.find( conv.name() );
+  if ( publish_enabled_ &&  pub_it != pub_map_.end() && pub_it->second.isSubscribed() )
+  {
+    actions.push_back(message_actions::PUBLISH);
+  }
+
+  // check the recording condition
+  // 1. recording enabled
+  // 2. has to be registered
+  // 3. has to be subscribed (configured to be recorded)
+  RecConstIter rec_it = rec_map_.find( conv.name() );
+  {
+    boost::mutex::scoped_lock lock_record( mutex_record_, boost::try_to_lock );
+    if ( !lock_record && rec_it != rec_map_.end() )
+    {
+      // a record is starting or stopping
+      decided = false;
+    }
+    if ( lock_record && record_enabled_ && rec_it != rec_map_.end() && rec_it->second.isSubscribed() )
+    {
+      actions.push_back(message_actions::RECORD);
+    }
+  }
+
+  // bufferize data in recorder
+  if ( log_enabled_ && rec_it != rec_map_.end() && conv.frequency() != 0)
+  {
+    actions.push_back(message_actions::LOG);
+  }
+  return decided;
+}
+
+void Driver::wakeConverter( const std::string& name )
+{
+  boost::mutex::scoped_lock lock( mutex_wake_ );
+  wake_requests_.push_back( name );
+}
+
+void Driver::wakeConverters()
+{
+  boost::mutex::scoped_lock lock( mutex_wake_ );
+  wake_all_ = true;
+}
+
+void Driver::resumeConverters()
+{
+  static std::vector<std::string> names;
+  bool all;
+  {
+    boost::mutex::scoped_lock lock( mutex_wake_ );
+    names.swap( wake_requests_ );
+    wake_requests_.clear();
+    all = wake_all_;
+    wake_all_ = false;
+  }
+  if ( suspended_.empty() || ( !all && names.empty() ) )
+  {
+    return;
+  }
+
+  const ros::Time now = ros::Time::now();
+  std::vector<size_t>::iterator it = suspended_.begin();
+  while ( it != suspended_.end() )
+  {
+    const converter::Converter& conv = converters_[*it];
+    if ( all || std::find( names.begin(), names.end(), conv.name() ) != names.end() )
+    {
+      NAOQI_TRACE_INSTANT( "resume", conv.name() );
+      conv_queue_.push( ScheduledConverter( now, *it ) );
+      it = suspended_.erase( it );
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+std::vector<std::string> Driver::getSuspendedConverters()
+{
+  boost::mutex::scoped_lock lock( mutex_conv_queue_ );
+  std::vector<std::string> names;
+  for_each( size_t conv_index, suspended_ )
+  {
+    names.push_back( converters_[conv_index].name() );
+  }
+  return names;
+}
+
+qi::Future<std::string> Driver::minidump(const std::string& prefix)
 {
   if (!log_enabled_)
   {
     const std::string& err = "Log is not enabled, please enable logging before calling minidump";
     std::cout << BOLDRED << err << std::endl
               << RESETCOLOR << std::endl;
-    return err;
+    return qi::Future<std::string>(err);
   }
 
   // CHECK SIZE IN FOLDER
-  long files_size = 0;
-  boost::filesystem::path folderPath(boost::filesystem::current_path());
-  helpers::filesystem::getFilesSize(folderPath, files_size);
-  if (files_size > helpers::filesystem::folderMaximumSize)
+  if (!recorder_->storage()->checkQuota())
   {
     std::cout << BOLDRED << "No more space on robot. You need to upload the presents bags and remove them to make new ones."
                  << std::endl << "To remove all the presents bags, you can run this command:" << std::endl
                     << "\t$ qicli call ROS-Driver.removeFiles" << RESETCOLOR << std::endl;
-    return "No more space on robot. You need to upload the presents bags and remove them to make new ones.";
+    return qi::Future<std::string>("No more space on robot. You need to upload the presents bags and remove them to make new ones.");
+  }
+
+  boost::mutex::scoped_lock lock_dump( mutex_dump_ );
+  if (dump_in_progress_)
+  {
+    const std::string& err = "A minidump is already being written, please wait for it to finish";
+    std::cout << BOLDRED << err << RESETCOLOR << std::endl;
+    return qi::Future<std::string>(err);
   }
 
   // IF A ROSBAG WAS OPENED, FIRST CLOSE IT
@@ -274,57 +522,48 @@ std::string Driver::minidump(const std::string& prefix)
     stopRecording();
   }
 
-  // STOP BUFFERIZING
-  log_enabled_ = false;
-  for(EventIter iterator = event_map_.begin(); iterator != event_map_.end(); iterator++)
-  {
-    iterator->second.isDumping(true);
-  }
+  // SNAPSHOT ALL BUFFERS, THEY KEEP BUFFERIZING MEANWHILE
+  NAOQI_TRACE_SCOPE( "minidump", "snapshot" );
   ros::Time time = ros::Time::now();
-
-  // START A NEW ROSBAG
-  boost::mutex::scoped_lock lock_record( mutex_record_ );
-  recorder_->startRecord(prefix);
-
-  // WRITE ALL BUFFER INTO THE ROSBAG
+  std::vector<recorder::DumpSnapshot> dumps;
   for(EventIter iterator = event_map_.begin(); iterator != event_map_.end(); iterator++)
   {
-    iterator->second.writeDump(time);
+    dumps.push_back( iterator->second.snapshot(time) );
   }
   for(RecIter iterator = rec_map_.begin(); iterator != rec_map_.end(); iterator++)
   {
-    iterator->second.writeDump(time);
+    dumps.push_back( iterator->second.snapshot(time) );
   }
 
-  // RESTART BUFFERIZING
-  log_enabled_ = true;
-  for(EventIter iterator = event_map_.begin(); iterator != event_map_.end(); iterator++)
-  {
-    iterator->second.isDumping(false);
-  }
-  return recorder_->stopRecord(::naoqi::ros_env::getROSIP("eth0"));
+  // WRITE THEM INTO A NEW ROSBAG IN THE BACKGROUND
+  return startDump(prefix, dumps);
 }
 
-std::string Driver::minidumpConverters(const std::string& prefix, const std::vector<std::string>& names)
+qi::Future<std::string> Driver::minidumpConverters(const std::string& prefix, const std::vector<std::string>& names)
 {
   if (!log_enabled_)
   {
     const std::string& err = "Log is not enabled, please enable logging before calling minidump";
     std::cout << BOLDRED << err << std::endl
               << RESETCOLOR << std::endl;
-    return err;
+    return qi::Future<std::string>(err);
   }
 
   // CHECK SIZE IN FOLDER
-  long files_size = 0;
-  boost::filesystem::path folderPath(boost::filesystem::current_path());
-  helpers::filesystem::getFilesSize(folderPath, files_size);
-  if (files_size > helpers::filesystem::folderMaximumSize)
+  if (!recorder_->storage()->checkQuota())
   {
     std::cout << BOLDRED << "No more space on robot. You need to upload the presents bags and remove them to make new ones."
                  << std::endl << "To remove all the presents bags, you can run this command:" << std::endl
                     << "\t$ qicli call ROS-Driver.removeFiles" << RESETCOLOR << std::endl;
-    return "No more space on robot. You need to upload the presents bags and remove them to make new ones.";
+    return qi::Future<std::string>("No more space on robot. You need to upload the presents bags and remove them to make new ones.");
+  }
+
+  boost::mutex::scoped_lock lock_dump( mutex_dump_ );
+  if (dump_in_progress_)
+  {
+    const std::string& err = "A minidump is already being written, please wait for it to finish";
+    std::cout << BOLDRED << err << RESETCOLOR << std::endl;
+    return qi::Future<std::string>(err);
   }
 
   // IF A ROSBAG WAS OPENED, FIRST CLOSE IT
@@ -333,60 +572,98 @@ std::string Driver::minidumpConverters(const std::string& prefix, const std::vec
     stopRecording();
   }
 
-  // STOP BUFFERIZING
-  log_enabled_ = false;
-  for(EventIter iterator = event_map_.begin(); iterator != event_map_.end(); iterator++)
-  {
-    iterator->second.isDumping(true);
-  }
+  // SNAPSHOT CHOOSEN BUFFERS, THEY KEEP BUFFERIZING MEANWHILE
+  NAOQI_TRACE_SCOPE( "minidump", "snapshot" );
   ros::Time time = ros::Time::now();
-
-  // WRITE CHOOSEN BUFFER INTO THE ROSBAG
-  boost::mutex::scoped_lock lock_record( mutex_record_ );
-
-  bool is_started = false;
+  std::vector<recorder::DumpSnapshot> dumps;
   for_each( const std::string& name, names)
   {
     RecIter it = rec_map_.find(name);
     if ( it != rec_map_.end() )
     {
-      if ( !is_started )
-      {
-        recorder_->startRecord(prefix);
-        is_started = true;
-      }
-      it->second.writeDump(time);
+      dumps.push_back( it->second.snapshot(time) );
     }
     else
     {
       EventIter it_event = event_map_.find(name);
       if ( it_event != event_map_.end() )
       {
-        if ( !is_started )
+        dumps.push_back( it_event->second.snapshot(time) );
+      }
+    }
+  }
+  if ( dumps.empty() )
+  {
+    std::cout << BOLDRED << "Could not find any topic in recorders" << RESETCOLOR << std::endl
+      << BOLDYELLOW << "To get the list of all available converter's name, please run:" << RESETCOLOR << std::endl
+      << GREEN << "\t$ qicli call ROS-Driver.getAvailableConverters" << RESETCOLOR << std::endl;
+    return qi::Future<std::string>("Could not find any topic in converters. To get the list of all available converter's name, please run: $ qicli call ROS-Driver.getAvailableConverters");
+  }
+
+  // WRITE THEM INTO A NEW ROSBAG IN THE BACKGROUND
+  return startDump(prefix, dumps);
+}
+
+qi::Future<std::string> Driver::startDump(const std::string& prefix, const std::vector<recorder::DumpSnapshot>& dumps)
+{
+  // the previous dump thread is over, dump_in_progress_ is false
+  if (dumpThread_.joinable())
+  {
+    dumpThread_.join();
+  }
+  dump_in_progress_ = true;
+  qi::Promise<std::string> promise;
+  dumpThread_ = boost::thread( &Driver::writeDump, this, prefix, dumps, promise );
+  return promise.future();
+}
+
+void Driver::writeDump(const std::string& prefix, const std::vector<recorder::DumpSnapshot>& dumps, qi::Promise<std::string> promise)
+{
+  NAOQI_TRACE_THREAD_NAME( "minidump" );
+  std::string result;
+  std::string error;
+  {
+    NAOQI_TRACE_SCOPE( "minidump", prefix );
+    // nobody can start a recording while the ROSbag is used by the dump
+    boost::mutex::scoped_lock lock_record( mutex_record_ );
+    bool is_opened = false;
+    // an exception must not escape this thread, it would terminate the driver
+    try
+    {
+      recorder_->startRecord(prefix);
+      is_opened = true;
+      recorder::writeSnapshots(recorder_, dumps);
+      is_opened = false;
+      result = recorder_->stopRecord(::naoqi::ros_env::getROSIP("eth0"));
+    }
+    catch ( const std::exception& e )
+    {
+      error = std::string("Could not write the minidump: ") + e.what();
+      std::cout << BOLDRED << error << RESETCOLOR << std::endl;
+      if ( is_opened )
+      {
+        try
+        {
+          recorder_->stopRecord(::naoqi::ros_env::getROSIP("eth0"));
+        }
+        catch ( const std::exception& e )
         {
-          recorder_->startRecord(prefix);
-          is_started = true;
+          std::cout << BOLDRED << "Could not close the minidump: " << e.what() << RESETCOLOR << std::endl;
         }
-        it_event->second.writeDump(time);
       }
     }
   }
-  // RESTART BUFFERIZING
-  log_enabled_ = true;
-  for(EventIter iterator = event_map_.begin(); iterator != event_map_.end(); iterator++)
   {
-    iterator->second.isDumping(false);
+    boost::mutex::scoped_lock lock_dump( mutex_dump_ );
+    dump_in_progress_ = false;
   }
-  if ( is_started )
+  if ( error.empty() )
   {
-    return recorder_->stopRecord(::naoqi::ros_env::getROSIP("eth0"));
+    promise.setValue(result);
   }
   else
   {
-    std::cout << BOLDRED << "Could not find any topic in recorders" << RESETCOLOR << std::endl
-      << BOLDYELLOW << "To get the list of all available converter's name, please run:" << RESETCOLOR << std::endl
-      << GREEN << "\t$ qicli call ROS-Driver.getAvailableConverters" << RESETCOLOR << std::endl;
-    return "Could not find any topic in converters. To get the list of all available converter's name, please run: $ qicli call ROS-Driver.getAvailableConverters";
+    promise.setError(error);
   }
 }
 
@@ -419,6 +696,8 @@ void Driver::registerConverter( converter::Converter& conv )
 
 void Driver::registerPublisher( const std::string& conv_name, publisher::Publisher& pub)
 {
+  // the converter may be suspended until someone subscribes
+  pub.onSubscribe( boost::bind( &Driver::wakeConverter, this, conv_name ) );
   if (publish_enabled_) {
     pub.reset(*nhPtr_);
   }
@@ -529,6 +808,22 @@ void Driver::registerDefaultConverter()
   tf2_buffer_.reset<tf2_ros::Buffer>( new tf2_ros::Buffer() );
   tf2_buffer_->setUsingDedicatedThread(true);
 
+  // play a ROSbag back instead of converting the data of NAOqi
+  const std::string& replay_file      = boot_config_.get( "replay.file", std::string() );
+  float replay_speed                  = boot_config_.get( "replay.speed", 1.f );
+  if ( !replay_file.empty() )
+  {
+    try
+    {
+      registerReplayConverters( replay_file, replay_speed );
+    }
+    catch ( const rosbag::BagException& e )
+    {
+      std::cerr << BOLDRED << "Cannot replay " << replay_file << ": " << e.what() << RESETCOLOR << std::endl;
+    }
+    return;
+  }
+
   // replace this with proper configuration struct
   bool info_enabled                   = boot_config_.get( "converters.info.enabled", true);
   size_t info_frequency               = boot_config_.get( "converters.info.frequency", 1);
@@ -579,6 +874,7 @@ void Driver::registerDefaultConverter()
 
   bool bumper_enabled                 = boot_config_.get( "converters.bumper.enabled", true);
   bool tactile_enabled                = boot_config_.get( "converters.tactile.enabled", true);
+
   /*
    * The info converter will be called once after it was added to the priority queue. Once it is its turn to be called, its
    * callAll method will be triggered (because InfoPublisher is considered to always have subscribers, isSubscribed always
@@ -603,7 +899,13 @@ void Driver::registerDefaultConverter()
   /** LOGS */
   if ( logs_enabled )
   {
-    boost::shared_ptr<converter::LogConverter> lc = boost::make_shared<converter::LogConverter>( "log", logs_frequency, sessionPtr_);
+    tools::LogFilterConfig logs_filter;
+    boost::optional<boost::property_tree::ptree&> logs_config = boot_config_.get_child_optional( "converters.logs" );
+    if ( logs_config )
+    {
+      logs_filter = converter::LogConverter::readFilter( *logs_config );
+    }
+    boost::shared_ptr<converter::LogConverter> lc = boost::make_shared<converter::LogConverter>( "log", logs_frequency, sessionPtr_, logs_filter );
     boost::shared_ptr<publisher::LogPublisher> lp = boost::make_shared<publisher::LogPublisher>( "/rosout" );
     lc->registerCallback( message_actions::PUBLISH, boost::bind(&publisher::LogPublisher::publish, lp, _1) );
     registerPublisher( lc, lp );
@@ -621,6 +923,19 @@ void Driver::registerDefaultConverter()
     registerConverter( dc, dp, dr );
   }
 
+#ifdef NAOQI_DRIVER_RPC_STATS
+  /** RPC STATISTICS */
+  bool rpc_statistics_enabled         = boot_config_.get( "converters.rpc_statistics.enabled", true);
+  size_t rpc_statistics_frequency     = boot_config_.get( "converters.rpc_statistics.frequency", 1);
+  if ( rpc_statistics_enabled )
+  {
+    boost::shared_ptr<converter::RpcStatisticsConverter> rsc = boost::make_shared<converter::RpcStatisticsConverter>( "rpc_statistics", rpc_statistics_frequency, sessionPtr_);
+    boost::shared_ptr<publisher::BasicPublisher<diagnostic_msgs::DiagnosticArray> > rsp = boost::make_shared<publisher::BasicPublisher<diagnostic_msgs::DiagnosticArray> >( "rpc_statistics" );
+    rsc->registerCallback( message_actions::PUBLISH, boost::bind(&publisher::BasicPublisher<diagnostic_msgs::DiagnosticArray>::publish, rsp, _1) );
+    registerPublisher( rsc, rsp );
+  }
+#endif
+
   /** IMU TORSO **/
   if ( imu_torso_enabled )
   {
@@ -630,6 +945,9 @@ void Driver::registerDefaultConverter()
     imutc->registerCallback( message_actions::PUBLISH, boost::bind(&publisher::BasicPublisher<sensor_msgs::Imu>::publish, imutp, _1) );
     imutc->registerCallback( message_actions::RECORD, boost::bind(&recorder::BasicRecorder<sensor_msgs::Imu>::write, imutr, _1) );
     imutc->registerCallback( message_actions::LOG, boost::bind(&recorder::BasicRecorder<sensor_msgs::Imu>::bufferize, imutr, _1) );
+    imutc->registerSerializedCallback( message_actions::PUBLISH, boost::bind(&publisher::BasicPublisher<sensor_msgs::Imu>::publishSerialized, imutp, _1) );
+    imutc->registerSerializedCallback( message_actions::RECORD, boost::bind(&recorder::BasicRecorder<sensor_msgs::Imu>::writeSerialized, imutr, _1, _2) );
+    imutc->registerSerializedCallback( message_actions::LOG, boost::bind(&recorder::BasicRecorder<sensor_msgs::Imu>::bufferizeSerialized, imutr, _1, _2) );
     registerConverter( imutc, imutp, imutr );
   }
 
@@ -644,6 +962,9 @@ void Driver::registerDefaultConverter()
       imubc->registerCallback( message_actions::PUBLISH, boost::bind(&publisher::BasicPublisher<sensor_msgs::Imu>::publish, imubp, _1) );
       imubc->registerCallback( message_actions::RECORD, boost::bind(&recorder::BasicRecorder<sensor_msgs::Imu>::write, imubr, _1) );
       imubc->registerCallback( message_actions::LOG, boost::bind(&recorder::BasicRecorder<sensor_msgs::Imu>::bufferize, imubr, _1) );
+      imubc->registerSerializedCallback( message_actions::PUBLISH, boost::bind(&publisher::BasicPublisher<sensor_msgs::Imu>::publishSerialized, imubp, _1) );
+      imubc->registerSerializedCallback( message_actions::RECORD, boost::bind(&recorder::BasicRecorder<sensor_msgs::Imu>::writeSerialized, imubr, _1, _2) );
+      imubc->registerSerializedCallback( message_actions::LOG, boost::bind(&recorder::BasicRecorder<sensor_msgs::Imu>::bufferizeSerialized, imubr, _1, _2) );
       registerConverter( imubc, imubp, imubr );
     }
   } // endif PEPPER
@@ -657,6 +978,8 @@ void Driver::registerDefaultConverter()
     fcc->registerCallback( message_actions::PUBLISH, boost::bind(&publisher::CameraPublisher::publish, fcp, _1, _2) );
     fcc->registerCallback( message_actions::RECORD, boost::bind(&recorder::CameraRecorder::write, fcr, _1, _2) );
     fcc->registerCallback( message_actions::LOG, boost::bind(&recorder::CameraRecorder::bufferize, fcr, _1, _2) );
+    fcc->registerSerializedCallback( message_actions::RECORD, boost::bind(&recorder::CameraRecorder::writeSerialized, fcr, _1, _2, _3) );
+    fcc->registerSerializedCallback( message_actions::LOG, boost::bind(&recorder::CameraRecorder::bufferizeSerialized, fcr, _1, _2, _3) );
     registerConverter( fcc, fcp, fcr );
   }
 
@@ -669,6 +992,8 @@ void Driver::registerDefaultConverter()
     bcc->registerCallback( message_actions::PUBLISH, boost::bind(&publisher::CameraPublisher::publish, bcp, _1, _2) );
     bcc->registerCallback( message_actions::RECORD, boost::bind(&recorder::CameraRecorder::write, bcr, _1, _2) );
     bcc->registerCallback( message_actions::LOG, boost::bind(&recorder::CameraRecorder::bufferize, bcr, _1, _2) );
+    bcc->registerSerializedCallback( message_actions::RECORD, boost::bind(&recorder::CameraRecorder::writeSerialized, bcr, _1, _2, _3) );
+    bcc->registerSerializedCallback( message_actions::LOG, boost::bind(&recorder::CameraRecorder::bufferizeSerialized, bcr, _1, _2, _3) );
     registerConverter( bcc, bcp, bcr );
   }
 
@@ -684,6 +1009,8 @@ void Driver::registerDefaultConverter()
       dcc->registerCallback( message_actions::PUBLISH, boost::bind(&publisher::CameraPublisher::publish, dcp, _1, _2) );
       dcc->registerCallback( message_actions::RECORD, boost::bind(&recorder::CameraRecorder::write, dcr, _1, _2) );
       dcc->registerCallback( message_actions::LOG, boost::bind(&recorder::CameraRecorder::bufferize, dcr, _1, _2) );
+      dcc->registerSerializedCallback( message_actions::RECORD, boost::bind(&recorder::CameraRecorder::writeSerialized, dcr, _1, _2, _3) );
+      dcc->registerSerializedCallback( message_actions::LOG, boost::bind(&recorder::CameraRecorder::bufferizeSerialized, dcr, _1, _2, _3) );
       registerConverter( dcc, dcp, dcr );
     }
 
@@ -696,6 +1023,8 @@ void Driver::registerDefaultConverter()
       icc->registerCallback( message_actions::PUBLISH, boost::bind(&publisher::CameraPublisher::publish, icp, _1, _2) );
       icc->registerCallback( message_actions::RECORD, boost::bind(&recorder::CameraRecorder::write, icr, _1, _2) );
       icc->registerCallback( message_actions::LOG, boost::bind(&recorder::CameraRecorder::bufferize, icr, _1, _2) );
+      icc->registerSerializedCallback( message_actions::RECORD, boost::bind(&recorder::CameraRecorder::writeSerialized, icr, _1, _2, _3) );
+      icc->registerSerializedCallback( message_actions::LOG, boost::bind(&recorder::CameraRecorder::bufferizeSerialized, icr, _1, _2, _3) );
       registerConverter( icc, icp, icr );
     }
   } // endif PEPPER
@@ -706,10 +1035,14 @@ void Driver::registerDefaultConverter()
     boost::shared_ptr<publisher::JointStatePublisher> jsp = boost::make_shared<publisher::JointStatePublisher>( "/joint_states" );
     boost::shared_ptr<recorder::JointStateRecorder> jsr = boost::make_shared<recorder::JointStateRecorder>( "/joint_states" );
     boost::shared_ptr<converter::JointStateConverter> jsc = boost::make_shared<converter::JointStateConverter>( "joint_states", joint_states_frequency, tf2_buffer_, sessionPtr_ );
-    jsc->registerCallback( message_actions::PUBLISH, boost::bind(&publisher::JointStatePublisher::publish, jsp, _1, _2) );
+    jsc->registerSharedCallback( message_actions::PUBLISH, boost::bind(&publisher::JointStatePublisher::publishShared, jsp, _1, _2) );
     jsc->registerCallback( message_actions::RECORD, boost::bind(&recorder::JointStateRecorder::write, jsr, _1, _2) );
     jsc->registerCallback( message_actions::LOG, boost::bind(&recorder::JointStateRecorder::bufferize, jsr, _1, _2) );
+    jsc->registerSerializedCallback( message_actions::RECORD, boost::bind(&recorder::JointStateRecorder::writeSerialized, jsr, _1, _2, _3) );
+    jsc->registerSerializedCallback( message_actions::LOG, boost::bind(&recorder::JointStateRecorder::bufferizeSerialized, jsr, _1, _2, _3) );
     registerConverter( jsc, jsp, jsr );
+    // the segments are read from the robot description when the converter is reset
+    jsr->setFixedFrames( jsc->fixedFrames() );
     //  registerRecorder(jsc, jsr);
   }
 
@@ -724,6 +1057,9 @@ void Driver::registerDefaultConverter()
       lc->registerCallback( message_actions::PUBLISH, boost::bind(&publisher::BasicPublisher<sensor_msgs::LaserScan>::publish, lp, _1) );
       lc->registerCallback( message_actions::RECORD, boost::bind(&recorder::BasicRecorder<sensor_msgs::LaserScan>::write, lr, _1) );
       lc->registerCallback( message_actions::LOG, boost::bind(&recorder::BasicRecorder<sensor_msgs::LaserScan>::bufferize, lr, _1) );
+      lc->registerSerializedCallback( message_actions::PUBLISH, boost::bind(&publisher::BasicPublisher<sensor_msgs::LaserScan>::publishSerialized, lp, _1) );
+      lc->registerSerializedCallback( message_actions::RECORD, boost::bind(&recorder::BasicRecorder<sensor_msgs::LaserScan>::writeSerialized, lr, _1, _2) );
+      lc->registerSerializedCallback( message_actions::LOG, boost::bind(&recorder::BasicRecorder<sensor_msgs::LaserScan>::bufferizeSerialized, lr, _1, _2) );
       registerConverter( lc, lp, lr );
     }
   }
@@ -753,9 +1089,23 @@ void Driver::registerDefaultConverter()
 
   if ( audio_enabled ) {
     /** Audio */
+    // several topics can be made out of the one subscription to ALAudioDevice
+    std::vector<AudioProfile> audio_profiles;
+    boost::optional<boost::property_tree::ptree&> profiles = boot_config_.get_child_optional( "converters.audio.profiles" );
+    if ( profiles )
+    {
+      audio_profiles = AudioEventRegister::readProfiles( *profiles );
+    }
+    tools::VoiceActivityConfig audio_vad;
+    boost::optional<boost::property_tree::ptree&> vad = boot_config_.get_child_optional( "converters.audio.vad" );
+    if ( vad )
+    {
+      audio_vad = AudioEventRegister::readVoiceActivity( *vad );
+    }
     boost::shared_ptr<AudioEventRegister> event_register =
-        boost::make_shared<AudioEventRegister>( "audio", 0, sessionPtr_ );
+        boost::make_shared<AudioEventRegister>( "audio", 0, sessionPtr_, audio_profiles, audio_vad );
     insertEventConverter("audio", event_register);
+    audio_register_ = event_register;
     if (keep_looping) {
       event_map_.find("audio")->second.startProcess();
     }
@@ -804,6 +1154,43 @@ void Driver::registerDefaultConverter()
 
 }
 
+void Driver::registerReplayConverters( const std::string& path, float speed )
+{
+  rosbag::Bag bag( path );
+  rosbag::View view( bag );
+  replay_clock_ = boost::make_shared<converter::ReplayClock>( view.getBeginTime(), speed );
+  const double duration = ( view.getEndTime() - view.getBeginTime() ).toSec();
+
+  std::map<std::string, const rosbag::ConnectionInfo*> topics;
+  for_each( const rosbag::ConnectionInfo* connection, view.getConnections() )
+  {
+    topics.insert( std::make_pair( connection->topic, connection ) );
+  }
+
+  typedef std::map<std::string, const rosbag::ConnectionInfo*>::const_iterator TopicIter;
+  for ( TopicIter it = topics.begin(); it != topics.end(); ++it )
+  {
+    // a topic ticks at its rate in the bag, each tick sends the messages that are due;
+    // at maximum speed, it sends one message per tick and the ROS loop never sleeps
+    float frequency = 10000.f;
+    if ( speed > 0 )
+    {
+      rosbag::View topic_view( bag, rosbag::TopicQuery( it->first ) );
+      frequency = duration > 0 ? std::max( 1.f, static_cast<float>( topic_view.size() / duration * speed ) ) : 1.f;
+    }
+    boost::shared_ptr<const tools::MessageType> type = converter::ReplayConverter::messageType( *it->second );
+    boost::shared_ptr<publisher::ReplayPublisher> rp = boost::make_shared<publisher::ReplayPublisher>( it->first, type );
+    boost::shared_ptr<recorder::ReplayRecorder> rr = boost::make_shared<recorder::ReplayRecorder>( it->first, type );
+    boost::shared_ptr<converter::ReplayConverter> rc = boost::make_shared<converter::ReplayConverter>( path, it->first, frequency, replay_clock_, sessionPtr_ );
+    rc->registerCallback( message_actions::PUBLISH, boost::bind(&publisher::ReplayPublisher::publish, rp, _1) );
+    rc->registerCallback( message_actions::RECORD, boost::bind(&recorder::ReplayRecorder::write, rr, _1) );
+    rc->registerCallback( message_actions::LOG, boost::bind(&recorder::ReplayRecorder::bufferize, rr, _1) );
+    registerConverter( rc, rp, rr );
+  }
+  std::cout << HIGHGREEN << "Replaying " << topics.size() << " topics of "
+            << BOLDCYAN << path << RESETCOLOR << HIGHGREEN << " at speed " << speed << RESETCOLOR << std::endl;
+}
+
 // public interface here
 void Driver::registerSubscriber( subscriber::Subscriber sub )
 {
@@ -946,6 +1333,7 @@ void Driver::setMasterURINet( const std::string& uri, const std::string& network
 void Driver::startPublishing()
 {
   publish_enabled_ = true;
+  wakeConverters();
   for(EventIter iterator = event_map_.begin(); iterator != event_map_.end(); iterator++)
   {
     iterator->second.isPublishing(true);
@@ -979,13 +1367,25 @@ std::vector<std::string> Driver::getSubscribedPublishers() const
 
 void Driver::startRecording()
 {
+  // the ROSbag of a minidump is never shared with a record
+  boost::mutex::scoped_lock lock_dump( mutex_dump_ );
+  if (dump_in_progress_)
+  {
+    std::cout << BOLDRED << "Cannot start recording while a minidump is being written" << RESETCOLOR << std::endl;
+    return;
+  }
   boost::mutex::scoped_lock lock_record( mutex_record_ );
-  recorder_->startRecord();
+  // a running record only gets its topics subscribed again
+  if ( !recorder_->isStarted() )
+  {
+    recorder_->startRecord();
+  }
   for_each( converter::Converter& conv, converters_ )
   {
     RecIter it = rec_map_.find(conv.name());
     if ( it != rec_map_.end() )
     {
+      it->second.setProfile( recorder::RecordProfile() );
       it->second.subscribe(true);
       std::cout << HIGHGREEN << "Topic "
                 << BOLDCYAN << conv.name() << RESETCOLOR
@@ -994,23 +1394,80 @@ void Driver::startRecording()
   }
   for(EventIter iterator = event_map_.begin(); iterator != event_map_.end(); iterator++)
   {
+    iterator->second.setProfile( recorder::RecordProfile() );
     iterator->second.isRecording(true);
     std::cout << HIGHGREEN << "Topic "
               << BOLDCYAN << iterator->first << RESETCOLOR
               << HIGHGREEN << " is subscribed for recording" << RESETCOLOR << std::endl;
   }
   record_enabled_ = true;
+  wakeConverters();
 }
 
 void Driver::startRecordingConverters(const std::vector<std::string>& names)
 {
+  startRecordingConvertersProfile(names, std::string());
+}
+
+void Driver::startRecordingConvertersProfile(const std::vector<std::string>& names, const std::string& profile)
+{
+  // the profiles are parsed before anything is started, a typo does not leave a half started record
+  std::map<std::string, recorder::RecordProfile> profiles;
+  if ( !profile.empty() )
+  {
+    boost::property_tree::ptree tree;
+    std::istringstream stream( profile );
+    try
+    {
+      boost::property_tree::read_json( stream, tree );
+    }
+    catch ( const boost::property_tree::json_parser_error& e )
+    {
+      std::cout << BOLDRED << "Could not parse the record profile: " << e.what() << RESETCOLOR << std::endl;
+      return;
+    }
+    for_each( const boost::property_tree::ptree::value_type& topic, tree )
+    {
+      recorder::RecordProfile& p = profiles[topic.first];
+      p.decimation = std::max( 1, topic.second.get( "decimation", 1 ) );
+      p.max_rate = topic.second.get( "max_rate", 0.f );
+      p.window_start = topic.second.get( "window_start", 0.f );
+      p.window_end = topic.second.get( "window_end", 0.f );
+      boost::optional<const boost::property_tree::ptree&> window = topic.second.get_child_optional( "window" );
+      if ( window && window->size() == 2 )
+      {
+        p.window_start = window->front().second.get_value<float>();
+        p.window_end = window->back().second.get_value<float>();
+      }
+      boost::optional<const boost::property_tree::ptree&> strip = topic.second.get_child_optional( "strip" );
+      if ( strip )
+      {
+        for_each( const boost::property_tree::ptree::value_type& part, *strip )
+        {
+          p.strip.insert( part.second.get_value<std::string>() );
+        }
+      }
+    }
+  }
+
+  // the ROSbag of a minidump is never shared with a record
+  boost::mutex::scoped_lock lock_dump( mutex_dump_ );
+  if (dump_in_progress_)
+  {
+    std::cout << BOLDRED << "Cannot start recording while a minidump is being written" << RESETCOLOR << std::endl;
+    return;
+  }
   boost::mutex::scoped_lock lock_record( mutex_record_ );
 
-  bool is_started = false;
+  // a running record only gets the new topics subscribed
+  bool is_started = recorder_->isStarted();
+  bool has_topic = false;
   for_each( const std::string& name, names)
   {
     RecIter it_rec = rec_map_.find(name);
     EventIter it_ev = event_map_.find(name);
+    // a topic missing from the profile is recorded as is
+    const recorder::RecordProfile& topic_profile = profiles[name];
     if ( it_rec != rec_map_.end() )
     {
       if ( !is_started )
@@ -1018,6 +1475,8 @@ void Driver::startRecordingConverters(const std::vector<std::string>& names)
         recorder_->startRecord();
         is_started = true;
       }
+      has_topic = true;
+      it_rec->second.setProfile( topic_profile );
       it_rec->second.subscribe(true);
       std::cout << HIGHGREEN << "Topic "
         << BOLDCYAN << name << RESETCOLOR
@@ -1030,6 +1489,8 @@ void Driver::startRecordingConverters(const std::vector<std::string>& names)
         recorder_->startRecord();
         is_started = true;
       }
+      has_topic = true;
+      it_ev->second.setProfile( topic_profile );
       it_ev->second.isRecording(true);
       std::cout << HIGHGREEN << "Topic "
         << BOLDCYAN << name << RESETCOLOR
@@ -1044,9 +1505,10 @@ void Driver::startRecordingConverters(const std::vector<std::string>& names)
         << GREEN << "\t$ qicli call ROS-Driver.getAvailableConverters" << RESETCOLOR << std::endl;
     }
   }
-  if ( is_started )
+  if ( has_topic )
   {
     record_enabled_ = true;
+    wakeConverters();
   }
   else
   {
@@ -1078,6 +1540,7 @@ std::string Driver::stopRecording()
 void Driver::startLogging()
 {
   log_enabled_ = true;
+  wakeConverters();
 }
 
 void Driver::stopLogging()
@@ -1087,14 +1550,15 @@ void Driver::stopLogging()
 
 void Driver::startRosLoop()
 {
+  // set before the thread starts, otherwise a restarted loop could exit right away
+  keep_looping = true;
+  // Create the publishing thread if needed
   if (publisherThread_.get_id() ==  boost::thread::id())
     publisherThread_ = boost::thread( &Driver::rosLoop, this );
   for(EventIter iterator = event_map_.begin(); iterator != event_map_.end(); iterator++)
   {
     iterator->second.startProcess();
   }
-  // Create the publishing thread if needed
-  keep_looping = true;
 }
 
 void Driver::stopRosLoop()
@@ -1272,32 +1736,254 @@ bool Driver::registerEventConverter(const std::string& key, const dataType::Data
   return true;
 }
 
-std::vector<std::string> Driver::getFilesList()
+std::vector<std::string> Driver::getRpcStatistics()
 {
-  std::vector<std::string> fileNames;
-  boost::filesystem::path folderPath( boost::filesystem::current_path() );
-  std::vector<boost::filesystem::path> files;
-  helpers::filesystem::getFiles(folderPath, ".bag", files);
+#ifdef NAOQI_DRIVER_RPC_STATS
+  return tools::RpcStatistics::instance().summary();
+#else
+  return std::vector<std::string>(1, "RPC statistics are not compiled in, rebuild with -DNAOQI_DRIVER_RPC_STATS=ON");
+#endif
+}
 
-  for (std::vector<boost::filesystem::path>::const_iterator it=files.begin();
-       it!=files.end(); it++)
+void Driver::resetRpcStatistics()
+{
+  tools::RpcStatistics::instance().reset();
+}
+
+std::vector<std::string> Driver::getConverterStatistics()
+{
+#ifdef NAOQI_DRIVER_CONVERTER_STATS
+  return tools::ConverterStatistics::instance().summary();
+#else
+  return std::vector<std::string>(1, "Converter statistics are not compiled in, rebuild with -DNAOQI_DRIVER_CONVERTER_STATS=ON");
+#endif
+}
+
+void Driver::resetConverterStatistics()
+{
+  tools::ConverterStatistics::instance().reset();
+}
+
+std::string Driver::dumpTrace(const std::string& path)
+{
+#ifdef NAOQI_DRIVER_TRACE
+  const std::string& file = path.empty() ? boost::filesystem::current_path().string() + "/naoqi_driver.trace.json" : path;
+  try
   {
-    fileNames.push_back(it->string());
+    const size_t count = tools::Trace::dump( file );
+    std::cout << YELLOW << count << " trace events written in " << BOLDCYAN << file << RESETCOLOR << std::endl;
+    return file;
   }
-  return fileNames;
+  catch ( const std::exception& e )
+  {
+    std::cout << BOLDRED << e.what() << RESETCOLOR << std::endl;
+    return e.what();
+  }
+#else
+  return "Tracing is not compiled in, rebuild with -DNAOQI_DRIVER_TRACE=ON";
+#endif
 }
 
-void Driver::removeAllFiles()
+std::vector<std::string> Driver::getRecorderStatistics()
+{
+  std::vector<std::string> lines;
+  std::ostringstream line;
+  line << "queue_depth=" << recorder_->queueDepth();
+  lines.push_back( line.str() );
+  line.str("");
+  line << "bytes_written=" << recorder_->bytesWritten();
+  lines.push_back( line.str() );
+  line.str("");
+  line << "dropped_messages=" << recorder_->droppedMessages();
+  lines.push_back( line.str() );
+  line.str("");
+  line << "failed_messages=" << recorder_->failedMessages();
+  lines.push_back( line.str() );
+  line.str("");
+  line << "buffer_bytes_reserved=" << recorder_->bufferBytesReserved();
+  lines.push_back( line.str() );
+  line.str("");
+  line << "storage_bytes=" << recorder_->storage()->totalBytes();
+  lines.push_back( line.str() );
+  return lines;
+}
+
+std::string Driver::recoverBlackBox()
 {
-  boost::filesystem::path folderPath( boost::filesystem::current_path() );
-  std::vector<boost::filesystem::path> files;
-  helpers::filesystem::getFiles(folderPath, ".bag", files);
+  // the ROSbag of the recovery must not be shared with a record or a minidump started meanwhile
+  boost::mutex::scoped_lock lock_dump( mutex_dump_ );
+  if (dump_in_progress_)
+  {
+    const std::string& err = "A minidump is being written, please wait for it to finish before recovering the black box";
+    std::cout << BOLDRED << err << RESETCOLOR << std::endl;
+    return err;
+  }
+  boost::mutex::scoped_lock lock_record( mutex_record_ );
+  return recorder_->recoverBlackBox();
+}
 
-  for (std::vector<boost::filesystem::path>::const_iterator it=files.begin();
-       it!=files.end(); it++)
+bool Driver::startReplay(const std::string& path, float speed)
+{
+  // the bag is checked before the converters are dropped
+  try
   {
-    std::remove(it->c_str());
+    rosbag::Bag bag( path );
   }
+  catch ( const rosbag::BagException& e )
+  {
+    std::cout << BOLDRED << "Cannot replay " << path << ": " << e.what() << RESETCOLOR << std::endl;
+    return false;
+  }
+
+  // no minidump may start while the recorders are replaced
+  boost::mutex::scoped_lock lock_dump( mutex_dump_ );
+  if (dump_in_progress_)
+  {
+    std::cout << BOLDRED << "Cannot replay " << path << " while a minidump is being written" << RESETCOLOR << std::endl;
+    return false;
+  }
+
+  if (record_enabled_)
+  {
+    stopRecording();
+  }
+  stopRosLoop();
+  {
+    // the other qi calls iterate these containers
+    boost::mutex::scoped_lock lock( mutex_conv_queue_ );
+    boost::mutex::scoped_lock lock_record( mutex_record_ );
+    converters_.clear();
+    conv_queue_ = std::priority_queue<ScheduledConverter>();
+    suspended_.clear();
+    pub_map_.clear();
+    rec_map_.clear();
+    event_map_.clear();
+    audio_register_.reset();
+  }
+
+  registerReplayConverters( path, speed );
+  startRosLoop();
+  return true;
+}
+
+std::vector<std::string> Driver::getReplayStatistics()
+{
+  if ( !replay_clock_ )
+  {
+    return std::vector<std::string>(1, "No ROSbag is replayed");
+  }
+  return replay_clock_->summary();
+}
+
+std::vector<std::string> Driver::getAudioStatistics()
+{
+  if ( !audio_register_ )
+  {
+    return std::vector<std::string>(1, "Audio is not enabled");
+  }
+  std::vector<std::string> lines;
+  std::ostringstream line;
+  line << "frames_received=" << audio_register_->framesReceived();
+  lines.push_back( line.str() );
+  line.str("");
+  line << "overruns=" << audio_register_->overruns();
+  lines.push_back( line.str() );
+  line.str("");
+  line << "queue_depth=" << audio_register_->queueDepth() << "/" << audio_register_->queueCapacity();
+  lines.push_back( line.str() );
+  line.str("");
+  line << "max_queue_depth=" << audio_register_->maxQueueDepth();
+  lines.push_back( line.str() );
+  line.str("");
+  line << "pooled_messages=" << audio_register_->pooledMessages();
+  lines.push_back( line.str() );
+  line.str("");
+  line << "voice_frames=" << audio_register_->voiceFrames();
+  lines.push_back( line.str() );
+  return lines;
+}
+
+std::vector<std::string> Driver::getLogStatistics()
+{
+  std::vector<std::string> lines;
+  std::ostringstream line;
+  line << "logs_received=" << converter::LogConverter::receivedLogs();
+  lines.push_back( line.str() );
+  line.str("");
+  line << "logs_dropped=" << converter::LogConverter::droppedLogs();
+  lines.push_back( line.str() );
+  line.str("");
+  line << "logs_pending=" << converter::LogConverter::pendingLogs();
+  lines.push_back( line.str() );
+  line.str("");
+  line << "logs_filtered=" << converter::LogConverter::filteredLogs();
+  lines.push_back( line.str() );
+  line.str("");
+  line << "logs_suppressed=" << converter::LogConverter::suppressedLogs();
+  lines.push_back( line.str() );
+  return lines;
+}
+
+std::string Driver::decodeAudioBag(const std::string& path)
+{
+  const std::string suffix = "/compressed";
+  const size_t extension = path.rfind( ".bag" );
+  const std::string output = path.substr( 0, extension ) + "_decoded.bag";
+  size_t decoded = 0;
+  size_t corrupted = 0;
+  try
+  {
+    rosbag::Bag in( path );
+    rosbag::Bag out( output, rosbag::bagmode::Write );
+    rosbag::View view( in );
+    naoqi_bridge_msgs::AudioBuffer audio;
+    for ( rosbag::View::iterator it = view.begin(); it != view.end(); ++it )
+    {
+      const rosbag::MessageInstance& m = *it;
+      if ( m.getDataType() != ros::message_traits::datatype<tools::CompressedAudioBuffer>() )
+      {
+        out.write( m.getTopic(), m.getTime(), m, m.getConnectionHeader() );
+        continue;
+      }
+      boost::shared_ptr<tools::CompressedAudioBuffer> compressed = m.instantiate<tools::CompressedAudioBuffer>();
+      if ( !compressed || !tools::decompressAudio( *compressed, audio ) )
+      {
+        ++corrupted;
+        continue;
+      }
+      // back on the topic it was compressed from
+      std::string topic = m.getTopic();
+      if ( topic.size() > suffix.size() && topic.compare( topic.size() - suffix.size(), suffix.size(), suffix ) == 0 )
+      {
+        topic.erase( topic.size() - suffix.size() );
+      }
+      out.write( topic, m.getTime(), audio );
+      ++decoded;
+    }
+  }
+  catch ( const rosbag::BagException& e )
+  {
+    std::cout << BOLDRED << "Cannot decode the audio of " << path << ": " << e.what() << RESETCOLOR << std::endl;
+    return std::string( "Cannot decode the audio of " ) + path + ": " + e.what();
+  }
+  std::cout << YELLOW << decoded << " audio messages decoded";
+  if ( corrupted > 0 )
+  {
+    std::cout << ", " << BOLDRED << corrupted << " corrupted ones skipped" << YELLOW;
+  }
+  std::cout << " in " << BOLDCYAN << output << RESETCOLOR << std::endl;
+  return output;
+}
+
+std::vector<std::string> Driver::getFilesList()
+{
+  // the bags of the current record are listed too, even if they are not all in the folder yet
+  return recorder_->storage()->files();
+}
+
+void Driver::removeAllFiles()
+{
+  recorder_->storage()->removeAll();
 }
 
 void Driver::removeFiles(std::vector<std::string> files)
@@ -1305,7 +1991,7 @@ void Driver::removeFiles(std::vector<std::string> files)
   for (std::vector<std::string>::const_iterator it=files.begin();
        it!=files.end(); it++)
   {
-    std::remove(it->c_str());
+    recorder_->storage()->remove(*it);
   }
 }
 
@@ -1322,14 +2008,28 @@ QI_REGISTER_OBJECT( Driver,
                     setMasterURINet,
                     getAvailableConverters,
                     getSubscribedPublishers,
+                    getSuspendedConverters,
                     addMemoryConverters,
                     registerMemoryConverter,
                     registerEventConverter,
                     getFilesList,
+                    getRpcStatistics,
+                    resetRpcStatistics,
+                    getConverterStatistics,
+                    resetConverterStatistics,
+                    dumpTrace,
+                    getRecorderStatistics,
+                    recoverBlackBox,
+                    startReplay,
+                    getReplayStatistics,
+                    getAudioStatistics,
+                    getLogStatistics,
+                    decodeAudioBag,
                     removeAllFiles,
                     removeFiles,
                     startRecording,
                     startRecordingConverters,
+                    startRecordingConvertersProfile,
                     stopRecording,
                     startLogging,
                     stopLogging );
@@ -20,6 +20,18 @@
 
 #include <string>
 
+/*
+* LOCAL includes
+*/
+#include "../tools/serialized_message.hpp"
+#include "subscriber_status.hpp"
+
+/*
+* BOOST includes
+*/
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
 /*
 * ROS includes
 */
@@ -37,7 +49,8 @@ class BasicPublisher
 public:
   BasicPublisher( const std::string& topic ):
     topic_( topic ),
-    is_initialized_( false )
+    is_initialized_( false ),
+    status_( boost::make_shared<SubscriberStatus>() )
   {}
 
   virtual ~BasicPublisher() {}
@@ -55,7 +68,13 @@ public:
   virtual inline bool isSubscribed() const
   {
     if (is_initialized_ == false) return false;
-      return pub_.getNumSubscribers() > 0;
+    return status_->isSubscribed();
+  }
+
+  /** Called in the ROS thread when the first subscriber comes */
+  void onSubscribe( const SubscriberStatus::Callback& callback )
+  {
+    status_->onSubscribe( callback );
   }
 
   virtual void publish( const T& msg )
@@ -63,9 +82,29 @@ public:
     pub_.publish( msg );
   }
 
+  /**
+  * @brief Publish a message without copying it for the subscribers in the same process
+  * @note the message must not be modified afterwards, roscpp may serialize it later for the remote subscribers
+  */
+  virtual void publishShared( const boost::shared_ptr<const T>& msg )
+  {
+    pub_.publish( msg );
+  }
+
+  /**
+  * @brief Publish a message serialized by the converter, roscpp copies its bytes instead of serializing it again
+  */
+  virtual void publishSerialized( const tools::SerializedMessage& msg )
+  {
+    pub_.publish( msg );
+  }
+
   virtual void reset( ros::NodeHandle& nh )
   {
-    pub_ = nh.advertise<T>( this->topic_, 10 );
+    status_ = status_->renew();
+    pub_ = nh.advertise<T>( this->topic_, 10,
+                            boost::bind( &SubscriberStatus::connected, status_ ),
+                            boost::bind( &SubscriberStatus::disconnected, status_ ) );
     is_initialized_ = true;
   }
 
@@ -74,6 +113,9 @@ protected:
 
   bool is_initialized_;
 
+  /** subscribers counted by the callbacks of pub_ */
+  boost::shared_ptr<SubscriberStatus> status_;
+
   /** Publisher */
   ros::Publisher pub_;
 }; // class
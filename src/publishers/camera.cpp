@@ -25,6 +25,12 @@
 */
 #include "../tools/alvisiondefinitions.h" // for kTop...
 
+/*
+* BOOST includes
+*/
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+
 namespace naoqi
 {
 namespace publisher
@@ -33,6 +39,7 @@ namespace publisher
 CameraPublisher::CameraPublisher( const std::string& topic, int camera_source ):
   topic_( topic ),
   is_initialized_(false),
+  status_( boost::make_shared<SubscriberStatus>() ),
   camera_source_( camera_source )
 {
 }
@@ -43,14 +50,21 @@ CameraPublisher::~CameraPublisher()
 
 void CameraPublisher::publish( const sensor_msgs::ImagePtr& img, const sensor_msgs::CameraInfo& camera_info )
 {
-  pub_.publish( *img, camera_info );
+  // the converter builds a new image every time, the nodelets in the process get it as is;
+  // the camera info is a member of the converter and is copied once
+  pub_.publish( sensor_msgs::ImageConstPtr( img ), boost::make_shared<const sensor_msgs::CameraInfo>( camera_info ) );
 }
 
 void CameraPublisher::reset( ros::NodeHandle& nh )
 {
 
   image_transport::ImageTransport it( nh );
-  pub_ = it.advertiseCamera( topic_, 1 );
+  status_ = status_->renew();
+  pub_ = it.advertiseCamera( topic_, 1,
+                             boost::bind( &SubscriberStatus::connected, status_ ),
+                             boost::bind( &SubscriberStatus::disconnected, status_ ),
+                             boost::bind( &SubscriberStatus::connected, status_ ),
+                             boost::bind( &SubscriberStatus::disconnected, status_ ) );
 
   // Unregister compressedDepth topics for non depth cameras
   if (camera_source_!=AL::kDepthCamera)
@@ -18,6 +18,11 @@
 #ifndef PUBLISHER_CAMERA_HPP
 #define PUBLISHER_CAMERA_HPP
 
+/*
+* LOCAL includes
+*/
+#include "subscriber_status.hpp"
+
 /*
 * ROS includes
 */
@@ -53,7 +58,13 @@ public:
   inline bool isSubscribed() const
   {
     if (is_initialized_ == false) return false;
-    return pub_.getNumSubscribers() > 0;
+    return status_->isSubscribed();
+  }
+
+  /** Called in the ROS thread when the first subscriber comes */
+  void onSubscribe( const SubscriberStatus::Callback& callback )
+  {
+    status_->onSubscribe( callback );
   }
 
 private:
@@ -61,6 +72,9 @@ private:
 
   bool is_initialized_;
 
+  /** subscribers of the images, through any transport, and of the camera info */
+  boost::shared_ptr<SubscriberStatus> status_;
+
   //image_transport::ImageTransport it_;
   image_transport::CameraPublisher pub_;
 
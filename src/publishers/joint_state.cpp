@@ -41,6 +41,17 @@ void JointStatePublisher::publish( const sensor_msgs::JointState& js_msg,
   tf_broadcasterPtr_->sendTransform(tf_transforms);
 }
 
+void JointStatePublisher::publishShared( const boost::shared_ptr<const sensor_msgs::JointState>& js_msg,
+                                         const std::vector<geometry_msgs::TransformStamped>& tf_transforms )
+{
+  pub_joint_states_.publish( js_msg );
+
+  /**
+   * ROBOT STATE PUBLISHER
+   */
+  tf_broadcasterPtr_->sendTransform(tf_transforms);
+}
+
 
 void JointStatePublisher::reset( ros::NodeHandle& nh )
 {
@@ -18,6 +18,11 @@
 #ifndef JOINT_STATES_PUBLISHER_HPP
 #define JOINT_STATES_PUBLISHER_HPP
 
+/*
+* BOOST includes
+*/
+#include <boost/function.hpp>
+
 /*
 * ROS includes
 */
@@ -50,10 +55,18 @@ public:
   virtual void publish( const sensor_msgs::JointState& js_msg,
                         const std::vector<geometry_msgs::TransformStamped>& tf_transforms );
 
+  /** Publish joint states that must not change afterwards, the subscribers in the same process get them without a copy */
+  virtual void publishShared( const boost::shared_ptr<const sensor_msgs::JointState>& js_msg,
+                              const std::vector<geometry_msgs::TransformStamped>& tf_transforms );
+
   virtual void reset( ros::NodeHandle& nh );
 
   virtual bool isSubscribed() const;
 
+  /** Nothing to wake up, the joint states are always published */
+  inline void onSubscribe( const boost::function<void ()>& callback )
+  {}
+
 private:
   boost::shared_ptr<tf2_ros::TransformBroadcaster> tf_broadcasterPtr_;
 
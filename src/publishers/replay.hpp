@@ -0,0 +1,116 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef REPLAY_PUBLISHER_HPP
+#define REPLAY_PUBLISHER_HPP
+
+/*
+* LOCAL includes
+*/
+#include "../tools/serialized_message.hpp"
+#include "subscriber_status.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <string>
+
+/*
+* BOOST includes
+*/
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+/*
+* ROS includes
+*/
+#include <ros/ros.h>
+
+namespace naoqi
+{
+namespace publisher
+{
+
+/**
+* @brief Publishes messages read serialized from a ROSbag, advertised with the type found in the bag
+*/
+class ReplayPublisher
+{
+
+public:
+  ReplayPublisher( const std::string& topic, const boost::shared_ptr<const tools::MessageType>& type ):
+    topic_( topic ),
+    type_( type ),
+    is_initialized_( false ),
+    status_( boost::make_shared<SubscriberStatus>() )
+  {}
+
+  inline std::string topic() const
+  {
+    return topic_;
+  }
+
+  inline bool isInitialized() const
+  {
+    return is_initialized_;
+  }
+
+  inline bool isSubscribed() const
+  {
+    if (is_initialized_ == false) return false;
+    return status_->isSubscribed();
+  }
+
+  /** Called in the ROS thread when the first subscriber comes */
+  void onSubscribe( const SubscriberStatus::Callback& callback )
+  {
+    status_->onSubscribe( callback );
+  }
+
+  void publish( const tools::SerializedMessage& msg )
+  {
+    pub_.publish( msg );
+  }
+
+  void reset( ros::NodeHandle& nh )
+  {
+    ros::AdvertiseOptions options( topic_, 10, type_->md5sum, type_->datatype, type_->definition );
+    status_ = status_->renew();
+    options.connect_cb = boost::bind( &SubscriberStatus::connected, status_ );
+    options.disconnect_cb = boost::bind( &SubscriberStatus::disconnected, status_ );
+    pub_ = nh.advertise( options );
+    is_initialized_ = true;
+  }
+
+private:
+  std::string topic_;
+  boost::shared_ptr<const tools::MessageType> type_;
+
+  bool is_initialized_;
+
+  /** subscribers counted by the callbacks of pub_ */
+  boost::shared_ptr<SubscriberStatus> status_;
+
+  /** Publisher */
+  ros::Publisher pub_;
+}; // class
+
+} // publisher
+} // naoqi
+
+#endif
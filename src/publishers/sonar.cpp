@@ -20,6 +20,11 @@
 */
 #include "sonar.hpp"
 
+/*
+* BOOST includes
+*/
+#include <boost/bind.hpp>
+
 namespace naoqi
 {
 namespace publisher
@@ -27,7 +32,8 @@ namespace publisher
 
 SonarPublisher::SonarPublisher( const std::vector<std::string>& topics )
   : is_initialized_(false),
-  topics_(topics)
+  topics_(topics),
+  status_( boost::make_shared<SubscriberStatus>() )
 {
 }
 
@@ -48,9 +54,12 @@ void SonarPublisher::publish( const std::vector<sensor_msgs::Range>& sonar_msgs
 void SonarPublisher::reset( ros::NodeHandle& nh )
 {
   pubs_ = std::vector<ros::Publisher>();
+  status_ = status_->renew();
   for( size_t i=0; i<topics_.size(); ++i)
   {
-    pubs_.push_back( nh.advertise<sensor_msgs::Range>(topics_[i], 1) );
+    pubs_.push_back( nh.advertise<sensor_msgs::Range>(topics_[i], 1,
+                                                      boost::bind( &SubscriberStatus::connected, status_ ),
+                                                      boost::bind( &SubscriberStatus::disconnected, status_ ) ) );
   }
 
   is_initialized_ = true;
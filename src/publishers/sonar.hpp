@@ -18,6 +18,11 @@
 #ifndef PUBLISHER_SONAR_HPP
 #define PUBLISHER_SONAR_HPP
 
+/*
+* LOCAL includes
+*/
+#include "subscriber_status.hpp"
+
 /*
 * ROS includes
 */
@@ -51,16 +56,21 @@ public:
   inline bool isSubscribed() const
   {
     if (is_initialized_ == false) return false;
-    for(std::vector<ros::Publisher>::const_iterator it = pubs_.begin(); it != pubs_.end(); ++it)
-      if (it->getNumSubscribers())
-        return true;
-    return false;
+    return status_->isSubscribed();
+  }
+
+  /** Called in the ROS thread when the first subscriber of any sonar comes */
+  void onSubscribe( const SubscriberStatus::Callback& callback )
+  {
+    status_->onSubscribe( callback );
   }
 
 private:
   std::vector<std::string> topics_;
   std::vector<ros::Publisher> pubs_;
   bool is_initialized_;
+  /** subscribers of all the sonar topics */
+  boost::shared_ptr<SubscriberStatus> status_;
 
 };
 
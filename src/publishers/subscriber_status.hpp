@@ -0,0 +1,105 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SUBSCRIBER_STATUS_HPP
+#define SUBSCRIBER_STATUS_HPP
+
+/*
+* BOOST includes
+*/
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace naoqi
+{
+namespace publisher
+{
+
+/**
+* @brief Number of subscribers of a publisher, kept up to date by the SubscriberStatusCallbacks given to advertise
+* @note isSubscribed() then reads an atomic instead of asking roscpp, which locks the publication to count its links.
+* The callbacks run in the thread spinning the ROS callback queue; when the first subscriber comes,
+* the callback given to onSubscribe is called so that the driver wakes up the suspended converter.
+* A publisher takes a new status each time it advertises, the callbacks of the previous publication
+* then keep counting on the old one.
+*/
+class SubscriberStatus : private boost::noncopyable
+{
+
+public:
+  typedef boost::function<void ()> Callback;
+
+  SubscriberStatus( const Callback& on_subscribe = Callback() ):
+    count_( 0 ),
+    on_subscribe_( on_subscribe )
+  {}
+
+  /** Same callback, no subscriber */
+  boost::shared_ptr<SubscriberStatus> renew() const
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    return boost::make_shared<SubscriberStatus>( on_subscribe_ );
+  }
+
+  void onSubscribe( const Callback& on_subscribe )
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    on_subscribe_ = on_subscribe;
+  }
+
+  /** To bind as connect callback, the SingleSubscriberPublisher given by roscpp is dropped by boost::bind */
+  void connected()
+  {
+    if ( count_.fetch_add( 1 ) == 0 )
+    {
+      Callback on_subscribe;
+      {
+        boost::mutex::scoped_lock lock( mutex_ );
+        on_subscribe = on_subscribe_;
+      }
+      if ( on_subscribe )
+      {
+        on_subscribe();
+      }
+    }
+  }
+
+  void disconnected()
+  {
+    count_.fetch_sub( 1 );
+  }
+
+  inline bool isSubscribed() const
+  {
+    return count_.load( boost::memory_order_relaxed ) > 0;
+  }
+
+private:
+  boost::atomic<int> count_;
+  mutable boost::mutex mutex_;
+  Callback on_subscribe_;
+
+}; // class
+
+} // publisher
+} // naoqi
+
+#endif
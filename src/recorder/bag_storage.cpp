@@ -0,0 +1,287 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/*
+* LOCAL includes
+*/
+#include "bag_storage.hpp"
+#include <naoqi_driver/tools.hpp>
+
+/*
+* STANDARD includes
+*/
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+/*
+* SYSTEM includes
+*/
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+/*
+* BOOST includes
+*/
+#include <boost/filesystem.hpp>
+
+/*
+* ALDEBARAN includes
+*/
+#include <qi/log.hpp>
+
+qiLogCategory("ros.BagStorage");
+
+namespace naoqi
+{
+namespace recorder
+{
+
+BagStorage::BagStorage( const std::string& directory ):
+  directory_( directory ),
+  max_bytes_( 2000000000 ),
+  evict_oldest_( false ),
+  total_bytes_( 0 ),
+  inotify_fd_( -1 ),
+  watching_( false )
+{}
+
+BagStorage::~BagStorage()
+{
+  stop();
+}
+
+void BagStorage::setQuota( boost::uint64_t max_bytes, bool evict_oldest )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  max_bytes_ = max_bytes;
+  evict_oldest_ = evict_oldest;
+}
+
+void BagStorage::start()
+{
+  {
+    boost::mutex::scoped_lock lock( mutex_ );
+    if ( watching_ )
+    {
+      return;
+    }
+
+    // the only full scan, the bags of the subfolders are counted but not watched
+    boost::system::error_code ec;
+    boost::filesystem::recursive_directory_iterator it( directory_, ec );
+    boost::filesystem::recursive_directory_iterator end;
+    for ( ; !ec && it != end; it.increment( ec ) )
+    {
+      if ( boost::filesystem::is_regular_file( it->status() ) && isBag( it->path().string() ) )
+      {
+        update( it->path().string() );
+      }
+    }
+  }
+
+  inotify_fd_ = ::inotify_init();
+  if ( inotify_fd_ < 0 || ::inotify_add_watch( inotify_fd_, directory_.c_str(), IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO ) < 0 )
+  {
+    qiLogWarning() << "Cannot watch " << directory_ << " (" << std::strerror(errno) << "), only the bags of the driver are accounted";
+    if ( inotify_fd_ >= 0 )
+    {
+      ::close( inotify_fd_ );
+      inotify_fd_ = -1;
+    }
+    return;
+  }
+  watching_ = true;
+  watch_thread_ = boost::thread( &BagStorage::watchLoop, this );
+}
+
+void BagStorage::stop()
+{
+  if ( watching_ )
+  {
+    watching_ = false;
+    watch_thread_.join();
+    ::close( inotify_fd_ );
+    inotify_fd_ = -1;
+  }
+}
+
+void BagStorage::bagOpened( const std::string& path )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  open_bags_.insert( path );
+}
+
+void BagStorage::bagClosed( const std::string& path )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  open_bags_.erase( path );
+  update( path );
+}
+
+bool BagStorage::remove( const std::string& path )
+{
+  boost::system::error_code ec;
+  boost::filesystem::remove( path, ec );
+  if ( ec )
+  {
+    std::cout << BOLDRED << "Cannot remove " << path << ": " << ec.message() << RESETCOLOR << std::endl;
+    return false;
+  }
+  boost::mutex::scoped_lock lock( mutex_ );
+  forget( path );
+  return true;
+}
+
+void BagStorage::removeAll()
+{
+  const std::vector<std::string>& paths = files();
+  for ( std::vector<std::string>::const_iterator it = paths.begin(); it != paths.end(); ++it )
+  {
+    bool open;
+    {
+      boost::mutex::scoped_lock lock( mutex_ );
+      open = open_bags_.count( *it ) > 0;
+    }
+    if ( !open )
+    {
+      remove( *it );
+    }
+  }
+}
+
+bool BagStorage::checkQuota()
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  while ( total_bytes_ > max_bytes_ && evict_oldest_ )
+  {
+    std::map<std::string, Bag>::const_iterator oldest = bags_.end();
+    for ( std::map<std::string, Bag>::const_iterator it = bags_.begin(); it != bags_.end(); ++it )
+    {
+      if ( open_bags_.count( it->first ) == 0 && ( oldest == bags_.end() || it->second.modified < oldest->second.modified ) )
+      {
+        oldest = it;
+      }
+    }
+    if ( oldest == bags_.end() )
+    {
+      break;
+    }
+    const std::string path = oldest->first;
+    boost::system::error_code ec;
+    boost::filesystem::remove( path, ec );
+    std::cout << YELLOW << "The bag " << BOLDCYAN << path << RESETCOLOR << YELLOW << " is removed to make room" << RESETCOLOR << std::endl;
+    forget( path );
+  }
+  return total_bytes_ <= max_bytes_;
+}
+
+boost::uint64_t BagStorage::totalBytes()
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  return total_bytes_;
+}
+
+std::vector<std::string> BagStorage::files()
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  std::vector<std::string> paths;
+  for ( std::map<std::string, Bag>::const_iterator it = bags_.begin(); it != bags_.end(); ++it )
+  {
+    paths.push_back( it->first );
+  }
+  for ( std::set<std::string>::const_iterator it = open_bags_.begin(); it != open_bags_.end(); ++it )
+  {
+    if ( bags_.count( *it ) == 0 )
+    {
+      paths.push_back( *it );
+    }
+  }
+  return paths;
+}
+
+void BagStorage::update( const std::string& path )
+{
+  boost::system::error_code ec;
+  const boost::uint64_t size = boost::filesystem::file_size( path, ec );
+  if ( ec )
+  {
+    forget( path );
+    return;
+  }
+  // a new bag starts with a size of 0
+  Bag& bag = bags_[path];
+  total_bytes_ -= bag.size;
+  bag.size = size;
+  bag.modified = boost::filesystem::last_write_time( path, ec );
+  total_bytes_ += size;
+}
+
+void BagStorage::forget( const std::string& path )
+{
+  std::map<std::string, Bag>::iterator it = bags_.find( path );
+  if ( it != bags_.end() )
+  {
+    total_bytes_ -= it->second.size;
+    bags_.erase( it );
+  }
+}
+
+void BagStorage::watchLoop()
+{
+  // enough for a few events with their names
+  char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  while ( watching_ )
+  {
+    struct pollfd pfd;
+    pfd.fd = inotify_fd_;
+    pfd.events = POLLIN;
+    if ( ::poll( &pfd, 1, 500 ) <= 0 )
+    {
+      continue;
+    }
+    const ssize_t length = ::read( inotify_fd_, buffer, sizeof(buffer) );
+    for ( ssize_t offset = 0; offset < length; )
+    {
+      const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>( buffer + offset );
+      offset += sizeof(struct inotify_event) + event->len;
+      if ( event->len == 0 || !isBag( event->name ) )
+      {
+        continue;
+      }
+      const std::string path = directory_ + "/" + event->name;
+      boost::mutex::scoped_lock lock( mutex_ );
+      if ( event->mask & ( IN_DELETE | IN_MOVED_FROM ) )
+      {
+        forget( path );
+      }
+      else if ( open_bags_.count( path ) == 0 )
+      {
+        update( path );
+      }
+    }
+  }
+}
+
+bool BagStorage::isBag( const std::string& path )
+{
+  return path.size() > 4 && path.compare( path.size() - 4, 4, ".bag" ) == 0;
+}
+
+} // recorder
+} // naoqi
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BAG_STORAGE_HPP
+#define BAG_STORAGE_HPP
+
+/*
+* STANDARD includes
+*/
+#include <ctime>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace naoqi
+{
+namespace recorder
+{
+
+/**
+* @brief Bags of the recording directory and the bytes they take
+* @note the directory is scanned once by start(), then the total is kept up to date by the GlobalRecorder,
+* which reports the bags it opens and closes, and by an inotify watch for the changes made by anybody else,
+* so that checking the quota does not touch the disk
+*/
+class BagStorage : private boost::noncopyable
+{
+
+public:
+  BagStorage( const std::string& directory );
+
+  ~BagStorage();
+
+  inline const std::string& directory() const
+  {
+    return directory_;
+  }
+
+  /**
+  * @brief Set the bytes the bags may take
+  * @param evict_oldest remove the oldest bags to make room instead of refusing new ones
+  */
+  void setQuota( boost::uint64_t max_bytes, bool evict_oldest );
+
+  /**
+  * @brief Scan the directory and start watching it
+  */
+  void start();
+
+  void stop();
+
+  /**
+  * @brief A bag is being written, it cannot be evicted until it is closed
+  */
+  void bagOpened( const std::string& path );
+
+  /**
+  * @brief A bag is complete, its size is read once
+  */
+  void bagClosed( const std::string& path );
+
+  /**
+  * @brief Delete a bag
+  * @return false if the file could not be removed
+  */
+  bool remove( const std::string& path );
+
+  /**
+  * @brief Delete all the bags but the ones being written
+  */
+  void removeAll();
+
+  /**
+  * @brief Check that the bags fit in the quota, evicting the oldest ones first if allowed
+  * @return false if the quota is exceeded
+  */
+  bool checkQuota();
+
+  /** Bytes taken by the bags, as of their last known state */
+  boost::uint64_t totalBytes();
+
+  /** Path of the bags */
+  std::vector<std::string> files();
+
+private:
+  struct Bag
+  {
+    boost::uint64_t size;
+    std::time_t modified;
+  };
+
+  /** Read the size of a bag and update the total, must be called with mutex_ locked */
+  void update( const std::string& path );
+
+  /** Forget a bag, must be called with mutex_ locked */
+  void forget( const std::string& path );
+
+  void watchLoop();
+
+  static bool isBag( const std::string& path );
+
+  std::string directory_;
+  boost::uint64_t max_bytes_;
+  bool evict_oldest_;
+
+  boost::mutex mutex_;
+  std::map<std::string, Bag> bags_;
+  std::set<std::string> open_bags_;
+  boost::uint64_t total_bytes_;
+
+  int inotify_fd_;
+  /** cleared by stop() while watchLoop reads it */
+  boost::atomic<bool> watching_;
+  boost::thread watch_thread_;
+
+}; // class
+
+} // recorder
+} // naoqi
+
+#endif
@@ -22,13 +22,14 @@
 * LOCAL includes
 */
 #include <naoqi_driver/recorder/globalrecorder.hpp>
+#include <naoqi_driver/recorder/record_profile.hpp>
 #include "../helpers/recorder_helpers.hpp"
+#include "serialized_buffer.hpp"
 
 /*
 * STANDARD includes
 */
 #include <string>
-#include <boost/circular_buffer.hpp>
 
 namespace naoqi
 {
@@ -47,7 +48,9 @@ public:
     is_subscribed_( false ),
     buffer_frequency_(buffer_frequency),
     counter_(1)
-  {}
+  {
+    channel_ = buffer_.addChannel<T>( topic_ );
+  }
 
   virtual ~BasicRecorder() {}
 
@@ -73,41 +76,36 @@ public:
 
   virtual void write(const T& msg)
   {
-    if (!msg.header.stamp.isZero()) {
-      gr_->write(topic_, msg, msg.header.stamp);
-    }
-    else {
-      gr_->write(topic_, msg);
-    }
+    writeAt(msg, msg.header.stamp);
   }
 
-  virtual void writeDump(const ros::Time& time)
+  /**
+  * @brief Write a message serialized by the converter, the ROSbag gets a copy of its bytes
+  * @param stamp stamp of the header of the message
+  */
+  virtual void writeSerialized(const tools::SerializedMessage& msg, const ros::Time& stamp)
+  {
+    writeAt(msg, stamp);
+  }
+
+  virtual DumpSnapshot snapshot(const ros::Time& time)
   {
     boost::mutex::scoped_lock lock_write_buffer( mutex_ );
-    typename boost::circular_buffer<T>::iterator it;
-    for (it = buffer_.begin(); it != buffer_.end(); it++)
-    {
-      if (!it->header.stamp.isZero()) {
-        gr_->write(topic_, *it, it->header.stamp);
-      }
-      else {
-        gr_->write(topic_, *it);
-      }
-    }
+    return boost::bind( &SerializedBuffer::Snapshot::collect, buffer_.snapshot(), _1 );
   }
 
   virtual void bufferize(const T& msg)
   {
-    boost::mutex::scoped_lock lock_bufferize( mutex_ );
-    if (counter_ < max_counter_)
-    {
-      counter_++;
-    }
-    else
-    {
-      counter_ = 1;
-      buffer_.push_back(msg);
-    }
+    bufferizeAt(msg, msg.header.stamp);
+  }
+
+  /**
+  * @brief Buffer a message serialized by the converter, its bytes are copied as they are
+  * @param stamp stamp of the header of the message
+  */
+  virtual void bufferizeSerialized(const tools::SerializedMessage& msg, const ros::Time& stamp)
+  {
+    bufferizeAt(msg, stamp);
   }
 
   virtual void reset(boost::shared_ptr<GlobalRecorder> gr, float conv_frequency)
@@ -117,30 +115,66 @@ public:
     if (buffer_frequency_ != 0)
     {
       max_counter_ = static_cast<int>(conv_frequency/buffer_frequency_);
-      buffer_size_ = static_cast<size_t>(buffer_duration_*(conv_frequency/max_counter_));
     }
     else
     {
       max_counter_ = 1;
-      buffer_size_ = static_cast<size_t>(buffer_duration_*conv_frequency);
     }
-    buffer_.resize(buffer_size_);
+    boost::mutex::scoped_lock lock_bufferize( mutex_ );
+    buffer_.reset(gr, topic_);
     is_initialized_ = true;
   }
 
   virtual void setBufferDuration(float duration)
   {
     boost::mutex::scoped_lock lock_bufferize( mutex_ );
-    buffer_size_ = static_cast<size_t>(duration*(conv_frequency_/max_counter_));
     buffer_duration_ = duration;
-    buffer_.set_capacity(buffer_size_);
+  }
+
+  virtual void setProfile(const RecordProfile& profile)
+  {
+    filter_.setProfile(profile);
   }
 
 protected:
+  /** M is T or its serialized bytes */
+  template <class M>
+  void writeAt(const M& msg, const ros::Time& stamp)
+  {
+    if (!filter_.accept(stamp))
+    {
+      return;
+    }
+    if (!stamp.isZero()) {
+      gr_->write(topic_, msg, stamp);
+    }
+    else {
+      gr_->write(topic_, msg);
+    }
+  }
+
+  template <class M>
+  void bufferizeAt(const M& msg, const ros::Time& msg_stamp)
+  {
+    boost::mutex::scoped_lock lock_bufferize( mutex_ );
+    if (counter_ < max_counter_)
+    {
+      counter_++;
+    }
+    else
+    {
+      counter_ = 1;
+      const ros::Time& stamp = msg_stamp.isZero() ? ros::Time::now() : msg_stamp;
+      buffer_.push(channel_, msg, stamp);
+      buffer_.removeOlderThan(stamp - ros::Duration(buffer_duration_));
+    }
+  }
+
   std::string topic_;
 
-  boost::circular_buffer<T> buffer_;
-  size_t buffer_size_;
+  /** serialized messages of the last buffer_duration_ seconds, within the bytes granted to the topic */
+  SerializedBuffer buffer_;
+  size_t channel_;
   float buffer_duration_;
   boost::mutex mutex_;
 
@@ -148,6 +182,7 @@ protected:
   bool is_subscribed_;
 
   boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr_;
+  RecordFilter filter_;
 
   float buffer_frequency_;
   float conv_frequency_;
@@ -22,7 +22,9 @@
 * LOCAL includes
 */
 #include <naoqi_driver/recorder/globalrecorder.hpp>
+#include <naoqi_driver/recorder/record_profile.hpp>
 #include "../helpers/recorder_helpers.hpp"
+#include "serialized_buffer.hpp"
 
 /*
 * STANDARD includes
@@ -44,7 +46,9 @@ public:
     buffer_duration_( helpers::recorder::bufferDefaultDuration ),
     is_initialized_( false ),
     is_subscribed_( false )
-  {}
+  {
+    channel_ = buffer_.addChannel<T>( topic_ );
+  }
 
   virtual ~BasicEventRecorder() {}
 
@@ -70,6 +74,10 @@ public:
 
   virtual void write(const T& msg)
   {
+    if (!filter_.accept(msg.header.stamp))
+    {
+      return;
+    }
     if (!msg.header.stamp.isZero()) {
       gr_->write(topic_, msg, msg.header.stamp);
     }
@@ -78,34 +86,27 @@ public:
     }
   }
 
-  virtual void writeDump(const ros::Time& time)
+  virtual DumpSnapshot snapshot(const ros::Time& time)
   {
     boost::mutex::scoped_lock lock_write_buffer( mutex_ );
     removeOlderThan(time);
-    typename std::list<T>::iterator it;
-    for (it = buffer_.begin(); it != buffer_.end(); it++)
-    {
-      if (!it->header.stamp.isZero()) {
-        gr_->write(topic_, *it, it->header.stamp);
-      }
-      else {
-        gr_->write(topic_, *it);
-      }
-    }
+    return boost::bind( &SerializedBuffer::Snapshot::collect, buffer_.snapshot(), _1 );
   }
 
   virtual void bufferize(const T& msg)
   {
     boost::mutex::scoped_lock lock_bufferize( mutex_ );
-    typename std::list<T>::iterator it;
-    removeOld();
-    buffer_.push_back(msg);
-
+    // the stamp of the newest event is the reference, no need to read the clock for each event
+    const ros::Time& stamp = msg.header.stamp.isZero() ? ros::Time::now() : msg.header.stamp;
+    buffer_.push(channel_, msg, stamp);
+    removeOlderThan(stamp);
   }
 
   virtual void reset(boost::shared_ptr<GlobalRecorder> gr, float conv_frequency)
   {
     gr_ = gr;
+    boost::mutex::scoped_lock lock_bufferize( mutex_ );
+    buffer_.reset(gr, topic_);
     is_initialized_ = true;
   }
 
@@ -115,47 +116,23 @@ public:
     buffer_duration_ = duration;
   }
 
-protected:
-  bool isTooOld(const T& msg)
-  {
-    ros::Duration d( ros::Time::now() - msg.header.stamp );
-    if (static_cast<float>(d.toSec()) > buffer_duration_)
-    {
-      return true;
-    }
-    return false;
-  }
-
-  bool isOlderThan(const T& msg, const ros::Time& time)
-  {
-    ros::Duration d( time - msg.header.stamp );
-    if (static_cast<float>(d.toSec()) > buffer_duration_)
-    {
-      return true;
-    }
-    return false;
-  }
-
-  void removeOld()
+  virtual void setProfile(const RecordProfile& profile)
   {
-    while (buffer_.size() > 0 && isTooOld(buffer_.front()))
-    {
-      buffer_.pop_front();
-    }
+    filter_.setProfile(profile);
   }
 
+protected:
   void removeOlderThan(const ros::Time& time)
   {
-    while (buffer_.size() > 0 && isOlderThan(buffer_.front(), time))
-    {
-      buffer_.pop_front();
-    }
+    buffer_.removeOlderThan(time - ros::Duration(buffer_duration_));
   }
 
 protected:
   std::string topic_;
 
-  std::list<T> buffer_;
+  /** serialized events of the last buffer_duration_ seconds, within the bytes granted to the topic */
+  SerializedBuffer buffer_;
+  size_t channel_;
   float buffer_duration_;
   boost::mutex mutex_;
 
@@ -163,6 +140,7 @@ protected:
   bool is_subscribed_;
 
   boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr_;
+  RecordFilter filter_;
 
 }; // class
 
@@ -0,0 +1,303 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/*
+* LOCAL includes
+*/
+#include "blackbox.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+/*
+* SYSTEM includes
+*/
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+* BOOST includes
+*/
+#include <boost/make_shared.hpp>
+
+/*
+* ALDEBARAN includes
+*/
+#include <qi/log.hpp>
+
+qiLogCategory("ros.BlackBox");
+
+namespace naoqi
+{
+namespace recorder
+{
+
+namespace
+{
+
+const char file_magic[8] = { 'N', 'A', 'O', 'Q', 'I', 'B', 'B', 'X' };
+const char slice_magic[8] = { 'N', 'A', 'O', 'Q', 'I', 'B', 'B', 'S' };
+
+/** Header of the file, followed by the slices */
+struct FileHeader
+{
+  char magic[8];
+  boost::uint64_t size;
+  /** bytes used by the header and the slices */
+  boost::uint64_t used;
+};
+
+size_t stringSize( const std::string& s )
+{
+  return sizeof(boost::uint32_t) + s.size();
+}
+
+uint8_t* writeString( uint8_t* out, const std::string& s )
+{
+  const boost::uint32_t size = s.size();
+  std::memcpy( out, &size, sizeof(size) );
+  std::memcpy( out + sizeof(size), s.data(), size );
+  return out + sizeof(size) + size;
+}
+
+const uint8_t* readString( const uint8_t* in, const uint8_t* end, std::string& s )
+{
+  boost::uint32_t size;
+  if ( in + sizeof(size) > end )
+  {
+    return NULL;
+  }
+  std::memcpy( &size, in, sizeof(size) );
+  in += sizeof(size);
+  if ( in + size > end )
+  {
+    return NULL;
+  }
+  s.assign( reinterpret_cast<const char*>(in), size );
+  return in + size;
+}
+
+/** Parse a slice and give its records to write, in the order they were pushed */
+size_t recoverSlice( BlackBox::SliceHeader* slice, const uint8_t* end, const BlackBox::WriteCallback& write )
+{
+  // channel table
+  std::vector<BlackBox::Channel> channels;
+  const uint8_t* table = reinterpret_cast<const uint8_t*>(slice) + sizeof(BlackBox::SliceHeader);
+  const uint8_t* table_end = table + slice->channel_table_size;
+  if ( table_end > end )
+  {
+    return 0;
+  }
+  for ( boost::uint32_t i=0; i<slice->channel_count && table != NULL; ++i )
+  {
+    boost::shared_ptr<tools::MessageType> type = boost::make_shared<tools::MessageType>();
+    BlackBox::Channel channel;
+    table = readString( table, table_end, channel.topic );
+    if ( table ) table = readString( table, table_end, type->datatype );
+    if ( table ) table = readString( table, table_end, type->md5sum );
+    if ( table ) table = readString( table, table_end, type->definition );
+    channel.type = type;
+    channels.push_back( channel );
+  }
+  if ( table == NULL )
+  {
+    return 0;
+  }
+
+  // ring: walk from the oldest record, jump back to the beginning when the records stop following each other
+  const uint8_t* ring = BlackBox::ring( slice );
+  const size_t capacity = slice->capacity;
+  if ( ring + capacity > end )
+  {
+    return 0;
+  }
+  size_t offset = slice->tail;
+  bool wrapped = false;
+  bool first = true;
+  boost::uint64_t expected = 0;
+  size_t count = 0;
+  while ( true )
+  {
+    BlackBox::RecordHeader header;
+    bool valid = offset + sizeof(header) <= capacity;
+    if ( valid )
+    {
+      std::memcpy( &header, ring + offset, sizeof(header) );
+      valid = header.magic == BlackBox::record_magic
+           && offset + sizeof(header) + header.size <= capacity
+           && header.channel < channels.size()
+           && ( first || header.seq == expected );
+    }
+    if ( !valid )
+    {
+      // the end of the block is left unused when the records wrap, the oldest one is always valid
+      if ( !first && !wrapped && offset != 0 )
+      {
+        wrapped = true;
+        offset = 0;
+        continue;
+      }
+      break;
+    }
+
+    const BlackBox::Channel& channel = channels[header.channel];
+    write( channel.topic,
+           tools::SerializedMessage( channel.type, ring + offset + sizeof(header), header.size ),
+           ros::Time( header.sec, header.nsec ) );
+    ++count;
+    first = false;
+    expected = header.seq + 1;
+    offset += sizeof(header) + header.size;
+  }
+  return count;
+}
+
+} // anonymous
+
+BlackBox::BlackBox( const std::string& path, size_t size ):
+  path_( path ),
+  size_( size ),
+  data_( NULL )
+{
+  int fd = ::open( path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+  if ( fd < 0 )
+  {
+    throw std::runtime_error( "Cannot create the black box file " + path + ": " + std::strerror(errno) );
+  }
+  if ( ::ftruncate( fd, size ) != 0 )
+  {
+    ::close( fd );
+    throw std::runtime_error( "Cannot resize the black box file " + path + ": " + std::strerror(errno) );
+  }
+  void* data = ::mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  ::close( fd );
+  if ( data == MAP_FAILED )
+  {
+    throw std::runtime_error( "Cannot map the black box file " + path + ": " + std::strerror(errno) );
+  }
+  data_ = static_cast<uint8_t*>( data );
+
+  FileHeader* header = reinterpret_cast<FileHeader*>( data_ );
+  std::memcpy( header->magic, file_magic, sizeof(file_magic) );
+  header->size = size;
+  header->used = sizeof(FileHeader);
+}
+
+BlackBox::~BlackBox()
+{
+  if ( data_ != NULL )
+  {
+    ::munmap( data_, size_ );
+  }
+}
+
+BlackBox::SliceHeader* BlackBox::allocateSlice( size_t capacity, const std::vector<Channel>& channels )
+{
+  size_t table_size = 0;
+  for ( std::vector<Channel>::const_iterator it = channels.begin(); it != channels.end(); ++it )
+  {
+    table_size += stringSize( it->topic ) + stringSize( it->type->datatype )
+                + stringSize( it->type->md5sum ) + stringSize( it->type->definition );
+  }
+
+  // keep the slice headers 8 bytes aligned
+  table_size = (table_size + 7) & ~static_cast<size_t>(7);
+  capacity = capacity & ~static_cast<size_t>(7);
+
+  boost::mutex::scoped_lock lock( mutex_ );
+  FileHeader* header = reinterpret_cast<FileHeader*>( data_ );
+  const size_t slice_size = sizeof(SliceHeader) + table_size + capacity;
+  if ( header->used + slice_size > size_ )
+  {
+    qiLogWarning() << "The black box " << path_ << " is full, " << slice_size << " more bytes are needed";
+    return NULL;
+  }
+
+  SliceHeader* slice = reinterpret_cast<SliceHeader*>( data_ + header->used );
+  std::memcpy( slice->magic, slice_magic, sizeof(slice_magic) );
+  slice->capacity = capacity;
+  slice->head = 0;
+  slice->tail = 0;
+  slice->channel_table_size = table_size;
+  slice->channel_count = channels.size();
+  slice->reserved = 0;
+  uint8_t* table = reinterpret_cast<uint8_t*>(slice) + sizeof(SliceHeader);
+  for ( std::vector<Channel>::const_iterator it = channels.begin(); it != channels.end(); ++it )
+  {
+    table = writeString( table, it->topic );
+    table = writeString( table, it->type->datatype );
+    table = writeString( table, it->type->md5sum );
+    table = writeString( table, it->type->definition );
+  }
+  header->used += slice_size;
+  return slice;
+}
+
+size_t BlackBox::recover( const std::string& path, const WriteCallback& write )
+{
+  int fd = ::open( path.c_str(), O_RDONLY );
+  if ( fd < 0 )
+  {
+    throw std::runtime_error( "Cannot open the black box file " + path + ": " + std::strerror(errno) );
+  }
+  struct stat st;
+  if ( ::fstat( fd, &st ) != 0 || static_cast<size_t>(st.st_size) < sizeof(FileHeader) )
+  {
+    ::close( fd );
+    throw std::runtime_error( "The black box file " + path + " is too small" );
+  }
+  const size_t size = st.st_size;
+  // private writable mapping: the slice headers are only read, but the code deals with non const pointers
+  void* data = ::mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+  ::close( fd );
+  if ( data == MAP_FAILED )
+  {
+    throw std::runtime_error( "Cannot map the black box file " + path + ": " + std::strerror(errno) );
+  }
+  uint8_t* begin = static_cast<uint8_t*>( data );
+  const uint8_t* end = begin + size;
+
+  size_t count = 0;
+  const FileHeader* header = reinterpret_cast<const FileHeader*>( begin );
+  if ( std::memcmp( header->magic, file_magic, sizeof(file_magic) ) != 0 || header->used > size )
+  {
+    ::munmap( data, size );
+    throw std::runtime_error( "The file " + path + " is not a black box" );
+  }
+  size_t offset = sizeof(FileHeader);
+  while ( offset + sizeof(SliceHeader) <= header->used )
+  {
+    SliceHeader* slice = reinterpret_cast<SliceHeader*>( begin + offset );
+    if ( std::memcmp( slice->magic, slice_magic, sizeof(slice_magic) ) != 0 )
+    {
+      break;
+    }
+    count += recoverSlice( slice, end, write );
+    offset += sizeof(SliceHeader) + slice->channel_table_size + slice->capacity;
+  }
+  ::munmap( data, size );
+  return count;
+}
+
+} // recorder
+} // naoqi
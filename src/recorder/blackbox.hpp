@@ -0,0 +1,142 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BLACKBOX_HPP
+#define BLACKBOX_HPP
+
+/*
+* LOCAL includes
+*/
+#include "../tools/serialized_message.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <string>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+/*
+* ROS includes
+*/
+#include <ros/time.h>
+
+namespace naoqi
+{
+namespace recorder
+{
+
+/**
+* @brief File of fixed size mapped in memory, in which the minidump buffers live
+* @note the file is cut in slices, one per SerializedBuffer. A slice starts with a header giving
+* the topics and types of its channels and the offsets of its oldest and newest records,
+* then comes the ring of records, each one preceded by a RecordHeader.
+* As the mapping is shared with the kernel, its content survives a crash of the process
+* and can be turned into a ROSbag afterwards with recover().
+*/
+class BlackBox : private boost::noncopyable
+{
+
+public:
+  /** Topic and type of the records of a channel */
+  struct Channel
+  {
+    std::string topic;
+    boost::shared_ptr<const tools::MessageType> type;
+  };
+
+  /** Header of a slice, followed by the channel table then by the ring of records */
+  struct SliceHeader
+  {
+    char magic[8];
+    boost::uint64_t capacity;
+    /** offset of the end of the newest record in the ring */
+    boost::uint64_t head;
+    /** offset of the oldest record in the ring */
+    boost::uint64_t tail;
+    boost::uint64_t channel_table_size;
+    boost::uint32_t channel_count;
+    boost::uint32_t reserved;
+  };
+
+  /** Header written in front of each record of a ring */
+  struct RecordHeader
+  {
+    boost::uint32_t magic;
+    boost::uint32_t size;
+    boost::uint32_t channel;
+    boost::uint32_t reserved;
+    /** incremented for each record of a slice, tells valid records from overwritten ones */
+    boost::uint64_t seq;
+    boost::uint32_t sec;
+    boost::uint32_t nsec;
+  };
+
+  static const boost::uint32_t record_magic = 0x4e425243;
+
+  typedef boost::function<void (const std::string&, const tools::SerializedMessage&, const ros::Time&)> WriteCallback;
+
+  /**
+  * @brief Create (or truncate) the file and map it
+  * @throw std::runtime_error when the file cannot be created or mapped
+  */
+  BlackBox( const std::string& path, size_t size );
+
+  ~BlackBox();
+
+  inline const std::string& path() const
+  {
+    return path_;
+  }
+
+  /**
+  * @brief Carve a slice holding a ring of the given number of bytes
+  * @return the header of the slice, the ring starts at ring(slice); NULL if the file is full
+  */
+  SliceHeader* allocateSlice( size_t capacity, const std::vector<Channel>& channels );
+
+  static inline uint8_t* ring( SliceHeader* slice )
+  {
+    return reinterpret_cast<uint8_t*>(slice) + sizeof(SliceHeader) + slice->channel_table_size;
+  }
+
+  /**
+  * @brief Read back the records of a black box file left by a previous run
+  * @return the number of records given to write
+  */
+  static size_t recover( const std::string& path, const WriteCallback& write );
+
+private:
+  std::string path_;
+  size_t size_;
+  uint8_t* data_;
+  boost::mutex mutex_;
+
+}; // class
+
+} // recorder
+} // naoqi
+
+#endif
@@ -32,15 +32,36 @@ CameraRecorder::CameraRecorder( const std::string& topic_, float buffer_frequenc
 {
   topic_info_ = topic_ + "/camera_info";
   topic_img_ = topic_ + "/image_raw";
+  channel_img_ = buffer_.addChannel<sensor_msgs::Image>(topic_img_);
+  channel_info_ = buffer_.addChannel<sensor_msgs::CameraInfo>(topic_info_);
 }
 
 void CameraRecorder::write(const sensor_msgs::ImagePtr& img, const sensor_msgs::CameraInfo& camera_info)
 {
-  if (!img->header.stamp.isZero()) {
-    gr_->write(topic_img_, *img, img->header.stamp);
+  writeAt(*img, img->header.stamp, camera_info);
+}
+
+void CameraRecorder::writeSerialized(const tools::SerializedMessage& img, const ros::Time& stamp, const sensor_msgs::CameraInfo& camera_info)
+{
+  writeAt(img, stamp, camera_info);
+}
+
+template <class M>
+void CameraRecorder::writeAt(const M& img, const ros::Time& stamp, const sensor_msgs::CameraInfo& camera_info)
+{
+  if (!filter_.accept(stamp))
+  {
+    return;
+  }
+  if (!stamp.isZero()) {
+    gr_->write(topic_img_, img, stamp);
   }
   else {
-    gr_->write(topic_img_, *img);
+    gr_->write(topic_img_, img);
+  }
+  if (filter_.strips("camera_info"))
+  {
+    return;
   }
   if (!camera_info.header.stamp.isZero()) {
     gr_->write(topic_info_, camera_info, camera_info.header.stamp);
@@ -50,17 +71,10 @@ void CameraRecorder::write(const sensor_msgs::ImagePtr& img, const sensor_msgs::
   }
 }
 
-void CameraRecorder::writeDump(const ros::Time& time)
+DumpSnapshot CameraRecorder::snapshot(const ros::Time& time)
 {
   boost::mutex::scoped_lock lock_write_buffer( mutex_ );
-  boost::circular_buffer< std::pair<sensor_msgs::ImagePtr, sensor_msgs::CameraInfo> >::iterator it;
-  for (it = buffer_.begin(); it != buffer_.end(); it++)
-  {
-    if (it->first != NULL)
-    {
-      write(it->first, it->second);
-    }
-  }
+  return boost::bind( &SerializedBuffer::Snapshot::collect, buffer_.snapshot(), _1 );
 }
 
 void CameraRecorder::reset(boost::shared_ptr<GlobalRecorder> gr, float conv_frequency)
@@ -68,12 +82,23 @@ void CameraRecorder::reset(boost::shared_ptr<GlobalRecorder> gr, float conv_freq
   gr_ = gr;
   conv_frequency_ = conv_frequency;
   max_counter_ = static_cast<int>(conv_frequency/buffer_frequency_);
-  buffer_size_ = static_cast<size_t>(buffer_duration_*(conv_frequency/max_counter_));
-  buffer_.resize(buffer_size_);
+  boost::mutex::scoped_lock lock_bufferize( mutex_ );
+  buffer_.reset(gr, topic());
   is_initialized_ = true;
 }
 
 void CameraRecorder::bufferize( const sensor_msgs::ImagePtr& img, const sensor_msgs::CameraInfo& camera_info )
+{
+  bufferizeAt( *img, img->header.stamp, camera_info );
+}
+
+void CameraRecorder::bufferizeSerialized( const tools::SerializedMessage& img, const ros::Time& stamp, const sensor_msgs::CameraInfo& camera_info )
+{
+  bufferizeAt( img, stamp, camera_info );
+}
+
+template <class M>
+void CameraRecorder::bufferizeAt( const M& img, const ros::Time& img_stamp, const sensor_msgs::CameraInfo& camera_info )
 {
   boost::mutex::scoped_lock lock_bufferize( mutex_ );
   if (counter_ < max_counter_)
@@ -83,16 +108,22 @@ void CameraRecorder::bufferize( const sensor_msgs::ImagePtr& img, const sensor_m
   else
   {
     counter_ = 1;
-    buffer_.push_back(std::make_pair(img, camera_info));
+    const ros::Time& stamp = img_stamp.isZero() ? ros::Time::now() : img_stamp;
+    buffer_.push(channel_img_, img, stamp);
+    buffer_.push(channel_info_, camera_info, stamp);
+    buffer_.removeOlderThan(stamp - ros::Duration(buffer_duration_));
   }
 }
 
 void CameraRecorder::setBufferDuration(float duration)
 {
   boost::mutex::scoped_lock lock_bufferize( mutex_ );
-  buffer_size_ = static_cast<size_t>(duration*(conv_frequency_/max_counter_));
   buffer_duration_ = duration;
-  buffer_.set_capacity(buffer_size_);
+}
+
+void CameraRecorder::setProfile(const RecordProfile& profile)
+{
+  filter_.setProfile(profile);
 }
 
 } //publisher
@@ -18,16 +18,13 @@
 #ifndef CAMERA_RECORDER_HPP
 #define CAMERA_RECORDER_HPP
 
-/*
-* BOOST includes
-*/
-#include <boost/circular_buffer.hpp>
-
 /*
 * LOCAL includes
 */
 #include <naoqi_driver/recorder/globalrecorder.hpp>
+#include <naoqi_driver/recorder/record_profile.hpp>
 #include "../helpers/recorder_helpers.hpp"
+#include "serialized_buffer.hpp"
 
 /*
 * ROS includes
@@ -48,14 +45,25 @@ public:
 
   void write( const sensor_msgs::ImagePtr& img, const sensor_msgs::CameraInfo& camera_info );
 
+  /**
+  * @brief Write an image serialized by the converter, the ROSbag gets a copy of its bytes
+  * @param stamp stamp of the header of the image
+  */
+  void writeSerialized( const tools::SerializedMessage& img, const ros::Time& stamp, const sensor_msgs::CameraInfo& camera_info );
+
   void reset(boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr, float conv_frequency );
 
   void bufferize( const sensor_msgs::ImagePtr& img, const sensor_msgs::CameraInfo& camera_info );
 
-  void writeDump(const ros::Time& time);
+  /** Buffer an image serialized by the converter, its bytes are copied as they are */
+  void bufferizeSerialized( const tools::SerializedMessage& img, const ros::Time& stamp, const sensor_msgs::CameraInfo& camera_info );
+
+  DumpSnapshot snapshot(const ros::Time& time);
 
   void setBufferDuration(float duration);
 
+  void setProfile(const RecordProfile& profile);
+
   inline std::string topic() const
   {
     return topic_img_;
@@ -77,16 +85,26 @@ public:
   }
 
 protected:
+  /** M is the image or its serialized bytes */
+  template <class M>
+  void writeAt( const M& img, const ros::Time& stamp, const sensor_msgs::CameraInfo& camera_info );
+
+  template <class M>
+  void bufferizeAt( const M& img, const ros::Time& img_stamp, const sensor_msgs::CameraInfo& camera_info );
+
   bool is_initialized_;
   bool is_subscribed_;
 
-  boost::circular_buffer< std::pair<sensor_msgs::ImagePtr, sensor_msgs::CameraInfo> > buffer_;
-  size_t buffer_size_;
+  /** serialized images and camera infos of the last buffer_duration_ seconds */
+  SerializedBuffer buffer_;
+  size_t channel_img_;
+  size_t channel_info_;
   float buffer_duration_;
 
   boost::mutex mutex_;
 
   boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr_;
+  RecordFilter filter_;
   std::string topic_info_;
   std::string topic_img_;
 
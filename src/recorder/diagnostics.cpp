@@ -32,10 +32,16 @@ DiagnosticsRecorder::DiagnosticsRecorder( const std::string& topic, float buffer
   is_subscribed_( false ),
   buffer_frequency_(buffer_frequency),
   counter_(1)
-{}
+{
+  channel_ = buffer_.addChannel<diagnostic_msgs::DiagnosticArray>(topic_);
+}
 
 void DiagnosticsRecorder::write(diagnostic_msgs::DiagnosticArray& msg)
 {
+  if (!filter_.accept(msg.header.stamp))
+  {
+    return;
+  }
   if (!msg.header.stamp.isZero()) {
     gr_->write(topic_, msg, msg.header.stamp);
   }
@@ -44,19 +50,10 @@ void DiagnosticsRecorder::write(diagnostic_msgs::DiagnosticArray& msg)
   }
 }
 
-void DiagnosticsRecorder::writeDump(const ros::Time& time)
+DumpSnapshot DiagnosticsRecorder::snapshot(const ros::Time& time)
 {
   boost::mutex::scoped_lock lock_write_buffer( mutex_ );
-  boost::circular_buffer<diagnostic_msgs::DiagnosticArray>::iterator it;
-  for (it = buffer_.begin(); it != buffer_.end(); it++)
-  {
-    if (!it->header.stamp.isZero()) {
-      gr_->write(topic_, *it, it->header.stamp);
-    }
-    else {
-      gr_->write(topic_, *it);
-    }
-  }
+  return boost::bind( &SerializedBuffer::Snapshot::collect, buffer_.snapshot(), _1 );
 }
 
 void DiagnosticsRecorder::reset(boost::shared_ptr<GlobalRecorder> gr, float conv_frequency)
@@ -66,14 +63,13 @@ void DiagnosticsRecorder::reset(boost::shared_ptr<GlobalRecorder> gr, float conv
   if (buffer_frequency_ != 0)
   {
     max_counter_ = static_cast<int>(conv_frequency/buffer_frequency_);
-    buffer_size_ = static_cast<size_t>(buffer_duration_*(conv_frequency/max_counter_));
   }
   else
   {
     max_counter_ = 1;
-    buffer_size_ = static_cast<size_t>(buffer_duration_*conv_frequency);
   }
-  buffer_.resize(buffer_size_);
+  boost::mutex::scoped_lock lock_bufferize( mutex_ );
+  buffer_.reset(gr, topic());
   is_initialized_ = true;
 }
 
@@ -87,16 +83,21 @@ void DiagnosticsRecorder::bufferize(diagnostic_msgs::DiagnosticArray& msg )
   else
   {
     counter_ = 1;
-    buffer_.push_back(msg);
+    const ros::Time& stamp = msg.header.stamp.isZero() ? ros::Time::now() : msg.header.stamp;
+    buffer_.push(channel_, msg, stamp);
+    buffer_.removeOlderThan(stamp - ros::Duration(buffer_duration_));
   }
 }
 
 void DiagnosticsRecorder::setBufferDuration(float duration)
 {
   boost::mutex::scoped_lock lock_bufferize( mutex_ );
-  buffer_size_ = static_cast<size_t>(duration*(conv_frequency_/max_counter_));
   buffer_duration_ = duration;
-  buffer_.set_capacity(buffer_size_);
+}
+
+void DiagnosticsRecorder::setProfile(const RecordProfile& profile)
+{
+  filter_.setProfile(profile);
 }
 
 } //publisher
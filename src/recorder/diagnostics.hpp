@@ -18,16 +18,13 @@
 #ifndef DIAGNOSTICS_RECORDER_HPP
 #define DIAGNOSTICS_RECORDER_HPP
 
-/*
-* BOOST includes
-*/
-#include <boost/circular_buffer.hpp>
-
 /*
 * LOCAL includes
 */
 #include <naoqi_driver/recorder/globalrecorder.hpp>
+#include <naoqi_driver/recorder/record_profile.hpp>
 #include "../helpers/recorder_helpers.hpp"
+#include "serialized_buffer.hpp"
 
 /*
 * ROS includes
@@ -51,10 +48,12 @@ public:
 
   void bufferize(diagnostic_msgs::DiagnosticArray& msg );
 
-  void writeDump(const ros::Time& time);
+  DumpSnapshot snapshot(const ros::Time& time);
 
   void setBufferDuration(float duration);
 
+  void setProfile(const RecordProfile& profile);
+
   inline std::string topic() const
   {
     return topic_;
@@ -78,8 +77,9 @@ public:
 protected:
   std::string topic_;
 
-  boost::circular_buffer<diagnostic_msgs::DiagnosticArray> buffer_;
-  size_t buffer_size_;
+  /** serialized diagnostics of the last buffer_duration_ seconds */
+  SerializedBuffer buffer_;
+  size_t channel_;
   float buffer_duration_;
 
   boost::mutex mutex_;
@@ -88,6 +88,7 @@ protected:
   bool is_subscribed_;
 
   boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr_;
+  RecordFilter filter_;
 
   float buffer_frequency_;
   float conv_frequency_;
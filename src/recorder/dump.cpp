@@ -0,0 +1,112 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/*
+* LOCAL includes
+*/
+#include "dump.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <algorithm>
+#include <queue>
+
+namespace naoqi
+{
+namespace recorder
+{
+
+namespace
+{
+
+bool olderThan( const DumpRecord& lhs, const DumpRecord& rhs )
+{
+  return lhs.stamp < rhs.stamp;
+}
+
+bool newerThan( const DumpRecord& lhs, const DumpRecord& rhs )
+{
+  return rhs.stamp < lhs.stamp;
+}
+
+/** Oldest record not merged yet of a run */
+struct RunHead
+{
+  RunHead( const ros::Time& stamp, size_t run, size_t position ):
+    stamp( stamp ), run( run ), position( position )
+  {}
+
+  // std::priority_queue gives the greatest first, and equal stamps keep the order of the snapshots
+  bool operator<( const RunHead& other ) const
+  {
+    return stamp > other.stamp || ( stamp == other.stamp && run > other.run );
+  }
+
+  ros::Time stamp;
+  size_t run;
+  size_t position;
+};
+
+} // anonymous
+
+size_t writeSnapshots( const boost::shared_ptr<GlobalRecorder>& gr, const std::vector<DumpSnapshot>& snapshots )
+{
+  std::vector< std::vector<DumpRecord> > runs( snapshots.size() );
+  for ( size_t i=0; i<snapshots.size(); ++i )
+  {
+    if ( snapshots[i] )
+    {
+      snapshots[i]( runs[i] );
+      // a buffer is filled in push order, only a message stamped before the previous one needs a sort
+      if ( std::adjacent_find( runs[i].begin(), runs[i].end(), newerThan ) != runs[i].end() )
+      {
+        std::stable_sort( runs[i].begin(), runs[i].end(), olderThan );
+      }
+    }
+  }
+
+  std::priority_queue<RunHead> heads;
+  for ( size_t i=0; i<runs.size(); ++i )
+  {
+    if ( !runs[i].empty() )
+    {
+      heads.push( RunHead( runs[i].front().stamp, i, 0 ) );
+    }
+  }
+  size_t count = 0;
+  while ( !heads.empty() )
+  {
+    RunHead head = heads.top();
+    heads.pop();
+    DumpRecord& record = runs[head.run][head.position];
+    // blocking whatever the overflow policy, a minidump keeps all its records
+    gr->writeSerialized( record.topic, record.message, record.stamp );
+    // the queue of the writer thread holds the bytes now, they are freed once written
+    record.message = tools::SerializedMessage();
+    ++count;
+    if ( ++head.position < runs[head.run].size() )
+    {
+      head.stamp = runs[head.run][head.position].stamp;
+      heads.push( head );
+    }
+  }
+  return count;
+}
+
+} // recorder
+} // naoqi
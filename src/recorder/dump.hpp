@@ -0,0 +1,64 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef DUMP_HPP
+#define DUMP_HPP
+
+/*
+* LOCAL includes
+*/
+#include <naoqi_driver/recorder/globalrecorder.hpp>
+#include "../tools/serialized_message.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <string>
+#include <vector>
+
+/*
+* ROS includes
+*/
+#include <ros/time.h>
+
+namespace naoqi
+{
+namespace recorder
+{
+
+/**
+* @brief A message of a minidump, ready to be written in the ROSbag
+*/
+struct DumpRecord
+{
+  std::string topic;
+  tools::SerializedMessage message;
+  ros::Time stamp;
+};
+
+/**
+* @brief Write the messages of the snapshots in the ROSbag of gr, in timestamp order
+* @note the snapshots only hand their serialized messages over, each one gives a run already in push order;
+* the runs are merged on the calling thread
+* @return the number of messages written
+*/
+size_t writeSnapshots( const boost::shared_ptr<GlobalRecorder>& gr, const std::vector<DumpSnapshot>& snapshots );
+
+} // recorder
+} // naoqi
+
+#endif
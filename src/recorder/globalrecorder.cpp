@@ -19,10 +19,15 @@
 * LOCAL includes
 */
 #include <naoqi_driver/recorder/globalrecorder.hpp>
+#include "bag_storage.hpp"
+#include "blackbox.hpp"
+#include "../tools/serialized_message.hpp"
+#include "../tools/trace.hpp"
 
 /*
 * STANDARD includes
 */
+#include <algorithm>
 #include <ctime>
 #include <sstream>
 
@@ -60,6 +65,19 @@ namespace recorder
   , _processMutex()
   , _nameBag("")
   , _isStarted(false)
+  , _compression(rosbag::compression::Uncompressed)
+  , _rotationMaxBytes(0)
+  , _rotationMaxDuration(0)
+  , _budgetTotal(128*1024*1024)
+  , _budgetTopicDefault(4*1024*1024)
+  , _budgetReserved(0)
+  , _storage(boost::make_shared<BagStorage>(boost::filesystem::current_path().string()))
+  , _queueBytes(0)
+  , _queueMaxBytes(32*1024*1024)
+  , _overflowPolicy(BLOCK)
+  , _bytesWritten(0)
+  , _droppedMessages(0)
+  , _failedMessages(0)
   {
     if (!prefix_topic.empty())
     {
@@ -71,9 +89,196 @@ namespace recorder
     }
   }
 
-  void GlobalRecorder::startRecord(const std::string& prefix_bag) {
+  GlobalRecorder::~GlobalRecorder()
+  {
+    if (_isStarted) {
+      stopRecord();
+    }
+  }
+
+  void GlobalRecorder::setWriteQueue(size_t max_bytes, OverflowPolicy policy)
+  {
+    boost::mutex::scoped_lock queueLock( _queueMutex );
+    _queueMaxBytes = max_bytes;
+    _overflowPolicy = policy;
+  }
+
+  void GlobalRecorder::setCompression(rosbag::compression::CompressionType compression)
+  {
+    boost::mutex::scoped_lock startLock( _processMutex );
+    if (_isStarted) {
+      qiLogError() << "The compression cannot be changed while recording.";
+      return;
+    }
+    _compression = compression;
+  }
+
+  void GlobalRecorder::setRotation(boost::uint64_t max_bytes, double max_duration)
+  {
     boost::mutex::scoped_lock startLock( _processMutex );
+    if (_isStarted) {
+      qiLogError() << "The rotation cannot be changed while recording.";
+      return;
+    }
+    _rotationMaxBytes = max_bytes;
+    _rotationMaxDuration = ros::WallDuration(max_duration);
+  }
+
+  std::vector<std::string> GlobalRecorder::getBagFiles()
+  {
+    boost::mutex::scoped_lock filesLock( _bagFilesMutex );
+    return _bagFiles;
+  }
+
+  void GlobalRecorder::setBufferBudget(size_t total_bytes, size_t topic_bytes, const std::map<std::string, size_t>& topics_bytes)
+  {
+    boost::mutex::scoped_lock budgetLock( _budgetMutex );
+    _budgetTotal = total_bytes;
+    _budgetTopicDefault = topic_bytes;
+    _budgetTopics = topics_bytes;
+  }
+
+  size_t GlobalRecorder::reserveBuffer(const std::string& topic)
+  {
+    boost::mutex::scoped_lock budgetLock( _budgetMutex );
+    const std::string& key = (!topic.empty() && topic[0] == '/') ? topic.substr(1) : topic;
+    std::map<std::string, size_t>::const_iterator it = _budgetTopics.find(key);
+    size_t requested = (it != _budgetTopics.end()) ? it->second : _budgetTopicDefault;
+
+    size_t available = (_budgetReserved < _budgetTotal) ? _budgetTotal - _budgetReserved : 0;
+    size_t granted = std::min(requested, available);
+    if (granted < requested) {
+      qiLogWarning() << "The buffer of " << key << " only gets " << granted << " bytes out of " << requested
+                     << ", the global buffer budget of " << _budgetTotal << " bytes is exhausted";
+    }
+    _budgetReserved += granted;
+    return granted;
+  }
+
+  void GlobalRecorder::releaseBuffer(size_t bytes)
+  {
+    boost::mutex::scoped_lock budgetLock( _budgetMutex );
+    _budgetReserved -= std::min(bytes, _budgetReserved);
+  }
+
+  size_t GlobalRecorder::bufferBytesReserved()
+  {
+    boost::mutex::scoped_lock budgetLock( _budgetMutex );
+    return _budgetReserved;
+  }
+
+  void GlobalRecorder::enableBlackBox(const std::string& path, size_t size)
+  {
+    boost::system::error_code ec;
+    if (boost::filesystem::exists(path)) {
+      _previousBlackBox = path + ".previous";
+      boost::filesystem::rename(path, _previousBlackBox, ec);
+      if (ec) {
+        qiLogError() << "Cannot keep the previous black box " << path << ": " << ec.message();
+        _previousBlackBox.clear();
+      }
+    }
+    try {
+      _blackBox = boost::make_shared<BlackBox>(path, size);
+      std::cout << YELLOW << "The buffers are kept in the black box " << BOLDCYAN << path << RESETCOLOR << std::endl;
+    } catch (const std::exception& e) {
+      qiLogError() << e.what() << ", the buffers stay in memory";
+    }
+  }
+
+  const boost::shared_ptr<BlackBox>& GlobalRecorder::blackBox() const
+  {
+    return _blackBox;
+  }
+
+  void GlobalRecorder::writeSerialized(const std::string& topic, const tools::SerializedMessage& msg, const ros::Time& time)
+  {
     if (!_isStarted) {
+      return;
+    }
+    std::string ros_topic;
+    if (topic[0]!='/')
+    {
+      ros_topic = _prefix_topic+topic;
+    }
+    else
+    {
+      ros_topic = topic;
+    }
+    WriteRequest request;
+    request.size = msg.size;
+    request.write = boost::bind(&GlobalRecorder::writeToBag<tools::SerializedMessage>, _1, ros_topic, time, msg);
+    push(request, true);
+  }
+
+  std::string GlobalRecorder::recoverBlackBox()
+  {
+    if (_previousBlackBox.empty() || !boost::filesystem::exists(_previousBlackBox)) {
+      return "No black box was left by a previous run.";
+    }
+    if (isStarted()) {
+      return "Cannot recover the black box while recording.";
+    }
+    startRecord("blackbox");
+    size_t count = 0;
+    try {
+      count = BlackBox::recover(_previousBlackBox, boost::bind(&GlobalRecorder::writeSerialized, this, _1, _2, _3));
+    } catch (const std::exception& e) {
+      qiLogError() << e.what();
+    }
+    std::cout << YELLOW << count << " messages recovered from " << BOLDCYAN << _previousBlackBox << RESETCOLOR << std::endl;
+    return stopRecord();
+  }
+
+  const boost::shared_ptr<BagStorage>& GlobalRecorder::storage() const
+  {
+    return _storage;
+  }
+
+  void GlobalRecorder::openBag(size_t index)
+  {
+    std::stringstream name;
+    name << _baseNameBag;
+    // a record which may be split has all its bags numbered, like rosbag record --split does
+    if (_rotationMaxBytes > 0 || !_rotationMaxDuration.isZero()) {
+      name << "_" << index;
+    }
+    name << ".bag";
+    _nameBag = name.str();
+
+    _bag.open(_nameBag, rosbag::bagmode::Write);
+    _storage->bagOpened(_nameBag);
+    _bag.setCompression(_compression);
+    _bagOpenTime = ros::WallTime::now();
+
+    boost::mutex::scoped_lock filesLock( _bagFilesMutex );
+    _bagFiles.push_back(_nameBag);
+  }
+
+  void GlobalRecorder::rotateIfNeeded()
+  {
+    if ((_rotationMaxBytes > 0 && _bag.getSize() >= _rotationMaxBytes)
+        || (!_rotationMaxDuration.isZero() && ros::WallTime::now() - _bagOpenTime >= _rotationMaxDuration)) {
+      // the queue keeps filling meanwhile, nothing is lost
+      _bag.close();
+      _storage->bagClosed(_nameBag);
+      std::cout << YELLOW << "The bag " << BOLDCYAN << _nameBag << RESETCOLOR << YELLOW << " is closed" << RESETCOLOR << std::endl;
+      size_t index;
+      {
+        boost::mutex::scoped_lock filesLock( _bagFilesMutex );
+        index = _bagFiles.size();
+      }
+      openBag(index);
+      std::cout << YELLOW << "The bag " << BOLDCYAN << _nameBag << RESETCOLOR << YELLOW << " is opened" << RESETCOLOR << std::endl;
+    }
+  }
+
+  void GlobalRecorder::startRecord(const std::string& prefix_bag) {
+    boost::mutex::scoped_lock startLock( _processMutex );
+    if (_isStarted) {
+      throw std::runtime_error("Cannot start a record. The module is already recording.");
+    }
+    else {
       try {
         // Get current path
         boost::filesystem::path cur_path( boost::filesystem::current_path() );
@@ -87,42 +292,64 @@ namespace recorder
         std::strftime(buffer,80,"%d-%m-%Y_%I:%M:%S",timeinfo);
 
         if (!prefix_bag.empty()) {
-          _nameBag = cur_path.string()+"/"+prefix_bag+"_"+buffer;
+          _baseNameBag = cur_path.string()+"/"+prefix_bag+"_"+buffer;
         }
         else {
-          _nameBag = cur_path.string()+"/"+buffer;
+          _baseNameBag = cur_path.string()+"/"+buffer;
         }
-        _nameBag.append(".bag");
 
-        _bag.open(_nameBag, rosbag::bagmode::Write);
-        _isStarted = true;
+        {
+          boost::mutex::scoped_lock filesLock( _bagFilesMutex );
+          _bagFiles.clear();
+        }
+        openBag(0);
+        {
+          boost::mutex::scoped_lock queueLock( _queueMutex );
+          _isStarted = true;
+        }
+        _writerThread = boost::thread( &GlobalRecorder::writerLoop, this );
         std::cout << YELLOW << "The bag " << BOLDCYAN << _nameBag << RESETCOLOR << YELLOW << " is opened" << RESETCOLOR << std::endl;
       } catch (std::exception e){
         throw std::runtime_error(e.what());
       }
     }
-    else {
-      qiLogError() << "Cannot start a record. The module is already recording.";
-    }
   }
 
   std::string GlobalRecorder::stopRecord(const std::string& robot_ip) {
     boost::mutex::scoped_lock stopLock( _processMutex );
     if (_isStarted) {
+      {
+        boost::mutex::scoped_lock queueLock( _queueMutex );
+        _isStarted = false;
+      }
+      // the writer thread flushes what is queued before leaving
+      _queueNotEmpty.notify_all();
+      _queueNotFull.notify_all();
+      _writerThread.join();
       _bag.close();
-      _isStarted = false;
+      _storage->bagClosed(_nameBag);
 
+      const std::vector<std::string> files = getBagFiles();
       std::stringstream message;
-      message << _nameBag;
+      for (std::vector<std::string>::const_iterator it = files.begin(); it != files.end(); ++it) {
+        if (it != files.begin()) {
+          message << std::endl;
+        }
+        message << *it;
+      }
       std::cout << YELLOW << "The bag " << BOLDCYAN << _nameBag << RESETCOLOR << YELLOW << " is closed" << RESETCOLOR << std::endl;
+      if (_droppedMessages > 0) {
+        std::cout << BOLDYELLOW << _droppedMessages << " messages have been dropped by the recorder since startup" << RESETCOLOR << std::endl;
+      }
 
       // Check if we are on a robot
       char* current_path;
       current_path = getenv("HOME");
       std::string cp = current_path;
       if (!(cp.find("nao") == std::string::npos)) {
+        const std::string& download = (files.size() > 1) ? _baseNameBag+"_*.bag" : _nameBag;
         std::cout << BOLDRED << "To download this bag on your computer:" << RESETCOLOR << std::endl
-                     << GREEN << "\t$ scp nao@" << robot_ip << ":" << _nameBag << " <LOCAL_PATH>" << RESETCOLOR
+                     << GREEN << "\t$ scp nao@" << robot_ip << ":" << download << " <LOCAL_PATH>" << RESETCOLOR
                         << std::endl;
       }
 
@@ -139,8 +366,97 @@ namespace recorder
     return _isStarted;
   }
 
+  size_t GlobalRecorder::queueDepth() {
+    boost::mutex::scoped_lock queueLock( _queueMutex );
+    return _queue.size();
+  }
+
+  boost::uint64_t GlobalRecorder::bytesWritten() {
+    boost::mutex::scoped_lock queueLock( _queueMutex );
+    return _bytesWritten;
+  }
+
+  boost::uint64_t GlobalRecorder::droppedMessages() {
+    boost::mutex::scoped_lock queueLock( _queueMutex );
+    return _droppedMessages;
+  }
+
+  boost::uint64_t GlobalRecorder::failedMessages() {
+    boost::mutex::scoped_lock queueLock( _queueMutex );
+    return _failedMessages;
+  }
+
+  void GlobalRecorder::push(const WriteRequest& request, bool block) {
+    boost::mutex::scoped_lock queueLock( _queueMutex );
+    if (!_isStarted) {
+      return;
+    }
+    const OverflowPolicy policy = block ? BLOCK : _overflowPolicy;
+    // a message bigger than the whole queue is still accepted when the queue is empty
+    while (!_queue.empty() && _queueBytes + request.size > _queueMaxBytes) {
+      if (policy == DROP_NEWEST) {
+        ++_droppedMessages;
+        return;
+      }
+      else if (policy == DROP_OLDEST) {
+        _queueBytes -= _queue.front().size;
+        _queue.pop_front();
+        ++_droppedMessages;
+      }
+      else {
+        _queueNotFull.wait(queueLock);
+        if (!_isStarted) {
+          return;
+        }
+      }
+    }
+    _queue.push_back(request);
+    _queueBytes += request.size;
+    _queueNotEmpty.notify_one();
+  }
+
+  void GlobalRecorder::writerLoop() {
+    NAOQI_TRACE_THREAD_NAME( "bag writer" );
+    WriteRequest request;
+    while (true) {
+      {
+        boost::mutex::scoped_lock queueLock( _queueMutex );
+        while (_queue.empty() && _isStarted) {
+          _queueNotEmpty.wait(queueLock);
+        }
+        if (_queue.empty()) {
+          // stopped and flushed
+          return;
+        }
+        request = _queue.front();
+        _queue.pop_front();
+        _queueBytes -= request.size;
+      }
+      _queueNotFull.notify_all();
+
+      try {
+        NAOQI_TRACE_SCOPE_VALUE( "bag", _nameBag, "bytes", request.size );
+        request.write(_bag);
+      } catch (const std::exception& e) {
+        qiLogError() << "Cannot write in the bag " << _nameBag << ": " << e.what();
+        boost::mutex::scoped_lock queueLock( _queueMutex );
+        ++_failedMessages;
+        continue;
+      }
+
+      try {
+        rotateIfNeeded();
+      } catch (const std::exception& e) {
+        qiLogError() << "Cannot rotate the bag " << _nameBag << ": " << e.what();
+      }
+
+      boost::mutex::scoped_lock queueLock( _queueMutex );
+      _bytesWritten += request.size;
+    }
+  }
+
   void GlobalRecorder::write(const std::string& topic, const std::vector<geometry_msgs::TransformStamped>& msgtf) {
-    if (!msgtf.empty())
+    if (_isStarted && !msgtf.empty())
     {
       std::string ros_topic;
       if (topic[0]!='/')
@@ -156,14 +472,8 @@ namespace recorder
       if (!msgtf[0].header.stamp.isZero()) {
         now = msgtf[0].header.stamp;
       }
-      for (std::vector<geometry_msgs::TransformStamped>::const_iterator it = msgtf.begin(); it != msgtf.end(); ++it)
-      {
-        message.transforms.push_back(*it);
-      }
-      boost::mutex::scoped_lock writeLock( _processMutex );
-      if (_isStarted) {
-        _bag.write(ros_topic, now, message);
-      }
+      message.transforms = msgtf;
+      write(ros_topic, message, now);
     }
   }
 
@@ -30,40 +30,76 @@ JointStateRecorder::JointStateRecorder( const std::string& topic, float buffer_f
   buffer_duration_(helpers::recorder::bufferDefaultDuration),
   is_initialized_( false ),
   is_subscribed_( false ),
+  fixed_frames_written_( false ),
   buffer_frequency_(buffer_frequency),
   counter_(1)
-{}
+{
+  channel_js_ = buffer_.addChannel<sensor_msgs::JointState>(topic_);
+  channel_tf_ = buffer_.addChannel<tf2_msgs::TFMessage>("/tf");
+}
 
 void JointStateRecorder::write( const sensor_msgs::JointState& js_msg,
                                 const std::vector<geometry_msgs::TransformStamped>& tf_transforms )
 {
-  if (!js_msg.header.stamp.isZero()) {
-    gr_->write(topic_, js_msg, js_msg.header.stamp);
+  writeAt( js_msg, js_msg.header.stamp, tf_transforms );
+}
+
+void JointStateRecorder::writeSerialized( const tools::SerializedMessage& js_msg, const ros::Time& stamp,
+                                          const std::vector<geometry_msgs::TransformStamped>& tf_transforms )
+{
+  writeAt( js_msg, stamp, tf_transforms );
+}
+
+template <class M>
+void JointStateRecorder::writeAt( const M& js_msg, const ros::Time& stamp,
+                                  const std::vector<geometry_msgs::TransformStamped>& tf_transforms )
+{
+  if (!filter_.accept(stamp))
+  {
+    return;
+  }
+  if (!stamp.isZero()) {
+    gr_->write(topic_, js_msg, stamp);
   }
   else {
     gr_->write(topic_, js_msg);
   }
-  gr_->write("/tf", tf_transforms);
-}
-
-void JointStateRecorder::writeDump(const ros::Time& time)
-{
-  boost::mutex::scoped_lock lock_write_buffer( mutex_ );
-  boost::circular_buffer< std::vector<geometry_msgs::TransformStamped> >::iterator it_tf;
-  for (it_tf = bufferTF_.begin(); it_tf != bufferTF_.end(); it_tf++)
+  if (filter_.strips("tf"))
   {
-    gr_->write("/tf", *it_tf);
+    return;
   }
-  for (boost::circular_buffer<sensor_msgs::JointState>::iterator it_js = bufferJoinState_.begin();
-       it_js != bufferJoinState_.end(); it_js++)
+  if (!filter_.strips("fixed_frames"))
   {
-    if (!it_js->header.stamp.isZero()) {
-      gr_->write(topic_, *it_js, it_js->header.stamp);
+    gr_->write("/tf", tf_transforms);
+    return;
+  }
+
+  // the fixed frames never move, they are only recorded once on the latched /tf_static
+  std::vector<geometry_msgs::TransformStamped> moving_transforms;
+  std::vector<geometry_msgs::TransformStamped> fixed_transforms;
+  for (std::vector<geometry_msgs::TransformStamped>::const_iterator it = tf_transforms.begin(); it != tf_transforms.end(); ++it)
+  {
+    if (fixed_frames_.find(it->child_frame_id) == fixed_frames_.end())
+    {
+      moving_transforms.push_back(*it);
     }
-    else {
-      gr_->write(topic_, *it_js);
+    else if (!fixed_frames_written_)
+    {
+      fixed_transforms.push_back(*it);
     }
   }
+  if (!fixed_transforms.empty())
+  {
+    gr_->write("/tf_static", fixed_transforms);
+    fixed_frames_written_ = true;
+  }
+  gr_->write("/tf", moving_transforms);
+}
+
+DumpSnapshot JointStateRecorder::snapshot(const ros::Time& time)
+{
+  boost::mutex::scoped_lock lock_write_buffer( mutex_ );
+  return boost::bind( &SerializedBuffer::Snapshot::collect, buffer_.snapshot(), _1 );
 }
 
 void JointStateRecorder::reset(boost::shared_ptr<GlobalRecorder> gr, float conv_frequency)
@@ -73,20 +109,31 @@ void JointStateRecorder::reset(boost::shared_ptr<GlobalRecorder> gr, float conv_
   if (buffer_frequency_ != 0)
   {
     max_counter_ = static_cast<int>(conv_frequency/buffer_frequency_);
-    buffer_size_ = static_cast<size_t>(buffer_duration_*(conv_frequency/max_counter_));
   }
   else
   {
     max_counter_ = 1;
-    buffer_size_ = static_cast<size_t>(buffer_duration_*conv_frequency);
   }
-  bufferJoinState_.resize(buffer_size_);
-  bufferTF_.resize(buffer_size_);
+  boost::mutex::scoped_lock lock_bufferize( mutex_ );
+  buffer_.reset(gr, topic());
   is_initialized_ = true;
 }
 
 void JointStateRecorder::bufferize( const sensor_msgs::JointState& js_msg,
                 const std::vector<geometry_msgs::TransformStamped>& tf_transforms )
+{
+  bufferizeAt( js_msg, js_msg.header.stamp, tf_transforms );
+}
+
+void JointStateRecorder::bufferizeSerialized( const tools::SerializedMessage& js_msg, const ros::Time& stamp,
+                                              const std::vector<geometry_msgs::TransformStamped>& tf_transforms )
+{
+  bufferizeAt( js_msg, stamp, tf_transforms );
+}
+
+template <class M>
+void JointStateRecorder::bufferizeAt( const M& js_msg, const ros::Time& js_stamp,
+                                      const std::vector<geometry_msgs::TransformStamped>& tf_transforms )
 {
   boost::mutex::scoped_lock lock_bufferize( mutex_ );
   if (counter_ < max_counter_)
@@ -96,18 +143,34 @@ void JointStateRecorder::bufferize( const sensor_msgs::JointState& js_msg,
   else
   {
     counter_ = 1;
-    bufferJoinState_.push_back(js_msg);
-    bufferTF_.push_back(tf_transforms);
+    const ros::Time& stamp = js_stamp.isZero() ? ros::Time::now() : js_stamp;
+    buffer_.push(channel_js_, js_msg, stamp);
+    if (!tf_transforms.empty())
+    {
+      tf2_msgs::TFMessage tf_msg;
+      tf_msg.transforms = tf_transforms;
+      buffer_.push(channel_tf_, tf_msg, tf_transforms[0].header.stamp.isZero() ? stamp : tf_transforms[0].header.stamp);
+    }
+    buffer_.removeOlderThan(stamp - ros::Duration(buffer_duration_));
   }
 }
 
 void JointStateRecorder::setBufferDuration(float duration)
 {
   boost::mutex::scoped_lock lock_bufferize( mutex_ );
-  buffer_size_ = static_cast<size_t>(duration*(conv_frequency_/max_counter_));
   buffer_duration_ = duration;
-  bufferJoinState_.set_capacity(buffer_size_);
-  bufferTF_.set_capacity(buffer_size_);
+}
+
+void JointStateRecorder::setProfile(const RecordProfile& profile)
+{
+  filter_.setProfile(profile);
+  // called when a record starts
+  fixed_frames_written_ = false;
+}
+
+void JointStateRecorder::setFixedFrames(const std::set<std::string>& frames)
+{
+  fixed_frames_ = frames;
 }
 
 } //publisher
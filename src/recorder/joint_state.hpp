@@ -18,21 +18,24 @@
 #ifndef JOINT_STATE_RECORDER_HPP
 #define JOINT_STATE_RECORDER_HPP
 
-/*
-* BOOST includes
-*/
-#include <boost/circular_buffer.hpp>
-
 /*
 * LOCAL includes
 */
 #include <naoqi_driver/recorder/globalrecorder.hpp>
+#include <naoqi_driver/recorder/record_profile.hpp>
 #include "../helpers/recorder_helpers.hpp"
+#include "serialized_buffer.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <set>
 
 /*
 * ROS includes
 */
 #include <sensor_msgs/JointState.h>
+#include <tf2_msgs/TFMessage.h>
 
 namespace naoqi
 {
@@ -48,15 +51,31 @@ public:
   void write( const sensor_msgs::JointState& js_msg,
               const std::vector<geometry_msgs::TransformStamped>& tf_transforms );
 
+  /**
+  * @brief Write joint states serialized by the converter, the ROSbag gets a copy of their bytes
+  * @param stamp stamp of the header of the joint states
+  */
+  void writeSerialized( const tools::SerializedMessage& js_msg, const ros::Time& stamp,
+                        const std::vector<geometry_msgs::TransformStamped>& tf_transforms );
+
   void reset( boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr, float conv_frequency );
 
   void bufferize( const sensor_msgs::JointState& js_msg,
                   const std::vector<geometry_msgs::TransformStamped>& tf_transforms );
 
-  void writeDump(const ros::Time& time);
+  /** Buffer joint states serialized by the converter, their bytes are copied as they are */
+  void bufferizeSerialized( const tools::SerializedMessage& js_msg, const ros::Time& stamp,
+                            const std::vector<geometry_msgs::TransformStamped>& tf_transforms );
+
+  DumpSnapshot snapshot(const ros::Time& time);
 
   void setBufferDuration(float duration);
 
+  void setProfile(const RecordProfile& profile);
+
+  /** Child frames which never move, stripped from /tf and written once to /tf_static with the fixed_frames profile */
+  void setFixedFrames(const std::set<std::string>& frames);
+
   inline std::string topic() const
   {
     return topic_;
@@ -78,11 +97,19 @@ public:
   }
 
 protected:
+  /** M is the joint states or their serialized bytes */
+  template <class M>
+  void writeAt( const M& js_msg, const ros::Time& stamp, const std::vector<geometry_msgs::TransformStamped>& tf_transforms );
+
+  template <class M>
+  void bufferizeAt( const M& js_msg, const ros::Time& js_stamp, const std::vector<geometry_msgs::TransformStamped>& tf_transforms );
+
   std::string topic_;
 
-  boost::circular_buffer<sensor_msgs::JointState> bufferJoinState_;
-  boost::circular_buffer< std::vector<geometry_msgs::TransformStamped> > bufferTF_;
-  size_t buffer_size_;
+  /** serialized joint states and transforms of the last buffer_duration_ seconds */
+  SerializedBuffer buffer_;
+  size_t channel_js_;
+  size_t channel_tf_;
   float buffer_duration_;
 
   boost::mutex mutex_;
@@ -91,6 +118,11 @@ protected:
   bool is_subscribed_;
 
   boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr_;
+  RecordFilter filter_;
+  /** child frames of the fixed segments of the robot */
+  std::set<std::string> fixed_frames_;
+  /** whether the fixed frames were written to /tf_static since the record started */
+  bool fixed_frames_written_;
 
   float buffer_frequency_;
   float conv_frequency_;
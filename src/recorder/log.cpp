@@ -27,17 +27,21 @@ LogRecorder::LogRecorder(const std::string& topic , float buffer_frequency):
   buffer_duration_(helpers::recorder::bufferDefaultDuration),
   buffer_frequency_(buffer_frequency),
   counter_(1)
-{}
+{
+  channel_ = buffer_.addChannel<rosgraph_msgs::Log>(topic_);
+}
 
 void LogRecorder::write(std::list<rosgraph_msgs::Log>& log_msgs)
 {
   while ( !log_msgs.empty() )
   {
-    if (!log_msgs.front().header.stamp.isZero()) {
-      gr_->write(topic_, log_msgs.front(), log_msgs.front().header.stamp);
-    }
-    else {
-      gr_->write(topic_, log_msgs.front());
+    if (filter_.accept(log_msgs.front().header.stamp)) {
+      if (!log_msgs.front().header.stamp.isZero()) {
+        gr_->write(topic_, log_msgs.front(), log_msgs.front().header.stamp);
+      }
+      else {
+        gr_->write(topic_, log_msgs.front());
+      }
     }
     {
       log_msgs.pop_front();
@@ -45,14 +49,10 @@ void LogRecorder::write(std::list<rosgraph_msgs::Log>& log_msgs)
   }
 }
 
-void LogRecorder::writeDump(const ros::Time& time)
+DumpSnapshot LogRecorder::snapshot(const ros::Time& time)
 {
   boost::mutex::scoped_lock lock_write_buffer( mutex_ );
-  boost::circular_buffer< std::list<rosgraph_msgs::Log> >::iterator it;
-  for (it = buffer_.begin(); it != buffer_.end(); it++)
-  {
-    write(*it);
-  }
+  return boost::bind( &SerializedBuffer::Snapshot::collect, buffer_.snapshot(), _1 );
 }
 
 void LogRecorder::reset(boost::shared_ptr<GlobalRecorder> gr, float conv_frequency)
@@ -62,14 +62,13 @@ void LogRecorder::reset(boost::shared_ptr<GlobalRecorder> gr, float conv_frequen
   if (buffer_frequency_ != 0)
   {
     max_counter_ = static_cast<int>(conv_frequency/buffer_frequency_);
-    buffer_size_ = static_cast<size_t>(buffer_duration_*(conv_frequency/max_counter_));
   }
   else
   {
     max_counter_ = 1;
-    buffer_size_ = static_cast<size_t>(buffer_duration_*conv_frequency);
   }
-  buffer_.resize(buffer_size_);
+  boost::mutex::scoped_lock lock_bufferize( mutex_ );
+  buffer_.reset(gr, topic());
   is_initialized_ = true;
 }
 
@@ -83,16 +82,27 @@ void LogRecorder::bufferize( std::list<rosgraph_msgs::Log>& log_msgs )
   else
   {
     counter_ = 1;
-    buffer_.push_back(log_msgs);
+    ros::Time stamp = ros::Time::now();
+    for (std::list<rosgraph_msgs::Log>::const_iterator it = log_msgs.begin(); it != log_msgs.end(); ++it)
+    {
+      if (!it->header.stamp.isZero()) {
+        stamp = it->header.stamp;
+      }
+      buffer_.push(channel_, *it, stamp);
+    }
+    buffer_.removeOlderThan(stamp - ros::Duration(buffer_duration_));
   }
 }
 
 void LogRecorder::setBufferDuration(float duration)
 {
   boost::mutex::scoped_lock lock_bufferize( mutex_ );
-  buffer_size_ = static_cast<size_t>(duration*(conv_frequency_/max_counter_));
   buffer_duration_ = duration;
-  buffer_.set_capacity(buffer_size_);
+}
+
+void LogRecorder::setProfile(const RecordProfile& profile)
+{
+  filter_.setProfile(profile);
 }
 
 } //publisher
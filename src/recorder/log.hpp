@@ -18,16 +18,13 @@
 #ifndef LOG_RECORDER_HPP
 #define LOG_RECORDER_HPP
 
-/*
-* BOOST includes
-*/
-#include <boost/circular_buffer.hpp>
-
 /*
 * LOCAL includes
 */
 #include <naoqi_driver/recorder/globalrecorder.hpp>
+#include <naoqi_driver/recorder/record_profile.hpp>
 #include "../helpers/recorder_helpers.hpp"
+#include "serialized_buffer.hpp"
 
 /*
 * ROS includes
@@ -52,10 +49,12 @@ public:
 
   void bufferize( std::list<rosgraph_msgs::Log>& log_msgs );
 
-  void writeDump(const ros::Time& time);
+  DumpSnapshot snapshot(const ros::Time& time);
 
   void setBufferDuration(float duration);
 
+  void setProfile(const RecordProfile& profile);
+
   inline std::string topic() const
   {
     return topic_;
@@ -79,8 +78,9 @@ public:
 protected:
   std::string topic_;
 
-  boost::circular_buffer< std::list<rosgraph_msgs::Log> > buffer_;
-  size_t buffer_size_;
+  /** serialized logs of the last buffer_duration_ seconds */
+  SerializedBuffer buffer_;
+  size_t channel_;
   float buffer_duration_;
 
   boost::mutex mutex_;
@@ -89,6 +89,7 @@ protected:
   bool is_subscribed_;
 
   boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr_;
+  RecordFilter filter_;
 
   float buffer_frequency_;
   float conv_frequency_;
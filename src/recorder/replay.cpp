@@ -0,0 +1,82 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+/*
+* LOCAL includes
+*/
+#include "replay.hpp"
+
+namespace naoqi
+{
+namespace recorder
+{
+
+ReplayRecorder::ReplayRecorder( const std::string& topic, const boost::shared_ptr<const tools::MessageType>& type ):
+  topic_( topic ),
+  buffer_duration_( helpers::recorder::bufferDefaultDuration ),
+  is_initialized_( false ),
+  is_subscribed_( false )
+{
+  channel_ = buffer_.addChannel( topic_, type );
+}
+
+void ReplayRecorder::write( const tools::SerializedMessage& msg )
+{
+  const ros::Time& stamp = ros::Time::now();
+  if ( !filter_.accept(stamp) )
+  {
+    return;
+  }
+  gr_->write( topic_, msg, stamp );
+}
+
+DumpSnapshot ReplayRecorder::snapshot( const ros::Time& time )
+{
+  boost::mutex::scoped_lock lock_write_buffer( mutex_ );
+  return boost::bind( &SerializedBuffer::Snapshot::collect, buffer_.snapshot(), _1 );
+}
+
+void ReplayRecorder::reset( boost::shared_ptr<GlobalRecorder> gr, float conv_frequency )
+{
+  gr_ = gr;
+  boost::mutex::scoped_lock lock_bufferize( mutex_ );
+  buffer_.reset( gr, topic_ );
+  is_initialized_ = true;
+}
+
+void ReplayRecorder::bufferize( const tools::SerializedMessage& msg )
+{
+  boost::mutex::scoped_lock lock_bufferize( mutex_ );
+  const ros::Time& stamp = ros::Time::now();
+  buffer_.push( channel_, msg, stamp );
+  buffer_.removeOlderThan( stamp - ros::Duration(buffer_duration_) );
+}
+
+void ReplayRecorder::setBufferDuration( float duration )
+{
+  boost::mutex::scoped_lock lock_bufferize( mutex_ );
+  buffer_duration_ = duration;
+}
+
+void ReplayRecorder::setProfile( const RecordProfile& profile )
+{
+  filter_.setProfile( profile );
+}
+
+} // recorder
+} // naoqi
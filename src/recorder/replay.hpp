@@ -0,0 +1,104 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef REPLAY_RECORDER_HPP
+#define REPLAY_RECORDER_HPP
+
+/*
+* LOCAL includes
+*/
+#include <naoqi_driver/recorder/globalrecorder.hpp>
+#include <naoqi_driver/recorder/record_profile.hpp>
+#include "../helpers/recorder_helpers.hpp"
+#include "../tools/serialized_message.hpp"
+#include "serialized_buffer.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <string>
+
+namespace naoqi
+{
+namespace recorder
+{
+
+/**
+* @brief Records and bufferizes messages read serialized from a ROSbag, without deserializing them
+* @note the messages are stamped with the time they are replayed at
+*/
+class ReplayRecorder
+{
+
+public:
+  ReplayRecorder( const std::string& topic, const boost::shared_ptr<const tools::MessageType>& type );
+
+  void write( const tools::SerializedMessage& msg );
+
+  void reset( boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr, float conv_frequency );
+
+  void bufferize( const tools::SerializedMessage& msg );
+
+  DumpSnapshot snapshot( const ros::Time& time );
+
+  void setBufferDuration( float duration );
+
+  void setProfile( const RecordProfile& profile );
+
+  inline std::string topic() const
+  {
+    return topic_;
+  }
+
+  inline bool isInitialized() const
+  {
+    return is_initialized_;
+  }
+
+  inline void subscribe( bool state)
+  {
+    is_subscribed_ = state;
+  }
+
+  inline bool isSubscribed() const
+  {
+    return is_subscribed_;
+  }
+
+protected:
+  std::string topic_;
+
+  /** serialized messages of the last buffer_duration_ seconds */
+  SerializedBuffer buffer_;
+  size_t channel_;
+  float buffer_duration_;
+
+  boost::mutex mutex_;
+
+  bool is_initialized_;
+  bool is_subscribed_;
+
+  boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr_;
+  RecordFilter filter_;
+
+}; // class
+
+} // recorder
+} // naoqi
+
+#endif
@@ -0,0 +1,310 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/*
+* LOCAL includes
+*/
+#include "serialized_buffer.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <algorithm>
+#include <cstring>
+
+/*
+* BOOST includes
+*/
+#include <boost/make_shared.hpp>
+
+/*
+* ALDEBARAN includes
+*/
+#include <qi/log.hpp>
+
+qiLogCategory("ros.SerializedBuffer");
+
+namespace naoqi
+{
+namespace recorder
+{
+
+namespace
+{
+
+inline bool overlaps( size_t offset, size_t size, size_t begin, size_t end )
+{
+  return offset < end && begin < offset + size;
+}
+
+/** the positions of the records are the lap of the ring shifted by it, plus their offset */
+const unsigned int lap_shift = 40;
+
+/** difference of positions up to which the bytes of a record are not overwritten, see Snapshot::collect */
+const boost::uint64_t lap_span = static_cast<boost::uint64_t>(1) << lap_shift;
+
+template <class Record>
+inline bool keyOlderThan( const Record& record, const ros::Time& time )
+{
+  return record.key < time;
+}
+
+} // anonymous
+
+SerializedBuffer::SerializedBuffer():
+  storage_(NULL),
+  slice_(NULL),
+  seq_(0),
+  capacity_(0),
+  head_(0),
+  lap_(0),
+  frontier_(boost::make_shared<boost::atomic<boost::uint64_t> >(0)),
+  pushed_(0)
+{}
+
+SerializedBuffer::~SerializedBuffer()
+{
+  if ( gr_ )
+  {
+    gr_->releaseBuffer( capacity_ );
+  }
+}
+
+void SerializedBuffer::reset( const boost::shared_ptr<GlobalRecorder>& gr, const std::string& topic )
+{
+  if ( gr_ )
+  {
+    gr_->releaseBuffer( capacity_ );
+  }
+  gr_ = gr;
+  clear();
+  capacity_ = gr_->reserveBuffer( topic );
+
+  // a slice of the black box is never given back, it is kept as long as it is big enough
+  const boost::shared_ptr<BlackBox>& blackbox = gr_->blackBox();
+  if ( slice_ == NULL || slice_->capacity < (capacity_ & ~static_cast<size_t>(7)) )
+  {
+    slice_ = blackbox ? blackbox->allocateSlice( capacity_, channels_ ) : NULL;
+  }
+  if ( slice_ != NULL )
+  {
+    heap_.reset();
+    storage_ = BlackBox::ring( slice_ );
+    slice_->head = 0;
+    slice_->tail = 0;
+  }
+  else
+  {
+    // the pages are only touched when written
+    heap_.reset( capacity_ > 0 ? new uint8_t[capacity_] : NULL );
+    storage_ = heap_.get();
+  }
+}
+
+uint8_t* SerializedBuffer::allocate( size_t channel, uint32_t size, const ros::Time& stamp )
+{
+  const size_t record_size = sizeof(BlackBox::RecordHeader) + size;
+  const size_t capacity = slice_ != NULL ? slice_->capacity : capacity_;
+  if ( size == 0 || record_size > capacity )
+  {
+    return NULL;
+  }
+
+  size_t offset = head_;
+  if ( offset + record_size > capacity )
+  {
+    // wrap: the end of the block is left unused, its records are the oldest ones
+    while ( !index_.empty() && index_.front().offset >= head_ )
+    {
+      index_.pop_front();
+    }
+    offset = 0;
+    ++lap_;
+  }
+  while ( !index_.empty() && overlaps( index_.front().offset, footprint( index_.front() ), offset, offset + record_size ) )
+  {
+    index_.pop_front();
+  }
+
+  if ( slice_ != NULL )
+  {
+    // before overwriting anything, so that a recovery never starts in the middle of this record
+    slice_->tail = index_.empty() ? offset : index_.front().offset;
+  }
+
+  Record record;
+  record.offset = offset;
+  record.size = size;
+  record.channel = channel;
+  record.stamp = stamp;
+  record.key = ( !index_.empty() && stamp < index_.back().key ) ? index_.back().key : stamp;
+  pushed_ += record_size;
+  record.end = pushed_;
+  record.position = ( lap_ << lap_shift ) + offset;
+  index_.push_back( record );
+  head_ = offset + record_size;
+
+  // a snapshot reading the ring meanwhile sees it before any of the bytes written below
+  frontier_->store( ( lap_ << lap_shift ) + head_, boost::memory_order_relaxed );
+  boost::atomic_thread_fence( boost::memory_order_release );
+
+  // the magic is only set by commit, once the message is completely serialized
+  BlackBox::RecordHeader header;
+  header.magic = 0;
+  header.size = size;
+  header.channel = channel;
+  header.reserved = 0;
+  header.seq = seq_++;
+  header.sec = stamp.sec;
+  header.nsec = stamp.nsec;
+  std::memcpy( storage_ + offset, &header, sizeof(header) );
+  return storage_ + offset + sizeof(header);
+}
+
+void SerializedBuffer::commit()
+{
+  const boost::uint32_t magic = BlackBox::record_magic;
+  std::memcpy( storage_ + index_.back().offset, &magic, sizeof(magic) );
+  if ( slice_ != NULL )
+  {
+    slice_->head = head_;
+  }
+}
+
+void SerializedBuffer::removeOlderThan( const ros::Time& time )
+{
+  index_.erase( index_.begin(), std::lower_bound( index_.begin(), index_.end(), time, keyOlderThan<Record> ) );
+  if ( slice_ != NULL )
+  {
+    if ( index_.empty() )
+    {
+      emptySlice();
+    }
+    else
+    {
+      slice_->tail = index_.front().offset;
+    }
+  }
+}
+
+void SerializedBuffer::emptySlice()
+{
+  // a recovery starts at the tail: an older record left there must not be taken for a live one.
+  // Only its header is touched, a snapshot may still be copying the message
+  slice_->tail = head_;
+  if ( head_ + sizeof(boost::uint32_t) <= slice_->capacity )
+  {
+    std::memset( storage_ + head_, 0, sizeof(boost::uint32_t) );
+  }
+}
+
+void SerializedBuffer::clear()
+{
+  index_.clear();
+  head_ = 0;
+  ++lap_;
+  frontier_->store( lap_ << lap_shift, boost::memory_order_relaxed );
+}
+
+boost::shared_ptr<const SerializedBuffer::Snapshot> SerializedBuffer::snapshot()
+{
+  boost::shared_ptr<Snapshot> snapshot = boost::make_shared<Snapshot>();
+  snapshot->channels_ = channels_;
+  if ( slice_ == NULL )
+  {
+    // swap the storages: the pages of the new one are only touched when written
+    snapshot->storage_.swap( heap_ );
+    snapshot->index_.swap( index_ );
+    heap_.reset( capacity_ > 0 ? new uint8_t[capacity_] : NULL );
+    storage_ = heap_.get();
+    clear();
+  }
+  else
+  {
+    // the records stay in the ring until they are overwritten, collect() copies them out of the lock;
+    // the buffer starts again after them, they are not recovered twice after a crash
+    snapshot->index_.swap( index_ );
+    snapshot->ring_ = storage_;
+    snapshot->blackbox_ = gr_->blackBox();
+    snapshot->frontier_ = frontier_;
+    emptySlice();
+  }
+  return snapshot;
+}
+
+void SerializedBuffer::Snapshot::collect( std::vector<DumpRecord>& records ) const
+{
+  records.reserve( records.size() + index_.size() );
+  if ( ring_ == NULL )
+  {
+    for ( std::deque<Record>::const_iterator it = index_.begin(); it != index_.end(); ++it )
+    {
+      const Channel& channel = channels_[it->channel];
+      records.push_back( DumpRecord() );
+      records.back().topic = channel.topic;
+      const boost::shared_array<uint8_t> bytes( storage_, storage_.get() + it->offset + sizeof(BlackBox::RecordHeader) );
+      records.back().message = tools::SerializedMessage( channel.type, bytes, it->size );
+      records.back().stamp = it->stamp;
+    }
+    return;
+  }
+
+  // copy the messages of the ring one after the other, the oldest first as they are overwritten first
+  size_t bytes = 0;
+  for ( std::deque<Record>::const_iterator it = index_.begin(); it != index_.end(); ++it )
+  {
+    bytes += it->size;
+  }
+  const boost::shared_array<uint8_t> copy( bytes > 0 ? new uint8_t[bytes] : NULL );
+  size_t offset = 0;
+  for ( std::deque<Record>::const_iterator it = index_.begin(); it != index_.end(); ++it )
+  {
+    std::memcpy( copy.get() + offset, ring_ + it->offset + sizeof(BlackBox::RecordHeader), it->size );
+    offset += it->size;
+  }
+
+  // a record is intact if the buffer did not come back over it before the copy was done:
+  // the frontier is still in its lap, or in the next one before its offset
+  boost::atomic_thread_fence( boost::memory_order_acquire );
+  const boost::uint64_t frontier = frontier_->load( boost::memory_order_relaxed );
+  size_t overwritten = 0;
+  offset = 0;
+  for ( std::deque<Record>::const_iterator it = index_.begin(); it != index_.end(); ++it )
+  {
+    if ( frontier - it->position > lap_span )
+    {
+      ++overwritten;
+    }
+    else
+    {
+      const Channel& channel = channels_[it->channel];
+      records.push_back( DumpRecord() );
+      records.back().topic = channel.topic;
+      const boost::shared_array<uint8_t> message( copy, copy.get() + offset );
+      records.back().message = tools::SerializedMessage( channel.type, message, it->size );
+      records.back().stamp = it->stamp;
+    }
+    offset += it->size;
+  }
+  if ( overwritten > 0 )
+  {
+    qiLogWarning() << overwritten << " records were overwritten before the minidump could copy them";
+  }
+}
+
+} // recorder
+} // naoqi
@@ -0,0 +1,246 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SERIALIZED_BUFFER_HPP
+#define SERIALIZED_BUFFER_HPP
+
+/*
+* LOCAL includes
+*/
+#include <naoqi_driver/recorder/globalrecorder.hpp>
+#include "../tools/serialized_message.hpp"
+#include "blackbox.hpp"
+#include "dump.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <deque>
+#include <string>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_array.hpp>
+#include <boost/shared_ptr.hpp>
+
+/*
+* ROS includes
+*/
+#include <ros/ros.h>
+
+namespace naoqi
+{
+namespace recorder
+{
+
+/**
+* @brief Ring of serialized messages stored in one contiguous block of bytes
+* @note messages are serialized once when they are buffered and copied as is in the ROSbag from a snapshot.
+* A message is never split: when it does not fit at the end of the block it goes to the beginning.
+* The oldest messages are overwritten first, the records are indexed by time in push order,
+* so that the records older than a given time are found by a binary search.
+* The capacity is taken from the buffer budget of the GlobalRecorder,
+* and the bytes from its BlackBox when it has one, so that they survive a crash.
+* Each record is preceded by a BlackBox::RecordHeader.
+* @note not thread safe, the recorders lock around it. Only the snapshots are read from another thread.
+*/
+class SerializedBuffer : private boost::noncopyable
+{
+
+  struct Record
+  {
+    size_t offset;
+    uint32_t size;
+    size_t channel;
+    ros::Time stamp;
+    /** stamp made monotonic, a record stamped before the previous one gets the stamp of the previous one */
+    ros::Time key;
+    /** bytes pushed in the buffer up to the end of this record */
+    boost::uint64_t end;
+    /** lap of the ring and offset of the record, to tell whether it was overwritten since */
+    boost::uint64_t position;
+  };
+
+public:
+  typedef BlackBox::Channel Channel;
+
+  /**
+  * @brief Records taken out of a buffer by snapshot(), to be written in the ROSbag while the buffer keeps filling up
+  */
+  class Snapshot : private boost::noncopyable
+  {
+  public:
+    Snapshot():
+      ring_( NULL )
+    {}
+
+    /**
+    * @brief Append the records to a minidump, without deserializing them
+    * @note the records of a black box are copied here, out of the lock of the recorder,
+    * the ones overwritten by the buffer meanwhile are left out
+    */
+    void collect( std::vector<DumpRecord>& records ) const;
+
+    /** Number of records */
+    inline size_t size() const
+    {
+      return index_.size();
+    }
+
+  private:
+    friend class SerializedBuffer;
+
+    /** the records given by collect() point into it, it is freed once the last of them is written */
+    boost::shared_array<uint8_t> storage_;
+    /** ring of the black box the records are still in, when storage_ is not handed over */
+    const uint8_t* ring_;
+    /** keeps the ring mapped */
+    boost::shared_ptr<BlackBox> blackbox_;
+    boost::shared_ptr<const boost::atomic<boost::uint64_t> > frontier_;
+    std::vector<Channel> channels_;
+    std::deque<Record> index_;
+  };
+
+  SerializedBuffer();
+
+  ~SerializedBuffer();
+
+  /**
+  * @brief Take the capacity granted to a topic by the buffer budget of gr, giving back the previous one
+  * @note drops everything buffered so far, must be called after the channels are added
+  */
+  void reset( const boost::shared_ptr<GlobalRecorder>& gr, const std::string& topic );
+
+  /**
+  * @brief Declare a topic stored in this buffer
+  * @return the channel to give to push
+  */
+  template <class T>
+  size_t addChannel( const std::string& topic )
+  {
+    return addChannel( topic, tools::messageTypeOf<T>() );
+  }
+
+  /** Declare a topic whose type is only known at runtime, e.g. read from a ROSbag */
+  size_t addChannel( const std::string& topic, const boost::shared_ptr<const tools::MessageType>& type )
+  {
+    Channel channel;
+    channel.topic = topic;
+    channel.type = type;
+    channels_.push_back( channel );
+    return channels_.size()-1;
+  }
+
+  /**
+  * @brief Serialize a message at the head of the ring
+  * @return false if the message is bigger than the whole buffer
+  */
+  template <class T>
+  bool push( size_t channel, const T& msg, const ros::Time& stamp )
+  {
+    const uint32_t size = ros::serialization::serializationLength( msg );
+    uint8_t* data = allocate( channel, size, stamp );
+    if ( data == NULL )
+    {
+      return false;
+    }
+    ros::serialization::OStream stream( data, size );
+    ros::serialization::serialize( stream, msg );
+    commit();
+    return true;
+  }
+
+  /**
+  * @brief Drop the records stamped before time
+  * @note the first record to keep is found by a binary search, the ones before are dropped at once
+  */
+  void removeOlderThan( const ros::Time& time );
+
+  void clear();
+
+  /**
+  * @brief Take all the records out of the buffer, which starts again empty
+  * @note the storage is handed over to the snapshot and replaced by untouched memory, in constant time.
+  * A buffer living in the black box cannot give its slice away: the snapshot only takes the index,
+  * and collect() copies the records which were not overwritten yet.
+  */
+  boost::shared_ptr<const Snapshot> snapshot();
+
+  /** Number of bytes of the block */
+  inline size_t capacity() const
+  {
+    return capacity_;
+  }
+
+  /** Number of bytes used by the records */
+  inline size_t bytes() const
+  {
+    return index_.empty() ? 0 : index_.back().end - index_.front().end + footprint( index_.front() );
+  }
+
+  /** Number of records */
+  inline size_t size() const
+  {
+    return index_.size();
+  }
+
+private:
+  /** Room for a new record, evicting the records it overlaps */
+  uint8_t* allocate( size_t channel, uint32_t size, const ros::Time& stamp );
+
+  /** Mark the newest record as complete, only then a recovery can see it */
+  void commit();
+
+  /** Move the tail of the black box slice to the head, once no record is left in the index */
+  void emptySlice();
+
+  /** Bytes taken in the ring by a record and its header */
+  static inline size_t footprint( const Record& record )
+  {
+    return sizeof(BlackBox::RecordHeader) + record.size;
+  }
+
+  boost::shared_ptr<GlobalRecorder> gr_;
+  /** storage when there is no black box, handed over to the snapshots */
+  boost::shared_array<uint8_t> heap_;
+  uint8_t* storage_;
+  /** slice of the black box holding the storage, if any */
+  BlackBox::SliceHeader* slice_;
+  boost::uint64_t seq_;
+  size_t capacity_;
+  /** offset of the end of the newest record */
+  size_t head_;
+  /** laps of the ring, a new one starts when the records go back to the beginning of the block */
+  boost::uint64_t lap_;
+  /** lap and offset of the end of the record being written, published before it is written */
+  boost::shared_ptr<boost::atomic<boost::uint64_t> > frontier_;
+  /** bytes pushed since the buffer was reset, the records keep the running total to compute bytes() */
+  boost::uint64_t pushed_;
+
+  std::vector<Channel> channels_;
+  std::deque<Record> index_;
+
+}; // class
+
+} // recorder
+} // naoqi
+
+#endif
@@ -30,7 +30,12 @@ SonarRecorder::SonarRecorder(const std::vector<std::string>& topics, float buffe
   buffer_duration_(helpers::recorder::bufferDefaultDuration),
   buffer_frequency_(buffer_frequency),
   counter_(1)
-{}
+{
+  for (size_t i=0; i<topics_.size(); ++i)
+  {
+    channels_.push_back(buffer_.addChannel<sensor_msgs::Range>(topics_[i]));
+  }
+}
 
 void SonarRecorder::write(const std::vector<sensor_msgs::Range>& sonar_msgs)
 {
@@ -40,6 +45,12 @@ void SonarRecorder::write(const std::vector<sensor_msgs::Range>& sonar_msgs)
     return;
   }
 
+  // all the sonars of a reading are recorded together
+  if ( sonar_msgs.empty() || !filter_.accept(sonar_msgs[0].header.stamp) )
+  {
+    return;
+  }
+
   for( size_t i=0; i<sonar_msgs.size(); ++i)
   {
     if (!sonar_msgs[i].header.stamp.isZero()) {
@@ -51,14 +62,10 @@ void SonarRecorder::write(const std::vector<sensor_msgs::Range>& sonar_msgs)
   }
 }
 
-void SonarRecorder::writeDump(const ros::Time& time)
+DumpSnapshot SonarRecorder::snapshot(const ros::Time& time)
 {
   boost::mutex::scoped_lock lock_write_buffer( mutex_ );
-  boost::circular_buffer< std::vector<sensor_msgs::Range> >::iterator it;
-  for (it = buffer_.begin(); it != buffer_.end(); it++)
-  {
-    write(*it);
-  }
+  return boost::bind( &SerializedBuffer::Snapshot::collect, buffer_.snapshot(), _1 );
 }
 
 void SonarRecorder::reset(boost::shared_ptr<GlobalRecorder> gr, float conv_frequency)
@@ -68,14 +75,13 @@ void SonarRecorder::reset(boost::shared_ptr<GlobalRecorder> gr, float conv_frequ
   if (buffer_frequency_ != 0)
   {
     max_counter_ = static_cast<int>(conv_frequency/buffer_frequency_);
-    buffer_size_ = static_cast<size_t>(buffer_duration_*(conv_frequency/max_counter_));
   }
   else
   {
     max_counter_ = 1;
-    buffer_size_ = static_cast<size_t>(buffer_duration_*conv_frequency);
   }
-  buffer_.resize(buffer_size_);
+  boost::mutex::scoped_lock lock_bufferize( mutex_ );
+  buffer_.reset(gr, topic());
   is_initialized_ = true;
 }
 
@@ -89,16 +95,32 @@ void SonarRecorder::bufferize(const std::vector<sensor_msgs::Range>& sonar_msgs
   else
   {
     counter_ = 1;
-    buffer_.push_back(sonar_msgs);
+    if ( channels_.size() != sonar_msgs.size() )
+    {
+      std::cerr << "Incorrect number of sonar range messages in sonar recorder. " << sonar_msgs.size() << "/" << channels_.size() << std::endl;
+      return;
+    }
+    ros::Time stamp = ros::Time::now();
+    for( size_t i=0; i<sonar_msgs.size(); ++i)
+    {
+      if (!sonar_msgs[i].header.stamp.isZero()) {
+        stamp = sonar_msgs[i].header.stamp;
+      }
+      buffer_.push(channels_[i], sonar_msgs[i], stamp);
+    }
+    buffer_.removeOlderThan(stamp - ros::Duration(buffer_duration_));
   }
 }
 
 void SonarRecorder::setBufferDuration(float duration)
 {
   boost::mutex::scoped_lock lock_bufferize( mutex_ );
-  buffer_size_ = static_cast<size_t>(duration*(conv_frequency_/max_counter_));
   buffer_duration_ = duration;
-  buffer_.set_capacity(buffer_size_);
+}
+
+void SonarRecorder::setProfile(const RecordProfile& profile)
+{
+  filter_.setProfile(profile);
 }
 
 } //publisher
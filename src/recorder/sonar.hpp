@@ -18,16 +18,13 @@
 #ifndef SONAR_RECORDER_HPP
 #define SONAR_RECORDER_HPP
 
-/*
-* BOOST includes
-*/
-#include <boost/circular_buffer.hpp>
-
 /*
 * LOCAL includes
 */
 #include <naoqi_driver/recorder/globalrecorder.hpp>
+#include <naoqi_driver/recorder/record_profile.hpp>
 #include "../helpers/recorder_helpers.hpp"
+#include "serialized_buffer.hpp"
 
 /*
 * ROS includes
@@ -51,10 +48,12 @@ public:
 
   void bufferize(const std::vector<sensor_msgs::Range>& sonar_msgs );
 
-  void writeDump(const ros::Time& time);
+  DumpSnapshot snapshot(const ros::Time& time);
 
   void setBufferDuration(float duration);
 
+  void setProfile(const RecordProfile& profile);
+
   inline std::string topic() const
   {
     return "sonar";
@@ -78,8 +77,9 @@ public:
 protected:
   std::string topic_;
 
-  boost::circular_buffer< std::vector<sensor_msgs::Range> > buffer_;
-  size_t buffer_size_;
+  /** serialized ranges of the last buffer_duration_ seconds, one channel per topic */
+  SerializedBuffer buffer_;
+  std::vector<size_t> channels_;
   float buffer_duration_;
 
   boost::mutex mutex_;
@@ -88,6 +88,7 @@ protected:
   bool is_subscribed_;
 
   boost::shared_ptr<naoqi::recorder::GlobalRecorder> gr_;
+  RecordFilter filter_;
   std::vector<std::string> topics_;
 
   float buffer_frequency_;
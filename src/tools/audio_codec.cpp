@@ -0,0 +1,334 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+/*
+* LOCAL includes
+*/
+#include "audio_codec.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <algorithm>
+#include <cstdlib>
+
+namespace naoqi
+{
+namespace tools
+{
+
+namespace
+{
+
+const int max_order = 4;
+const int order_bits = 3;
+const size_t partition_size = 256;
+const int parameter_bits = 5;
+const int max_parameter = 31;
+/** a quotient this long is escaped: the residual is written on 32 bits instead */
+const boost::uint32_t escape_quotient = 24;
+
+inline boost::uint64_t mask( int count )
+{
+  return ( static_cast<boost::uint64_t>(1) << count ) - 1;
+}
+
+inline boost::uint32_t zigzag( boost::int32_t value )
+{
+  return ( static_cast<boost::uint32_t>(value) << 1 ) ^ static_cast<boost::uint32_t>( value >> 31 );
+}
+
+inline boost::int32_t unzigzag( boost::uint32_t value )
+{
+  return static_cast<boost::int32_t>( value >> 1 ) ^ -static_cast<boost::int32_t>( value & 1 );
+}
+
+/** Prediction of x[i] from the previous samples, by the fixed predictors of FLAC */
+inline boost::int32_t predict( const boost::int32_t* x, int order )
+{
+  switch ( order )
+  {
+  case 1: return x[-1];
+  case 2: return 2*x[-1] - x[-2];
+  case 3: return 3*x[-1] - 3*x[-2] + x[-3];
+  case 4: return 4*x[-1] - 6*x[-2] + 4*x[-3] - x[-4];
+  default: return 0;
+  }
+}
+
+class BitWriter
+{
+public:
+  BitWriter( std::vector<boost::uint8_t>& out ):
+    out_( out ),
+    acc_( 0 ),
+    bits_( 0 )
+  {}
+
+  /** Write the count lowest bits of value, count up to 32 */
+  inline void write( boost::uint32_t value, int count )
+  {
+    acc_ = ( acc_ << count ) | ( value & mask(count) );
+    bits_ += count;
+    while ( bits_ >= 8 )
+    {
+      bits_ -= 8;
+      out_.push_back( static_cast<boost::uint8_t>( acc_ >> bits_ ) );
+    }
+  }
+
+  inline void writeRice( boost::uint32_t value, int parameter )
+  {
+    const boost::uint32_t quotient = value >> parameter;
+    if ( quotient < escape_quotient )
+    {
+      // quotient ones then a zero
+      write( static_cast<boost::uint32_t>( mask(quotient) << 1 ), quotient + 1 );
+      write( value, parameter );
+    }
+    else
+    {
+      write( static_cast<boost::uint32_t>( mask(escape_quotient) ), escape_quotient );
+      write( value, 32 );
+    }
+  }
+
+  void flush()
+  {
+    if ( bits_ > 0 )
+    {
+      out_.push_back( static_cast<boost::uint8_t>( acc_ << (8 - bits_) ) );
+    }
+    acc_ = 0;
+    bits_ = 0;
+  }
+
+private:
+  std::vector<boost::uint8_t>& out_;
+  boost::uint64_t acc_;
+  int bits_;
+};
+
+class BitReader
+{
+public:
+  BitReader( const boost::uint8_t* data, size_t size ):
+    data_( data ),
+    end_( data + size ),
+    acc_( 0 ),
+    bits_( 0 ),
+    error_( false )
+  {}
+
+  inline boost::uint32_t read( int count )
+  {
+    while ( bits_ < count )
+    {
+      if ( data_ == end_ )
+      {
+        error_ = true;
+        return 0;
+      }
+      acc_ = ( acc_ << 8 ) | *data_++;
+      bits_ += 8;
+    }
+    bits_ -= count;
+    return static_cast<boost::uint32_t>( ( acc_ >> bits_ ) & mask(count) );
+  }
+
+  inline boost::uint32_t readRice( int parameter )
+  {
+    boost::uint32_t quotient = 0;
+    while ( quotient < escape_quotient && read(1) == 1 && !error_ )
+    {
+      ++quotient;
+    }
+    if ( quotient == escape_quotient )
+    {
+      return read( 32 );
+    }
+    return ( quotient << parameter ) | read( parameter );
+  }
+
+  inline bool error() const
+  {
+    return error_;
+  }
+
+private:
+  const boost::uint8_t* data_;
+  const boost::uint8_t* end_;
+  boost::uint64_t acc_;
+  int bits_;
+  bool error_;
+};
+
+/** Rice parameter close to the best one for values whose sum is given */
+inline int riceParameter( boost::uint64_t sum, size_t count )
+{
+  int parameter = 0;
+  while ( parameter < max_parameter && ( static_cast<boost::uint64_t>(count) << (parameter + 1) ) <= sum )
+  {
+    ++parameter;
+  }
+  return parameter;
+}
+
+} // anonymous
+
+void encodeAudio( const int16_t* samples, size_t samples_per_channel, size_t channels, std::vector<boost::uint8_t>& out,
+                  AudioCodecScratch& scratch )
+{
+  // one channel at a time, with max_order zeros in front so that every predictor can look back;
+  // the vectors keep their capacity from frame to frame
+  std::vector<boost::int32_t>& channel = scratch.channel;
+  std::vector<boost::uint32_t>& residuals = scratch.residuals;
+  channel.resize( max_order + samples_per_channel );
+  std::fill( channel.begin(), channel.begin() + max_order, 0 );
+  residuals.resize( samples_per_channel );
+  BitWriter writer( out );
+  for ( size_t c=0; c<channels; ++c )
+  {
+    boost::int32_t* x = &channel[max_order];
+    for ( size_t i=0; i<samples_per_channel; ++i )
+    {
+      x[i] = samples[i*channels + c];
+    }
+
+    // the predictor with the smallest residuals, the first samples are given as is
+    int order = 0;
+    boost::uint64_t best = 0;
+    for ( int o=0; o<=max_order; ++o )
+    {
+      boost::uint64_t sum = 0;
+      for ( size_t i=max_order; i<samples_per_channel; ++i )
+      {
+        sum += std::abs( x[i] - predict( x + i, o ) );
+      }
+      if ( o == 0 || sum < best )
+      {
+        order = o;
+        best = sum;
+      }
+    }
+    const size_t warmup = std::min<size_t>( order, samples_per_channel );
+    writer.write( order, order_bits );
+    for ( size_t i=0; i<warmup; ++i )
+    {
+      writer.write( static_cast<boost::uint16_t>( x[i] ), 16 );
+    }
+
+    const size_t count = samples_per_channel - warmup;
+    for ( size_t i=0; i<count; ++i )
+    {
+      const size_t j = i + warmup;
+      residuals[i] = zigzag( x[j] - predict( x + j, order ) );
+    }
+    for ( size_t begin=0; begin<count; begin+=partition_size )
+    {
+      const size_t end = std::min( count, begin + partition_size );
+      boost::uint64_t sum = 0;
+      for ( size_t i=begin; i<end; ++i )
+      {
+        sum += residuals[i];
+      }
+      const int parameter = riceParameter( sum, end - begin );
+      writer.write( parameter, parameter_bits );
+      for ( size_t i=begin; i<end; ++i )
+      {
+        writer.writeRice( residuals[i], parameter );
+      }
+    }
+  }
+  writer.flush();
+}
+
+bool decodeAudio( const boost::uint8_t* data, size_t size, size_t samples_per_channel, size_t channels, std::vector<int16_t>& out )
+{
+  std::vector<boost::int32_t> channel( max_order + samples_per_channel, 0 );
+  const size_t first = out.size();
+  out.resize( first + samples_per_channel * channels );
+  BitReader reader( data, size );
+  for ( size_t c=0; c<channels; ++c )
+  {
+    boost::int32_t* x = &channel[max_order];
+    const int order = reader.read( order_bits );
+    if ( order > max_order )
+    {
+      return false;
+    }
+    const size_t warmup = std::min<size_t>( order, samples_per_channel );
+    for ( size_t i=0; i<warmup; ++i )
+    {
+      x[i] = static_cast<int16_t>( reader.read( 16 ) );
+    }
+    for ( size_t begin=warmup; begin<samples_per_channel; begin+=partition_size )
+    {
+      const size_t end = std::min( samples_per_channel, begin + partition_size );
+      const int parameter = reader.read( parameter_bits );
+      for ( size_t i=begin; i<end; ++i )
+      {
+        x[i] = predict( x + i, order ) + unzigzag( reader.readRice( parameter ) );
+      }
+    }
+    if ( reader.error() )
+    {
+      return false;
+    }
+    for ( size_t i=0; i<samples_per_channel; ++i )
+    {
+      out[first + i*channels + c] = static_cast<int16_t>( x[i] );
+    }
+  }
+  return true;
+}
+
+void compressAudio( const naoqi_bridge_msgs::AudioBuffer& msg, CompressedAudioBuffer& compressed, AudioCodecScratch& scratch )
+{
+  const size_t channels = msg.channelMap.empty() ? 1 : msg.channelMap.size();
+  compressed.header = msg.header;
+  compressed.frequency = msg.frequency;
+  compressed.channelMap = msg.channelMap;
+  compressed.samples = msg.data.size() / channels;
+  compressed.data.clear();
+  if ( compressed.samples > 0 )
+  {
+    encodeAudio( &msg.data[0], compressed.samples, channels, compressed.data, scratch );
+  }
+}
+
+bool decompressAudio( const CompressedAudioBuffer& compressed, naoqi_bridge_msgs::AudioBuffer& msg )
+{
+  const size_t channels = compressed.channelMap.empty() ? 1 : compressed.channelMap.size();
+  msg.header = compressed.header;
+  msg.frequency = compressed.frequency;
+  msg.channelMap = compressed.channelMap;
+  msg.data.clear();
+  if ( compressed.samples == 0 )
+  {
+    return true;
+  }
+  if ( compressed.data.empty() )
+  {
+    return false;
+  }
+  return decodeAudio( &compressed.data[0], compressed.data.size(), compressed.samples, channels, msg.data );
+}
+
+} // tools
+} // naoqi
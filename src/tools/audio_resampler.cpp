@@ -0,0 +1,136 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+/*
+* LOCAL includes
+*/
+#include "audio_resampler.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace naoqi
+{
+namespace tools
+{
+
+namespace
+{
+
+/** Taps per output phase, the filter has taps_per_phase * factor + 1 taps */
+const int taps_per_phase = 16;
+
+/** Pass band kept, as a fraction of the output Nyquist frequency */
+const double pass_band = 0.9;
+
+/** Blackman windowed sinc, quantized in Q15 with a gain of exactly 1 */
+std::vector<int16_t> lowPass( int factor )
+{
+  const int size = taps_per_phase * factor + 1;
+  const int center = size / 2;
+  const double cutoff = pass_band * 0.5 / factor;
+  std::vector<double> taps( size );
+  double sum = 0.;
+  for ( int i=0; i<size; ++i )
+  {
+    const double x = i - center;
+    const double sinc = x == 0 ? 2. * cutoff : std::sin( 2. * M_PI * cutoff * x ) / ( M_PI * x );
+    const double window = 0.42 - 0.5 * std::cos( 2. * M_PI * i / ( size - 1 ) ) + 0.08 * std::cos( 4. * M_PI * i / ( size - 1 ) );
+    taps[i] = sinc * window;
+    sum += taps[i];
+  }
+
+  std::vector<int16_t> quantized( size );
+  int total = 0;
+  for ( int i=0; i<size; ++i )
+  {
+    quantized[i] = static_cast<int16_t>( std::floor( taps[i] / sum * 32768. + 0.5 ) );
+    total += quantized[i];
+  }
+  // the rounding error goes to the center tap, so that a constant signal keeps its level
+  quantized[center] += 32768 - total;
+  return quantized;
+}
+
+} // anonymous
+
+AudioResampler::AudioResampler( int input_rate, int output_rate ):
+  factor_( output_rate > 0 ? input_rate / output_rate : 0 ),
+  next_( 0 )
+{
+  if ( factor_ < 1 || factor_ * output_rate != input_rate )
+  {
+    std::ostringstream error;
+    error << "Cannot resample " << input_rate << " Hz audio to " << output_rate << " Hz, only integer decimations are supported";
+    throw std::invalid_argument( error.str() );
+  }
+  if ( factor_ > 1 )
+  {
+    taps_ = lowPass( factor_ );
+  }
+  reset();
+}
+
+void AudioResampler::reset()
+{
+  window_.assign( taps_.empty() ? 0 : taps_.size() - 1, 0 );
+  next_ = 0;
+}
+
+void AudioResampler::process( const int16_t* input, size_t size, std::vector<int16_t>& output )
+{
+  if ( factor_ == 1 )
+  {
+    output.insert( output.end(), input, input + size );
+    return;
+  }
+
+  const size_t taps = taps_.size();
+  const size_t history = taps - 1;
+  window_.resize( history + size );
+  std::copy( input, input + size, window_.begin() + history );
+
+  output.reserve( output.size() + ( window_.size() - next_ ) / factor_ + 1 );
+  const int16_t* coefficients = &taps_[0];
+  size_t first = next_;
+  for ( ; first + taps <= window_.size(); first += factor_ )
+  {
+    const int16_t* samples = &window_[first];
+    boost::int32_t sum = 0;
+    for ( size_t k=0; k<taps; ++k )
+    {
+      sum += static_cast<boost::int32_t>( coefficients[k] ) * samples[k];
+    }
+    // round the Q15 sum and saturate, the ripple of the filter can overshoot a full scale input
+    sum = ( sum + ( 1 << 14 ) ) >> 15;
+    output.push_back( static_cast<int16_t>( std::min<boost::int32_t>( 32767, std::max<boost::int32_t>( -32768, sum ) ) ) );
+  }
+
+  // the window slides by the size of the block, its last inputs become the history of the next one
+  next_ = first - size;
+  std::copy( window_.end() - history, window_.end(), window_.begin() );
+  window_.resize( history );
+}
+
+} // tools
+} // naoqi
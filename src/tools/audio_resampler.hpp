@@ -0,0 +1,76 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef AUDIO_RESAMPLER_HPP
+#define AUDIO_RESAMPLER_HPP
+
+/*
+* STANDARD includes
+*/
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/cstdint.hpp>
+
+namespace naoqi
+{
+namespace tools
+{
+
+/**
+* @brief Downsampler of 16 bits audio by an integer factor, through a polyphase low-pass FIR filter
+* @note for a decimation by M, only the output phase of the filter is computed: each output sample is the dot product
+* of the taps with the inputs that end on it, the M-1 inputs in between are never output.
+* The taps are Q15 and summed in 32 bits, so the inner loop is a plain integer dot product the compiler vectorizes.
+* The last inputs of a block are kept, so that consecutive blocks are filtered as one stream.
+*/
+class AudioResampler
+{
+public:
+  /**
+  * @throw std::invalid_argument if output_rate does not divide input_rate
+  */
+  AudioResampler( int input_rate, int output_rate );
+
+  inline int factor() const
+  {
+    return factor_;
+  }
+
+  /** Filter and decimate the samples of one channel, appending the outputs */
+  void process( const int16_t* input, size_t size, std::vector<int16_t>& output );
+
+  /** Forget the inputs of the previous blocks */
+  void reset();
+
+private:
+  int factor_;
+  /** symmetric, so the same whichever way the inputs go */
+  std::vector<int16_t> taps_;
+  /** the last taps-1 inputs followed by the current block */
+  std::vector<int16_t> window_;
+  /** position in the window of the first input of the next output */
+  size_t next_;
+};
+
+} // tools
+} // naoqi
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef COMPRESSED_AUDIO_BUFFER_HPP
+#define COMPRESSED_AUDIO_BUFFER_HPP
+
+/*
+* STANDARD includes
+*/
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/cstdint.hpp>
+
+/*
+* ROS includes
+*/
+#include <ros/message_traits.h>
+#include <ros/serialization.h>
+#include <std_msgs/Header.h>
+
+namespace naoqi
+{
+namespace tools
+{
+
+/**
+* @brief naoqi_bridge_msgs/AudioBuffer compressed without loss by tools::compressAudio
+* @note the message is declared here rather than generated, so that no message package is needed:
+* its definition goes in the ROSbag and lets any tool read it back.
+*/
+struct CompressedAudioBuffer
+{
+  CompressedAudioBuffer():
+    frequency( 0 ),
+    samples( 0 )
+  {}
+
+  std_msgs::Header header;
+  boost::uint16_t frequency;
+  std::vector<boost::uint8_t> channelMap;
+  /** samples per channel */
+  boost::uint32_t samples;
+  /** stream of tools::compressAudio */
+  std::vector<boost::uint8_t> data;
+};
+
+} // tools
+} // naoqi
+
+namespace ros
+{
+namespace message_traits
+{
+
+template <> struct IsMessage<naoqi::tools::CompressedAudioBuffer> : TrueType {};
+template <> struct IsMessage<const naoqi::tools::CompressedAudioBuffer> : TrueType {};
+template <> struct HasHeader<naoqi::tools::CompressedAudioBuffer> : TrueType {};
+template <> struct HasHeader<const naoqi::tools::CompressedAudioBuffer> : TrueType {};
+
+template <>
+struct MD5Sum<naoqi::tools::CompressedAudioBuffer>
+{
+  static const char* value() { return "fd7c89cff188fd16e7e66f94b6b527f3"; }
+  static const char* value( const naoqi::tools::CompressedAudioBuffer& ) { return value(); }
+};
+
+template <>
+struct DataType<naoqi::tools::CompressedAudioBuffer>
+{
+  static const char* value() { return "naoqi_driver/CompressedAudioBuffer"; }
+  static const char* value( const naoqi::tools::CompressedAudioBuffer& ) { return value(); }
+};
+
+template <>
+struct Definition<naoqi::tools::CompressedAudioBuffer>
+{
+  static const char* value()
+  {
+    return "Header header\n"
+           "uint16 frequency\n"
+           "uint8[] channelMap\n"
+           "uint32 samples\n"
+           "uint8[] data\n"
+           "\n"
+           "================================================================================\n"
+           "MSG: std_msgs/Header\n"
+           "uint32 seq\n"
+           "time stamp\n"
+           "string frame_id\n";
+  }
+  static const char* value( const naoqi::tools::CompressedAudioBuffer& ) { return value(); }
+};
+
+} // message_traits
+
+namespace serialization
+{
+
+template <>
+struct Serializer<naoqi::tools::CompressedAudioBuffer>
+{
+  template <typename Stream, typename T>
+  inline static void allInOne( Stream& stream, T m )
+  {
+    stream.next( m.header );
+    stream.next( m.frequency );
+    stream.next( m.channelMap );
+    stream.next( m.samples );
+    stream.next( m.data );
+  }
+
+  ROS_DECLARE_ALLINONE_SERIALIZER
+};
+
+} // serialization
+} // ros
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+/*
+* LOCAL includes
+*/
+#include "converter_statistics.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <iomanip>
+#include <sstream>
+
+/*
+* SYSTEM includes
+*/
+#include <time.h>
+
+namespace naoqi
+{
+namespace tools
+{
+
+namespace
+{
+
+ThreadUsage::AllocationCounter allocation_counter = NULL;
+
+boost::uint64_t clockMicroseconds( clockid_t clock )
+{
+  struct timespec ts;
+  ::clock_gettime( clock, &ts );
+  return static_cast<boost::uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+} // anonymous
+
+ThreadUsage::ThreadUsage():
+  wall_us(0),
+  cpu_us(0),
+  allocations(0)
+{}
+
+ThreadUsage ThreadUsage::now()
+{
+  ThreadUsage usage;
+  usage.wall_us = clockMicroseconds( CLOCK_MONOTONIC );
+  usage.cpu_us = clockMicroseconds( CLOCK_THREAD_CPUTIME_ID );
+  usage.allocations = allocation_counter ? allocation_counter() : 0;
+  return usage;
+}
+
+void ThreadUsage::setAllocationCounter( AllocationCounter counter )
+{
+  allocation_counter = counter;
+}
+
+ThreadUsage& ThreadUsage::operator+=( const ThreadUsage& other )
+{
+  wall_us += other.wall_us;
+  cpu_us += other.cpu_us;
+  allocations += other.allocations;
+  return *this;
+}
+
+ThreadUsage ThreadUsage::operator-( const ThreadUsage& other ) const
+{
+  ThreadUsage usage;
+  usage.wall_us = wall_us - other.wall_us;
+  usage.cpu_us = cpu_us - other.cpu_us;
+  usage.allocations = allocations - other.allocations;
+  return usage;
+}
+
+ConverterTickStatistics::ConverterTickStatistics():
+  cpu_us(0),
+  allocations(0),
+  first_us(0),
+  last_us(0)
+{}
+
+double ConverterTickStatistics::rate() const
+{
+  if ( latency.calls < 2 || last_us == first_us )
+  {
+    return 0.0;
+  }
+  return (latency.calls - 1) * 1e6 / (last_us - first_us);
+}
+
+ConverterStatistics& ConverterStatistics::instance()
+{
+  static ConverterStatistics stats;
+  return stats;
+}
+
+void ConverterStatistics::record( const std::string& converter, const ThreadUsage& start, const ThreadUsage& cost, const ThreadUsage& end )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  ConverterTickStatistics& stats = stats_[converter];
+  if ( stats.latency.calls == 0 )
+  {
+    stats.first_us = end.wall_us;
+  }
+  stats.last_us = end.wall_us;
+  stats.latency.add( end.wall_us - start.wall_us, 0, false );
+  stats.cpu_us += cost.cpu_us;
+  stats.allocations += cost.allocations;
+}
+
+ConverterStatistics::Map ConverterStatistics::snapshot() const
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  return stats_;
+}
+
+std::vector<std::string> ConverterStatistics::summary() const
+{
+  const Map stats = snapshot();
+  std::vector<std::string> lines;
+  for ( Map::const_iterator it = stats.begin(); it != stats.end(); ++it )
+  {
+    const ConverterTickStatistics& s = it->second;
+    const double ticks = s.latency.calls;
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(2)
+         << it->first
+         << " ticks=" << s.latency.calls
+         << " rate=" << s.rate() << "Hz"
+         << " p50=" << s.latency.percentile(0.5) / 1000. << "ms"
+         << " p90=" << s.latency.percentile(0.9) / 1000. << "ms"
+         << " p99=" << s.latency.percentile(0.99) / 1000. << "ms"
+         << " cpu=" << s.cpu_us / ticks / 1000. << "ms/tick"
+         << " allocations=" << s.allocations / ticks << "/tick";
+    lines.push_back( line.str() );
+  }
+  return lines;
+}
+
+void ConverterStatistics::reset()
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  stats_.clear();
+}
+
+} // tools
+} // naoqi
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef CONVERTER_STATISTICS_HPP
+#define CONVERTER_STATISTICS_HPP
+
+/*
+* LOCAL includes
+*/
+#include "rpc_statistics.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace naoqi
+{
+namespace tools
+{
+
+/**
+* @brief Resources used so far by the calling thread, sampled around the steps of a converter tick
+*/
+struct ThreadUsage
+{
+  /** Function counting the allocations of the calling thread, provided by whoever replaces operator new */
+  typedef boost::uint64_t (*AllocationCounter)();
+
+  ThreadUsage();
+
+  static ThreadUsage now();
+
+  /** Without a counter, the allocations are always 0 */
+  static void setAllocationCounter( AllocationCounter counter );
+
+  ThreadUsage& operator+=( const ThreadUsage& other );
+
+  ThreadUsage operator-( const ThreadUsage& other ) const;
+
+  /** monotonic clock */
+  boost::uint64_t wall_us;
+  /** CPU time of the thread */
+  boost::uint64_t cpu_us;
+  boost::uint64_t allocations;
+};
+
+/**
+* @brief Counters gathered for the ticks of one converter
+* @note the latency of a tick goes from its libqi request to the end of its callbacks,
+* the CPU time and the allocations are the ones of the driver thread only
+*/
+struct ConverterTickStatistics
+{
+  ConverterTickStatistics();
+
+  /** Ticks per second between the first and the last tick */
+  double rate() const;
+
+  /** latency histogram, one call per tick */
+  RpcMethodStatistics latency;
+  boost::uint64_t cpu_us;
+  boost::uint64_t allocations;
+  boost::uint64_t first_us;
+  boost::uint64_t last_us;
+};
+
+/**
+* @brief Process wide registry of the ticks of the converters
+* @note only fed when the driver is built with NAOQI_DRIVER_CONVERTER_STATS
+*/
+class ConverterStatistics
+{
+public:
+  typedef std::map<std::string, ConverterTickStatistics> Map;
+
+  static ConverterStatistics& instance();
+
+  /**
+  * @brief Account for one tick
+  * @param start usage when the request of the tick was issued
+  * @param cost usage of the driver thread for this tick alone
+  * @param end usage when the callbacks returned
+  */
+  void record( const std::string& converter, const ThreadUsage& start, const ThreadUsage& cost, const ThreadUsage& end );
+
+  /** Copy of all the counters, to be read without holding the lock */
+  Map snapshot() const;
+
+  /** One human readable line per converter */
+  std::vector<std::string> summary() const;
+
+  void reset();
+
+private:
+  ConverterStatistics() {}
+
+  mutable boost::mutex mutex_;
+  Map stats_;
+};
+
+} // tools
+} // naoqi
+
+#endif
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef INSTRUMENTED_OBJECT_HPP
+#define INSTRUMENTED_OBJECT_HPP
+
+/*
+* LOCAL includes
+*/
+#include "rpc_statistics.hpp"
+
+/*
+* ALDEBARAN includes
+*/
+#include <qi/anyobject.hpp>
+#include <qi/clock.hpp>
+
+/*
+* BOOST includes
+*/
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+
+namespace naoqi
+{
+namespace tools
+{
+
+/**
+* @brief Thin proxy around a qi::AnyObject which accounts every call in RpcStatistics
+* @note it offers the same call<R>(method, ...) syntax as qi::AnyObject,
+* so converters only have to change the type of their service handles.
+* Without NAOQI_DRIVER_RPC_STATS the calls are forwarded as is and nothing is measured.
+*/
+class InstrumentedObject
+{
+
+public:
+  InstrumentedObject() {}
+
+  InstrumentedObject( const qi::AnyObject& object, const std::string& service ):
+    object_( object ),
+    service_( service )
+  {}
+
+  inline const qi::AnyObject& object() const
+  {
+    return object_;
+  }
+
+  inline const std::string& service() const
+  {
+    return service_;
+  }
+
+  template <typename R>
+  R call( const std::string& method )
+  {
+#ifdef NAOQI_DRIVER_RPC_STATS
+    return finish<R>( method, qi::SteadyClock::now(), object_.async<R>(method) );
+#else
+    return object_.call<R>(method);
+#endif
+  }
+
+  template <typename R, typename P1>
+  R call( const std::string& method, const P1& p1 )
+  {
+#ifdef NAOQI_DRIVER_RPC_STATS
+    return finish<R>( method, qi::SteadyClock::now(), object_.async<R>(method, p1) );
+#else
+    return object_.call<R>(method, p1);
+#endif
+  }
+
+  template <typename R, typename P1, typename P2>
+  R call( const std::string& method, const P1& p1, const P2& p2 )
+  {
+#ifdef NAOQI_DRIVER_RPC_STATS
+    return finish<R>( method, qi::SteadyClock::now(), object_.async<R>(method, p1, p2) );
+#else
+    return object_.call<R>(method, p1, p2);
+#endif
+  }
+
+  template <typename R, typename P1, typename P2, typename P3>
+  R call( const std::string& method, const P1& p1, const P2& p2, const P3& p3 )
+  {
+#ifdef NAOQI_DRIVER_RPC_STATS
+    return finish<R>( method, qi::SteadyClock::now(), object_.async<R>(method, p1, p2, p3) );
+#else
+    return object_.call<R>(method, p1, p2, p3);
+#endif
+  }
+
+  template <typename R, typename P1, typename P2, typename P3, typename P4>
+  R call( const std::string& method, const P1& p1, const P2& p2, const P3& p3, const P4& p4 )
+  {
+#ifdef NAOQI_DRIVER_RPC_STATS
+    return finish<R>( method, qi::SteadyClock::now(), object_.async<R>(method, p1, p2, p3, p4) );
+#else
+    return object_.call<R>(method, p1, p2, p3, p4);
+#endif
+  }
+
+  template <typename R, typename P1, typename P2, typename P3, typename P4, typename P5>
+  R call( const std::string& method, const P1& p1, const P2& p2, const P3& p3, const P4& p4, const P5& p5 )
+  {
+#ifdef NAOQI_DRIVER_RPC_STATS
+    return finish<R>( method, qi::SteadyClock::now(), object_.async<R>(method, p1, p2, p3, p4, p5) );
+#else
+    return object_.call<R>(method, p1, p2, p3, p4, p5);
+#endif
+  }
+
+  /**
+  * @brief non blocking counterpart of call<R>, the latency is accounted when the answer arrives
+  */
+  template <typename R>
+  qi::Future<R> async( const std::string& method )
+  {
+#ifdef NAOQI_DRIVER_RPC_STATS
+    return track<R>( method, qi::SteadyClock::now(), object_.async<R>(method) );
+#else
+    return object_.async<R>(method);
+#endif
+  }
+
+  template <typename R, typename P1>
+  qi::Future<R> async( const std::string& method, const P1& p1 )
+  {
+#ifdef NAOQI_DRIVER_RPC_STATS
+    return track<R>( method, qi::SteadyClock::now(), object_.async<R>(method, p1) );
+#else
+    return object_.async<R>(method, p1);
+#endif
+  }
+
+  template <typename R, typename P1, typename P2>
+  qi::Future<R> async( const std::string& method, const P1& p1, const P2& p2 )
+  {
+#ifdef NAOQI_DRIVER_RPC_STATS
+    return track<R>( method, qi::SteadyClock::now(), object_.async<R>(method, p1, p2) );
+#else
+    return object_.async<R>(method, p1, p2);
+#endif
+  }
+
+private:
+#ifdef NAOQI_DRIVER_RPC_STATS
+  template <typename R>
+  static void account( const std::string& service, const std::string& method,
+                       const qi::SteadyClock::time_point& start, qi::Future<R> future )
+  {
+    const boost::uint64_t latency_us =
+        boost::chrono::duration_cast<qi::MicroSeconds>( qi::SteadyClock::now() - start ).count();
+    const bool error = future.hasError();
+    RpcStatistics::instance().record( service, method, latency_us,
+                                      error ? 0 : payloadSize( future.value() ), error );
+  }
+
+  template <typename R>
+  qi::Future<R> track( const std::string& method, const qi::SteadyClock::time_point& start, qi::Future<R> future )
+  {
+    // the service name and the method are copied: the callback may outlive this proxy
+    future.connect( boost::function<void (qi::Future<R>)>(
+                      boost::bind( &InstrumentedObject::account<R>, service_, method, start, _1 ) ) );
+    return future;
+  }
+
+  template <typename R>
+  R finish( const std::string& method, const qi::SteadyClock::time_point& start, qi::Future<R> future )
+  {
+    future.wait();
+    account<R>( service_, method, start, future );
+    // value() rethrows the remote error exactly like qi::AnyObject::call would
+    return static_cast<R>( future.value() );
+  }
+#endif
+
+  qi::AnyObject object_;
+  std::string service_;
+};
+
+} // tools
+} // naoqi
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/*
+* LOCAL includes
+*/
+#include "log_filter.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <algorithm>
+
+/*
+* SYSTEM includes
+*/
+#include <fnmatch.h>
+
+/*
+* BOOST includes
+*/
+#include <boost/functional/hash.hpp>
+
+namespace naoqi
+{
+namespace tools
+{
+
+namespace
+{
+
+/** microseconds standing for a bucket which is never refilled, about eleven days */
+const double never = 1e12;
+
+/** bound of the burst, in microseconds, far from the overflow */
+const double max_tolerance = 1e17;
+
+inline bool matches( const std::string& glob, const std::string& category )
+{
+  return ::fnmatch( glob.c_str(), category.c_str(), 0 ) == 0;
+}
+
+bool matchesAny( const std::vector<std::string>& globs, const std::string& category )
+{
+  for ( std::vector<std::string>::const_iterator it = globs.begin(); it != globs.end(); ++it )
+  {
+    if ( matches( *it, category ) )
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // anonymous
+
+LogFilter::LogFilter( const LogFilterConfig& config ):
+  config_( config )
+{
+  for ( size_t i=0; i<slot_count; ++i )
+  {
+    slots_[i].store( NULL, boost::memory_order_relaxed );
+  }
+}
+
+LogFilter::~LogFilter()
+{
+  for ( size_t i=0; i<slot_count; ++i )
+  {
+    Bucket* bucket = slots_[i].load( boost::memory_order_relaxed );
+    while ( bucket != NULL )
+    {
+      Bucket* next = bucket->next;
+      delete bucket;
+      bucket = next;
+    }
+  }
+}
+
+bool LogFilter::allowed( const std::string& category ) const
+{
+  if ( !config_.allow.empty() && !matchesAny( config_.allow, category ) )
+  {
+    return false;
+  }
+  return !matchesAny( config_.deny, category );
+}
+
+LogFilter::Bucket* LogFilter::bucket( const std::string& category )
+{
+  boost::atomic<Bucket*>& slot = slots_[boost::hash<std::string>()( category ) % slot_count];
+  for ( Bucket* bucket = slot.load( boost::memory_order_acquire ); bucket != NULL; bucket = bucket->next )
+  {
+    if ( bucket->category == category )
+    {
+      return bucket;
+    }
+  }
+
+  // first log of the category, looked up again in case another thread added it meanwhile
+  boost::mutex::scoped_lock lock( mutex_ );
+  Bucket* const head = slot.load( boost::memory_order_relaxed );
+  for ( Bucket* bucket = head; bucket != NULL; bucket = bucket->next )
+  {
+    if ( bucket->category == category )
+    {
+      return bucket;
+    }
+  }
+
+  // the globs are matched once per category
+  Bucket* bucket = new Bucket();
+  bucket->category = category;
+  bucket->limit = NULL;
+  for ( std::vector<LogRateLimit>::const_iterator limit = config_.rate_limits.begin();
+        limit != config_.rate_limits.end() && bucket->limit == NULL; ++limit )
+  {
+    if ( matches( limit->category, category ) )
+    {
+      bucket->limit = &*limit;
+    }
+  }
+  // without rate, the burst is never refilled
+  const double interval = ( bucket->limit && bucket->limit->rate > 0.f ) ? 1e6 / bucket->limit->rate : never;
+  const double tolerance = bucket->limit ? ( bucket->limit->burst - 1. ) * interval : 0.;
+  bucket->interval = static_cast<boost::int64_t>( std::max( 1., interval ) );
+  bucket->tolerance = static_cast<boost::int64_t>( std::max( -max_tolerance, std::min( max_tolerance, tolerance ) ) );
+  bucket->full.store( 0, boost::memory_order_relaxed );
+  bucket->suppressed.store( 0, boost::memory_order_relaxed );
+  bucket->next = head;
+  slot.store( bucket, boost::memory_order_release );
+  return bucket;
+}
+
+LogFilter::Decision LogFilter::process( const std::string& category, double now )
+{
+  if ( !allowed( category ) )
+  {
+    return FILTERED;
+  }
+  if ( config_.rate_limits.empty() )
+  {
+    return PASS;
+  }
+
+  Bucket* const b = bucket( category );
+  if ( b->limit == NULL )
+  {
+    return PASS;
+  }
+  const boost::int64_t time = static_cast<boost::int64_t>( now * 1e6 );
+  boost::int64_t full = b->full.load( boost::memory_order_relaxed );
+  for (;;)
+  {
+    // a bucket full in the past is full now
+    const boost::int64_t start = std::max( full, time );
+    if ( start - time > b->tolerance )
+    {
+      b->suppressed.fetch_add( 1, boost::memory_order_relaxed );
+      return SUPPRESSED;
+    }
+    if ( b->full.compare_exchange_weak( full, start + b->interval, boost::memory_order_relaxed ) )
+    {
+      return PASS;
+    }
+  }
+}
+
+void LogFilter::takeSuppressed( std::vector<std::pair<std::string, boost::uint64_t> >& suppressed )
+{
+  if ( config_.rate_limits.empty() )
+  {
+    return;
+  }
+  const size_t first = suppressed.size();
+  for ( size_t i=0; i<slot_count; ++i )
+  {
+    for ( Bucket* b = slots_[i].load( boost::memory_order_acquire ); b != NULL; b = b->next )
+    {
+      const boost::uint64_t count = b->suppressed.exchange( 0, boost::memory_order_relaxed );
+      if ( count > 0 )
+      {
+        suppressed.push_back( std::make_pair( b->category, count ) );
+      }
+    }
+  }
+  // reported by category, whatever the slots they are in
+  std::sort( suppressed.begin() + first, suppressed.end() );
+}
+
+} // tools
+} // naoqi
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef LOG_FILTER_HPP
+#define LOG_FILTER_HPP
+
+/*
+* STANDARD includes
+*/
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace naoqi
+{
+namespace tools
+{
+
+/**
+* @brief Token bucket applied to the log categories matching a glob
+*/
+struct LogRateLimit
+{
+  LogRateLimit():
+    rate( 0.f ),
+    burst( 1.f )
+  {}
+
+  /** glob on the category, e.g. ALMotion.* */
+  std::string category;
+  /** logs per second let through in the long run */
+  float rate;
+  /** logs let through at once after a quiet period */
+  float burst;
+};
+
+/**
+* @brief Settings of the LogFilter, e.g. from converters.logs in the boot config
+* @note an empty allow list lets every category through
+*/
+struct LogFilterConfig
+{
+  /** globs of the categories forwarded */
+  std::vector<std::string> allow;
+  /** globs of the categories never forwarded, even if they are allowed */
+  std::vector<std::string> deny;
+  /** the first limit matching a category applies, each category gets its own bucket */
+  std::vector<LogRateLimit> rate_limits;
+};
+
+/**
+* @brief Decide which NAOqi logs are forwarded, from their category only
+* @note the allow and deny lists are read only and checked without lock.
+* The buckets are created the first time a category is seen, under a lock, and never removed:
+* afterwards a log finds its bucket and takes its token with atomics only.
+* The suppressed logs are counted per category, to be reported by a summary.
+*/
+class LogFilter : private boost::noncopyable
+{
+public:
+  enum Decision
+  {
+    PASS,
+    /** denied, or not allowed */
+    FILTERED,
+    /** over the rate limit of its category */
+    SUPPRESSED
+  };
+
+  explicit LogFilter( const LogFilterConfig& config = LogFilterConfig() );
+
+  ~LogFilter();
+
+  /**
+  * @brief Decide on a log, thread safe
+  * @param now time in seconds, from any clock going forward
+  */
+  Decision process( const std::string& category, double now );
+
+  /** Append the categories that had logs suppressed since the last call, with how many, and reset their count */
+  void takeSuppressed( std::vector<std::pair<std::string, boost::uint64_t> >& suppressed );
+
+  inline const LogFilterConfig& config() const
+  {
+    return config_;
+  }
+
+private:
+  /**
+  * @brief Token bucket of a category, kept as the time at which it is full again
+  * @note a log passes if it comes at most tolerance before that time, which then moves interval later
+  */
+  struct Bucket : private boost::noncopyable
+  {
+    std::string category;
+    /** limit of the category, NULL if it has none */
+    const LogRateLimit* limit;
+    /** microseconds per token */
+    boost::int64_t interval;
+    /** microseconds of the burst beyond one token */
+    boost::int64_t tolerance;
+    /** microseconds at which the bucket is full */
+    boost::atomic<boost::int64_t> full;
+    boost::atomic<boost::uint64_t> suppressed;
+    /** next bucket of the same slot, set before the bucket is published */
+    Bucket* next;
+  };
+
+  /** number of slots of the table of buckets */
+  static const size_t slot_count = 256;
+
+  bool allowed( const std::string& category ) const;
+
+  /** Bucket of a category, created the first time */
+  Bucket* bucket( const std::string& category );
+
+  LogFilterConfig config_;
+  /** only taken to add a bucket */
+  boost::mutex mutex_;
+  boost::atomic<Bucket*> slots_[slot_count];
+};
+
+} // tools
+} // naoqi
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef MESSAGE_POOL_HPP
+#define MESSAGE_POOL_HPP
+
+/*
+* STANDARD includes
+*/
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/make_shared.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace naoqi
+{
+namespace tools
+{
+
+/**
+* @brief Messages built from a prototype and reused once nobody holds them anymore
+* @note a message given by acquire() is shared by reference between the publisher, the recorders and the buffers,
+* it goes back to the pool when the last of them drops it. A reused message keeps its content and the capacity
+* of its vectors, so that filling it again with data of the same size does not allocate.
+* The pool only grows when all its messages are held, e.g. by a slow subscriber in the same process.
+* Only one thread may call acquire(), the messages can be released from any thread.
+*/
+template <class T>
+class MessagePool : private boost::noncopyable
+{
+public:
+  MessagePool( const T& prototype, size_t size ):
+    prototype_( prototype ),
+    next_( 0 )
+  {
+    messages_.reserve( size );
+    for ( size_t i=0; i<size; ++i )
+    {
+      messages_.push_back( boost::make_shared<T>( prototype_ ) );
+    }
+  }
+
+  /** A message held by nobody else, a new one made from the prototype if there is none */
+  boost::shared_ptr<T> acquire()
+  {
+    for ( size_t i=0; i<messages_.size(); ++i )
+    {
+      const boost::shared_ptr<T>& message = messages_[(next_ + i) % messages_.size()];
+      if ( message.unique() )
+      {
+        next_ = (next_ + i + 1) % messages_.size();
+        return message;
+      }
+    }
+    messages_.push_back( boost::make_shared<T>( prototype_ ) );
+    return messages_.back();
+  }
+
+  /** Number of messages made so far */
+  inline size_t size() const
+  {
+    return messages_.size();
+  }
+
+private:
+  T prototype_;
+  std::vector< boost::shared_ptr<T> > messages_;
+  /** the search starts after the last message given, which is the most likely to be still held */
+  size_t next_;
+};
+
+} // tools
+} // naoqi
+
+#endif
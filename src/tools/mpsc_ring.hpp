@@ -0,0 +1,164 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef MPSC_RING_HPP
+#define MPSC_RING_HPP
+
+/*
+* STANDARD includes
+*/
+#include <cstddef>
+
+/*
+* BOOST includes
+*/
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+
+namespace naoqi
+{
+namespace tools
+{
+
+/**
+* @brief Fixed ring of slots handed from any number of producer threads to one consumer thread without any lock
+* @note each slot carries a sequence number telling whether it is free for the producer of a given turn
+* or filled for the consumer (the bounded queue of D. Vyukov). A producer claim()s a slot, fills it, then commit()s it;
+* the consumer reads the slot given by front() then pop()s it. The slots are reused and keep what they allocated.
+* A slot claimed and not committed yet holds the consumer back, the producers must fill it right away.
+* @note the capacity is rounded up to a power of two
+*/
+template <class T>
+class MpscRing : private boost::noncopyable
+{
+  struct Slot
+  {
+    boost::atomic<boost::uint64_t> sequence;
+    T value;
+  };
+
+public:
+  explicit MpscRing( size_t capacity ):
+    mask_( roundUp( capacity ) - 1 ),
+    slots_( new Slot[mask_ + 1] ),
+    tail_( 0 ),
+    head_( 0 )
+  {
+    for ( size_t i=0; i<=mask_; ++i )
+    {
+      slots_[i].sequence.store( i, boost::memory_order_relaxed );
+    }
+  }
+
+  /**
+  * @brief Slot to fill, NULL when the ring is full
+  * @param ticket to give back to commit
+  */
+  T* claim( boost::uint64_t& ticket )
+  {
+    boost::uint64_t tail = tail_.load( boost::memory_order_relaxed );
+    while ( true )
+    {
+      Slot& slot = slots_[tail & mask_];
+      const boost::int64_t diff = static_cast<boost::int64_t>( slot.sequence.load( boost::memory_order_acquire ) - tail );
+      if ( diff == 0 )
+      {
+        // the slot is free for this turn, take it unless another producer was faster
+        if ( tail_.compare_exchange_weak( tail, tail + 1, boost::memory_order_relaxed ) )
+        {
+          ticket = tail;
+          return &slot.value;
+        }
+      }
+      else if ( diff < 0 )
+      {
+        // the consumer did not free the slot of the previous turn yet
+        return NULL;
+      }
+      else
+      {
+        tail = tail_.load( boost::memory_order_relaxed );
+      }
+    }
+  }
+
+  /** Hand the slot given by claim() to the consumer */
+  void commit( boost::uint64_t ticket )
+  {
+    slots_[ticket & mask_].sequence.store( ticket + 1, boost::memory_order_release );
+  }
+
+  /** Oldest slot committed, NULL when the ring is empty */
+  T* front()
+  {
+    const boost::uint64_t head = head_.load( boost::memory_order_relaxed );
+    Slot& slot = slots_[head & mask_];
+    if ( slot.sequence.load( boost::memory_order_acquire ) != head + 1 )
+    {
+      return NULL;
+    }
+    return &slot.value;
+  }
+
+  /** Give the slot given by front() back to the producers */
+  void pop()
+  {
+    const boost::uint64_t head = head_.load( boost::memory_order_relaxed );
+    slots_[head & mask_].sequence.store( head + mask_ + 1, boost::memory_order_release );
+    head_.store( head + 1, boost::memory_order_relaxed );
+  }
+
+  /** Number of slots claimed and not popped yet, approximate when the producers are busy */
+  size_t size() const
+  {
+    return static_cast<size_t>( tail_.load( boost::memory_order_relaxed ) - head_.load( boost::memory_order_relaxed ) );
+  }
+
+  size_t capacity() const
+  {
+    return mask_ + 1;
+  }
+
+private:
+  static size_t roundUp( size_t capacity )
+  {
+    size_t size = 1;
+    while ( size < capacity )
+    {
+      size <<= 1;
+    }
+    return size;
+  }
+
+  const boost::uint64_t mask_;
+  /** the atomics cannot be copied, so the slots are not in a vector */
+  boost::scoped_array<Slot> slots_;
+  /** turns claimed by the producers */
+  boost::atomic<boost::uint64_t> tail_;
+  /** keep the consumer counter away from the one the producers share */
+  char padding_[64];
+  /** turns popped, only written by the consumer, read by size() from any thread */
+  boost::atomic<boost::uint64_t> head_;
+};
+
+} // tools
+} // naoqi
+
+#endif
@@ -27,7 +27,9 @@ namespace tools{
 
 std::string getRobotDescription( const robot::Robot& robot){
     std::string urdf_path;
-    static std::string robot_desc;
+    // one description per robot, a process may deal with several of them
+    static std::map<robot::Robot, std::string> robot_descs;
+    std::string& robot_desc = robot_descs[robot];
     if(!robot_desc.empty())
       return robot_desc;
 
@@ -28,6 +28,7 @@
 */
 #include <string>
 #include <fstream>
+#include <map>
 
 
 namespace naoqi {
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+/*
+* LOCAL includes
+*/
+#include "rpc_statistics.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace naoqi
+{
+namespace tools
+{
+
+namespace
+{
+
+template <typename Ref>
+size_t anyPayloadSize( const Ref& value )
+{
+  switch ( value.kind() )
+  {
+  case qi::TypeKind_Raw:
+    return value.asRaw().second;
+  case qi::TypeKind_String:
+    return value.asString().size();
+  case qi::TypeKind_Int:
+  case qi::TypeKind_Float:
+    return 8;
+  case qi::TypeKind_Dynamic:
+    return payloadSize( value.content() );
+  case qi::TypeKind_List:
+  case qi::TypeKind_Tuple:
+    {
+      size_t size = 0;
+      for ( size_t i=0; i<value.size(); ++i )
+      {
+        size += payloadSize( value[static_cast<int>(i)] );
+      }
+      return size;
+    }
+  default:
+    return 0;
+  }
+}
+
+size_t bucketOf( boost::uint64_t latency_us )
+{
+  size_t bucket = 0;
+  while ( latency_us > 1 && bucket < RpcMethodStatistics::histogram_size-1 )
+  {
+    latency_us >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+} // anonymous
+
+size_t payloadSize( const qi::AnyReference& value )
+{
+  return anyPayloadSize( value );
+}
+
+size_t payloadSize( const qi::AnyValue& value )
+{
+  return anyPayloadSize( value );
+}
+
+RpcMethodStatistics::RpcMethodStatistics():
+  calls(0),
+  errors(0),
+  payload_bytes(0),
+  total_us(0),
+  max_us(0)
+{
+  std::fill( histogram, histogram+histogram_size, 0 );
+}
+
+void RpcMethodStatistics::add( boost::uint64_t latency_us, size_t bytes, bool error )
+{
+  ++calls;
+  if ( error )
+  {
+    ++errors;
+  }
+  payload_bytes += bytes;
+  total_us += latency_us;
+  max_us = std::max( max_us, latency_us );
+  ++histogram[ bucketOf(latency_us) ];
+}
+
+double RpcMethodStatistics::percentile( double p ) const
+{
+  if ( calls == 0 )
+  {
+    return 0.0;
+  }
+  const boost::uint64_t rank = static_cast<boost::uint64_t>( p * calls );
+  boost::uint64_t seen = 0;
+  for ( size_t i=0; i<histogram_size; ++i )
+  {
+    seen += histogram[i];
+    if ( seen > rank )
+    {
+      // upper bound of the bucket, clamped to what was really observed
+      return std::min( static_cast<double>( boost::uint64_t(1) << (i+1) ), static_cast<double>(max_us) );
+    }
+  }
+  return static_cast<double>(max_us);
+}
+
+double RpcMethodStatistics::mean() const
+{
+  return calls == 0 ? 0.0 : static_cast<double>(total_us) / calls;
+}
+
+RpcStatistics& RpcStatistics::instance()
+{
+  static RpcStatistics stats;
+  return stats;
+}
+
+void RpcStatistics::record( const std::string& service, const std::string& method,
+                            boost::uint64_t latency_us, size_t payload_bytes, bool error )
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  stats_[service + "." + method].add( latency_us, payload_bytes, error );
+}
+
+RpcStatistics::Map RpcStatistics::snapshot() const
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  return stats_;
+}
+
+std::vector<std::string> RpcStatistics::summary() const
+{
+  const Map stats = snapshot();
+  std::vector<std::string> lines;
+  for ( Map::const_iterator it = stats.begin(); it != stats.end(); ++it )
+  {
+    const RpcMethodStatistics& s = it->second;
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(2)
+         << it->first
+         << " calls=" << s.calls
+         << " errors=" << s.errors
+         << " mean=" << s.mean() / 1000. << "ms"
+         << " p50=" << s.percentile(0.5) / 1000. << "ms"
+         << " p90=" << s.percentile(0.9) / 1000. << "ms"
+         << " p99=" << s.percentile(0.99) / 1000. << "ms"
+         << " max=" << s.max_us / 1000. << "ms"
+         << " bytes=" << s.payload_bytes;
+    lines.push_back( line.str() );
+  }
+  return lines;
+}
+
+void RpcStatistics::reset()
+{
+  boost::mutex::scoped_lock lock( mutex_ );
+  stats_.clear();
+}
+
+} // tools
+} // naoqi
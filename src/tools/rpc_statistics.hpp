@@ -0,0 +1,132 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RPC_STATISTICS_HPP
+#define RPC_STATISTICS_HPP
+
+/*
+* STANDARD includes
+*/
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+
+/*
+* ALDEBARAN includes
+*/
+#include <qi/anyvalue.hpp>
+
+namespace naoqi
+{
+namespace tools
+{
+
+/**
+* @brief Counters gathered for one remote method (e.g. "ALMemory.getListData")
+* @note the latency histogram is logarithmic: bucket i holds the calls
+* which took between 2^i and 2^(i+1) microseconds
+*/
+struct RpcMethodStatistics
+{
+  static const size_t histogram_size = 32;
+
+  RpcMethodStatistics();
+
+  /** Account for one call */
+  void add( boost::uint64_t latency_us, size_t payload_bytes, bool error );
+
+  /** Approximate latency percentile in microseconds, p in [0,1] */
+  double percentile( double p ) const;
+
+  /** Mean latency in microseconds */
+  double mean() const;
+
+  boost::uint64_t calls;
+  boost::uint64_t errors;
+  boost::uint64_t payload_bytes;
+  boost::uint64_t total_us;
+  boost::uint64_t max_us;
+  boost::uint64_t histogram[histogram_size];
+};
+
+/**
+* @brief Process wide registry of the libqi calls made by the converters
+* @note only fed when the driver is built with NAOQI_DRIVER_RPC_STATS
+*/
+class RpcStatistics
+{
+public:
+  typedef std::map<std::string, RpcMethodStatistics> Map;
+
+  static RpcStatistics& instance();
+
+  void record( const std::string& service, const std::string& method,
+               boost::uint64_t latency_us, size_t payload_bytes, bool error );
+
+  /** Copy of all the counters, to be read without holding the lock */
+  Map snapshot() const;
+
+  /** One human readable line per method */
+  std::vector<std::string> summary() const;
+
+  void reset();
+
+private:
+  RpcStatistics() {}
+
+  mutable boost::mutex mutex_;
+  Map stats_;
+};
+
+/** Size of the data carried by a call result, used for the payload counters */
+template <typename T>
+inline size_t payloadSize( const T& )
+{
+  return sizeof(T);
+}
+
+template <typename T>
+inline size_t payloadSize( const std::vector<T>& value )
+{
+  return value.size() * sizeof(T);
+}
+
+inline size_t payloadSize( const std::string& value )
+{
+  return value.size();
+}
+
+/** Future<void> carries no data */
+inline size_t payloadSize( void* const& )
+{
+  return 0;
+}
+
+size_t payloadSize( const qi::AnyReference& value );
+
+size_t payloadSize( const qi::AnyValue& value );
+
+} // tools
+} // naoqi
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SERIALIZED_MESSAGE_HPP
+#define SERIALIZED_MESSAGE_HPP
+
+/*
+* STANDARD includes
+*/
+#include <cstring>
+#include <string>
+
+/*
+* BOOST includes
+*/
+#include <boost/make_shared.hpp>
+#include <boost/shared_array.hpp>
+#include <boost/shared_ptr.hpp>
+
+/*
+* ROS includes
+*/
+#include <ros/message_traits.h>
+#include <ros/serialization.h>
+
+namespace naoqi
+{
+namespace tools
+{
+
+/**
+* @brief Description of a ROS message type known only at runtime
+*/
+struct MessageType
+{
+  std::string datatype;
+  std::string md5sum;
+  std::string definition;
+};
+
+template <class T>
+boost::shared_ptr<const MessageType> messageTypeOf()
+{
+  boost::shared_ptr<MessageType> type = boost::make_shared<MessageType>();
+  type->datatype = ros::message_traits::datatype<T>();
+  type->md5sum = ros::message_traits::md5sum<T>();
+  type->definition = ros::message_traits::definition<T>();
+  return type;
+}
+
+/**
+* @brief A ROS message already serialized, which can be written in a ROSbag as is
+* @note the bytes and the type description are shared between the copies,
+* data may alias a bigger block (boost::shared_array aliasing constructor), which then lives as long as the message
+*/
+struct SerializedMessage
+{
+  SerializedMessage():
+    size(0)
+  {}
+
+  SerializedMessage( const boost::shared_ptr<const MessageType>& type, const uint8_t* bytes, uint32_t bytes_size ):
+    type( type ),
+    data( new uint8_t[bytes_size] ),
+    size( bytes_size )
+  {
+    std::memcpy( data.get(), bytes, bytes_size );
+  }
+
+  /** Share bytes owned by somebody else, e.g. a slice of a minidump snapshot: they are kept alive, not copied */
+  SerializedMessage( const boost::shared_ptr<const MessageType>& type, const boost::shared_array<uint8_t>& bytes, uint32_t bytes_size ):
+    type( type ),
+    data( bytes ),
+    size( bytes_size )
+  {}
+
+  boost::shared_ptr<const MessageType> type;
+  boost::shared_array<uint8_t> data;
+  uint32_t size;
+};
+
+/**
+* @brief Serialize a message once, its bytes can then be published, written in a ROSbag and buffered without serializing it again
+*/
+template <class T>
+SerializedMessage serializeMessage( const T& msg, const boost::shared_ptr<const MessageType>& type )
+{
+  SerializedMessage serialized;
+  serialized.type = type;
+  serialized.size = ros::serialization::serializationLength( msg );
+  serialized.data.reset( new uint8_t[serialized.size] );
+  ros::serialization::OStream stream( serialized.data.get(), serialized.size );
+  ros::serialization::serialize( stream, msg );
+  return serialized;
+}
+
+} // tools
+} // naoqi
+
+namespace ros
+{
+namespace message_traits
+{
+
+template <> struct IsMessage<naoqi::tools::SerializedMessage> : TrueType {};
+template <> struct IsMessage<const naoqi::tools::SerializedMessage> : TrueType {};
+
+template <>
+struct MD5Sum<naoqi::tools::SerializedMessage>
+{
+  static const char* value( const naoqi::tools::SerializedMessage& m ) { return m.type->md5sum.c_str(); }
+  static const char* value() { return "*"; }
+};
+
+template <>
+struct DataType<naoqi::tools::SerializedMessage>
+{
+  static const char* value( const naoqi::tools::SerializedMessage& m ) { return m.type->datatype.c_str(); }
+  static const char* value() { return "*"; }
+};
+
+template <>
+struct Definition<naoqi::tools::SerializedMessage>
+{
+  static const char* value( const naoqi::tools::SerializedMessage& m ) { return m.type->definition.c_str(); }
+};
+
+} // message_traits
+
+namespace serialization
+{
+
+template <>
+struct Serializer<naoqi::tools::SerializedMessage>
+{
+  template <typename Stream>
+  inline static void write( Stream& stream, const naoqi::tools::SerializedMessage& m )
+  {
+    std::memcpy( stream.advance(m.size), m.data.get(), m.size );
+  }
+
+  inline static uint32_t serializedLength( const naoqi::tools::SerializedMessage& m )
+  {
+    return m.size;
+  }
+};
+
+} // serialization
+} // ros
+
+#endif
@@ -0,0 +1,301 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+/*
+* LOCAL includes
+*/
+#include "trace.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+/*
+* SYSTEM includes
+*/
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+* BOOST includes
+*/
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+namespace naoqi
+{
+namespace tools
+{
+
+namespace
+{
+
+struct Ring
+{
+  Ring():
+    head(0),
+    tid(0),
+    in_use(false)
+  {}
+
+  TraceEvent events[Trace::ring_size];
+  /** number of events written so far, the newest one is at (head-1) % ring_size */
+  boost::atomic<boost::uint64_t> head;
+  int tid;
+  /** owned by a living thread, guarded by the registry mutex */
+  bool in_use;
+};
+
+/** Rings of all the threads, never freed: a dump may read a ring whose thread is gone */
+struct Registry
+{
+  boost::mutex mutex;
+  std::vector<Ring*> rings;
+  std::map<int, std::string> thread_names;
+};
+
+Registry& registry()
+{
+  // leaked on purpose, threads may still give their ring back after the static destructors ran
+  static Registry* registry = new Registry();
+  return *registry;
+}
+
+void releaseRing( Ring* ring )
+{
+  boost::mutex::scoped_lock lock( registry().mutex );
+  ring->in_use = false;
+}
+
+boost::thread_specific_ptr<Ring>& currentRing()
+{
+  static boost::thread_specific_ptr<Ring> ring( &releaseRing );
+  return ring;
+}
+
+Ring& acquireRing()
+{
+  Ring* ring = currentRing().get();
+  if ( ring != NULL )
+  {
+    return *ring;
+  }
+
+  Registry& r = registry();
+  boost::mutex::scoped_lock lock( r.mutex );
+  for ( std::vector<Ring*>::iterator it = r.rings.begin(); it != r.rings.end() && ring == NULL; ++it )
+  {
+    if ( !(*it)->in_use )
+    {
+      ring = *it;
+    }
+  }
+  if ( ring == NULL )
+  {
+    ring = new Ring();
+    r.rings.push_back( ring );
+  }
+  ring->in_use = true;
+  ring->tid = static_cast<int>( ::syscall( SYS_gettid ) );
+  currentRing().reset( ring );
+  return *ring;
+}
+
+void copyName( TraceEvent& event, const std::string& name )
+{
+  const size_t size = std::min( name.size(), TraceEvent::name_size - 1 );
+  std::memcpy( event.name, name.data(), size );
+  event.name[size] = '\0';
+}
+
+void writeString( std::ostream& out, const char* s )
+{
+  out << '"';
+  for ( ; *s != '\0'; ++s )
+  {
+    if ( *s == '"' || *s == '\\' )
+    {
+      out << '\\' << *s;
+    }
+    else if ( static_cast<unsigned char>(*s) < 0x20 )
+    {
+      out << ' ';
+    }
+    else
+    {
+      out << *s;
+    }
+  }
+  out << '"';
+}
+
+} // anonymous
+
+boost::uint64_t Trace::now()
+{
+  struct timespec ts;
+  ::clock_gettime( CLOCK_MONOTONIC, &ts );
+  return static_cast<boost::uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+void Trace::push( const TraceEvent& event )
+{
+  Ring& ring = acquireRing();
+  const boost::uint64_t head = ring.head.load( boost::memory_order_relaxed );
+  TraceEvent& slot = ring.events[head % ring_size];
+  slot = event;
+  slot.tid = ring.tid;
+  ring.head.store( head + 1, boost::memory_order_release );
+}
+
+void Trace::instant( const char* category, const std::string& name )
+{
+  TraceEvent event;
+  event.category = category;
+  copyName( event, name );
+  event.begin_us = now();
+  event.duration_us = 0;
+  event.arg = NULL;
+  event.value = 0;
+  event.phase = 'i';
+  push( event );
+}
+
+void Trace::setThreadName( const std::string& name )
+{
+  const int tid = acquireRing().tid;
+  boost::mutex::scoped_lock lock( registry().mutex );
+  registry().thread_names[tid] = name;
+}
+
+size_t Trace::dump( const std::string& path )
+{
+  // copy the rings first, the writers go on meanwhile
+  std::vector<TraceEvent> events;
+  std::map<int, std::string> thread_names;
+  {
+    Registry& r = registry();
+    boost::mutex::scoped_lock lock( r.mutex );
+    thread_names = r.thread_names;
+    for ( std::vector<Ring*>::const_iterator it = r.rings.begin(); it != r.rings.end(); ++it )
+    {
+      const Ring& ring = **it;
+      const boost::uint64_t end = ring.head.load( boost::memory_order_acquire );
+      const boost::uint64_t begin = end > ring_size ? end - ring_size : 0;
+      const size_t first = events.size();
+      for ( boost::uint64_t i = begin; i < end; ++i )
+      {
+        events.push_back( ring.events[i % ring_size] );
+      }
+      // the slots reused since the copy started are torn, and so is the one being written now
+      boost::atomic_thread_fence( boost::memory_order_acquire );
+      const boost::uint64_t after = ring.head.load( boost::memory_order_relaxed );
+      const boost::uint64_t valid = after + 1 > ring_size ? after + 1 - ring_size : 0;
+      if ( valid > begin )
+      {
+        const size_t torn = static_cast<size_t>( std::min( valid, end ) - begin );
+        events.erase( events.begin() + first, events.begin() + first + torn );
+      }
+    }
+  }
+
+  std::ofstream out( path.c_str() );
+  if ( !out )
+  {
+    throw std::runtime_error( "Cannot write the trace " + path );
+  }
+  const int pid = static_cast<int>( ::getpid() );
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  for ( std::map<int, std::string>::const_iterator it = thread_names.begin(); it != thread_names.end(); ++it )
+  {
+    out << ( first ? "" : "," ) << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << it->first
+        << ",\"args\":{\"name\":";
+    writeString( out, it->second.c_str() );
+    out << "}}";
+    first = false;
+  }
+  for ( std::vector<TraceEvent>::const_iterator it = events.begin(); it != events.end(); ++it )
+  {
+    out << ( first ? "" : "," ) << "\n{\"name\":";
+    writeString( out, it->name );
+    out << ",\"cat\":";
+    writeString( out, it->category );
+    out << ",\"ph\":\"" << it->phase << "\",\"ts\":" << it->begin_us;
+    if ( it->phase == 'X' )
+    {
+      out << ",\"dur\":" << it->duration_us;
+    }
+    else
+    {
+      out << ",\"s\":\"t\"";
+    }
+    out << ",\"pid\":" << pid << ",\"tid\":" << it->tid;
+    if ( it->arg != NULL )
+    {
+      out << ",\"args\":{";
+      writeString( out, it->arg );
+      out << ":" << it->value << "}";
+    }
+    out << "}";
+    first = false;
+  }
+  out << "\n]}\n";
+  if ( !out )
+  {
+    throw std::runtime_error( "Cannot write the trace " + path );
+  }
+  return events.size();
+}
+
+TraceScope::TraceScope( const char* category, const std::string& name )
+{
+  event_.category = category;
+  copyName( event_, name );
+  event_.arg = NULL;
+  event_.value = 0;
+  event_.phase = 'X';
+  event_.begin_us = Trace::now();
+}
+
+TraceScope::TraceScope( const char* category, const std::string& name, const char* arg, boost::int64_t value )
+{
+  event_.category = category;
+  copyName( event_, name );
+  event_.arg = arg;
+  event_.value = value;
+  event_.phase = 'X';
+  event_.begin_us = Trace::now();
+}
+
+TraceScope::~TraceScope()
+{
+  event_.duration_us = Trace::now() - event_.begin_us;
+  Trace::push( event_ );
+}
+
+} // tools
+} // naoqi
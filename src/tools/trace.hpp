@@ -0,0 +1,146 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+/*
+* LOCAL includes
+*/
+#include <naoqi_driver/message_actions.h>
+
+/*
+* STANDARD includes
+*/
+#include <string>
+
+/*
+* BOOST includes
+*/
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace naoqi
+{
+namespace tools
+{
+
+/**
+* @brief One span (or instant) of the timeline, as found in a Chrome trace-event
+*/
+struct TraceEvent
+{
+  static const size_t name_size = 48;
+
+  /** static string, the phase of the work (fetch, convert, publish, ...) */
+  const char* category;
+  /** truncated copy, usually the converter or the topic */
+  char name[name_size];
+  /** monotonic clock */
+  boost::uint64_t begin_us;
+  boost::uint64_t duration_us;
+  /** static string naming value, NULL if the event has no argument */
+  const char* arg;
+  boost::int64_t value;
+  int tid;
+  /** 'X' for a span, 'i' for an instant */
+  char phase;
+};
+
+/**
+* @brief Process wide timeline of the driver, to be viewed in Perfetto or chrome://tracing
+* @note each thread writes in a ring of its own, without any lock: only the thread owning a ring writes it
+* and publishes its events by bumping the head of the ring. dump() copies the rings and drops the events
+* overwritten meanwhile. The rings keep the last events of each thread, the oldest ones are overwritten.
+* A ring is given back when its thread exits, and reused by the next thread.
+* @note only fed when the driver is built with NAOQI_DRIVER_TRACE, see the NAOQI_TRACE_* macros
+*/
+class Trace
+{
+public:
+  /** Events kept per thread */
+  static const size_t ring_size = 8192;
+
+  /** Monotonic clock, in microseconds */
+  static boost::uint64_t now();
+
+  /** Append an event to the ring of the calling thread */
+  static void push( const TraceEvent& event );
+
+  static void instant( const char* category, const std::string& name );
+
+  /** Name shown for the calling thread */
+  static void setThreadName( const std::string& name );
+
+  /**
+  * @brief Write all the rings as Chrome trace-event JSON
+  * @return the number of events written
+  * @throw std::runtime_error if the file cannot be written
+  */
+  static size_t dump( const std::string& path );
+};
+
+/**
+* @brief Span covering the lifetime of the object
+*/
+class TraceScope : private boost::noncopyable
+{
+public:
+  TraceScope( const char* category, const std::string& name );
+
+  TraceScope( const char* category, const std::string& name, const char* arg, boost::int64_t value );
+
+  ~TraceScope();
+
+private:
+  TraceEvent event_;
+};
+
+inline const char* actionName( message_actions::MessageAction action )
+{
+  switch ( action )
+  {
+  case message_actions::PUBLISH: return "publish";
+  case message_actions::RECORD: return "record";
+  case message_actions::LOG: return "log";
+  }
+  return "action";
+}
+
+} // tools
+} // naoqi
+
+#define NAOQI_TRACE_CONCAT_(a, b) a##b
+#define NAOQI_TRACE_CONCAT(a, b) NAOQI_TRACE_CONCAT_(a, b)
+
+#ifdef NAOQI_DRIVER_TRACE
+/** Trace the rest of the enclosing scope, the arguments are not evaluated when tracing is compiled out */
+# define NAOQI_TRACE_SCOPE(category, name) \
+  ::naoqi::tools::TraceScope NAOQI_TRACE_CONCAT(naoqi_trace_scope_, __LINE__)( category, name )
+# define NAOQI_TRACE_SCOPE_VALUE(category, name, arg, value) \
+  ::naoqi::tools::TraceScope NAOQI_TRACE_CONCAT(naoqi_trace_scope_, __LINE__)( category, name, arg, value )
+# define NAOQI_TRACE_INSTANT(category, name) ::naoqi::tools::Trace::instant( category, name )
+# define NAOQI_TRACE_THREAD_NAME(name) ::naoqi::tools::Trace::setThreadName( name )
+#else
+# define NAOQI_TRACE_SCOPE(category, name)
+# define NAOQI_TRACE_SCOPE_VALUE(category, name, arg, value)
+# define NAOQI_TRACE_INSTANT(category, name)
+# define NAOQI_TRACE_THREAD_NAME(name)
+#endif
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+/*
+* LOCAL includes
+*/
+#include "voice_activity.hpp"
+
+/*
+* STANDARD includes
+*/
+#include <algorithm>
+#include <cmath>
+
+namespace naoqi
+{
+namespace tools
+{
+
+namespace
+{
+
+/** windows per second */
+const int windows_rate = 100;
+
+/** weight of a new window in the smoothed energy, about 100 ms of memory */
+const double smoothing = 0.1;
+
+/** windows before the smoothed energy is settled and taken into the minima */
+const size_t settling_windows = 10;
+
+/** windows per block, half a second */
+const size_t block_windows = 50;
+
+/** blocks the noise floor is the minimum of, five seconds: the floor follows a louder noise within that time */
+const size_t floor_blocks = 10;
+
+/** the floor never goes below the quantization noise */
+const double min_floor = 1. / ( 32768. * 32768. );
+
+inline double fromDecibels( double db )
+{
+  return std::pow( 10., db / 10. );
+}
+
+} // anonymous
+
+VoiceActivityDetector::VoiceActivityDetector( const VoiceActivityConfig& config ):
+  config_( config ),
+  smoothed_energy_( 0. ),
+  windows_( 0 ),
+  block_min_( -1. ),
+  block_windows_( 0 ),
+  block_minima_( floor_blocks, -1. ),
+  block_index_( 0 ),
+  hangover_left_( 0 ),
+  active_( false )
+{
+}
+
+double VoiceActivityDetector::noiseFloor() const
+{
+  return 10. * std::log10( std::max( floor(), min_floor ) );
+}
+
+double VoiceActivityDetector::floor() const
+{
+  double minimum = -1.;
+  for ( size_t i=0; i<block_minima_.size(); ++i )
+  {
+    if ( block_minima_[i] >= 0. && ( minimum < 0. || block_minima_[i] < minimum ) )
+    {
+      minimum = block_minima_[i];
+    }
+  }
+  return minimum;
+}
+
+bool VoiceActivityDetector::process( const int16_t* samples, size_t samples_per_channel, size_t channels, int frequency )
+{
+  const size_t window = std::max( 1, frequency / windows_rate );
+  const double threshold = fromDecibels( config_.threshold );
+  const double min_level = fromDecibels( config_.min_level );
+  const size_t hangover = static_cast<size_t>( config_.hangover * frequency );
+  bool voice = false;
+
+  for ( size_t begin=0; begin<samples_per_channel; begin+=window )
+  {
+    const size_t end = std::min( samples_per_channel, begin + window );
+    double energy = 0.;
+    size_t crossings = 0;
+    int previous = 0;
+    for ( size_t i=begin; i<end; ++i )
+    {
+      int mixed = 0;
+      for ( size_t c=0; c<channels; ++c )
+      {
+        mixed += samples[i*channels + c];
+      }
+      mixed /= static_cast<int>( channels );
+      energy += static_cast<double>( mixed ) * mixed;
+      if ( i > begin && ( ( mixed < 0 ) != ( previous < 0 ) ) )
+      {
+        ++crossings;
+      }
+      previous = mixed;
+    }
+    const size_t size = end - begin;
+    energy /= size * 32768. * 32768.;
+    const double zero_crossing = static_cast<double>( crossings ) / size;
+
+    // every window feeds the floor, a plain mean until the smoothing is settled
+    if ( windows_ < settling_windows )
+    {
+      ++windows_;
+      smoothed_energy_ += ( energy - smoothed_energy_ ) / windows_;
+    }
+    else
+    {
+      smoothed_energy_ += smoothing * ( energy - smoothed_energy_ );
+      if ( block_min_ < 0. || smoothed_energy_ < block_min_ )
+      {
+        block_min_ = smoothed_energy_;
+      }
+      if ( ++block_windows_ == block_windows )
+      {
+        // the oldest block leaves the floor
+        block_minima_[block_index_] = std::max( block_min_, min_floor );
+        block_index_ = ( block_index_ + 1 ) % block_minima_.size();
+        block_min_ = -1.;
+        block_windows_ = 0;
+      }
+    }
+
+    const double noise_floor = floor();
+    const bool window_active = noise_floor >= 0. && energy > noise_floor * threshold && energy > min_level
+                            && zero_crossing < config_.max_zero_crossing;
+    if ( window_active )
+    {
+      voice = true;
+      hangover_left_ = hangover;
+    }
+    else
+    {
+      hangover_left_ -= std::min( hangover_left_, size );
+    }
+  }
+
+  active_ = voice || hangover_left_ > 0;
+  return active_;
+}
+
+} // tools
+} // naoqi
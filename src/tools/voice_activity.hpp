@@ -0,0 +1,122 @@
+/*
+ * Copyright 2015 Aldebaran
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+
+#ifndef VOICE_ACTIVITY_HPP
+#define VOICE_ACTIVITY_HPP
+
+/*
+* STANDARD includes
+*/
+#include <cstddef>
+#include <vector>
+
+/*
+* BOOST includes
+*/
+#include <boost/cstdint.hpp>
+
+namespace naoqi
+{
+namespace tools
+{
+
+/**
+* @brief Settings of the VoiceActivityDetector, e.g. from converters.audio.vad in the boot config
+*/
+struct VoiceActivityConfig
+{
+  VoiceActivityConfig():
+    enabled( false ),
+    threshold( 9.f ),
+    min_level( -55.f ),
+    max_zero_crossing( 0.3f ),
+    pre_roll( 0.3f ),
+    hangover( 0.5f )
+  {}
+
+  bool enabled;
+  /** dB above the noise floor for a window to be active */
+  float threshold;
+  /** dB below full scale under which a window is never active */
+  float min_level;
+  /** zero crossings per sample above which a window is taken for broadband noise rather than voice */
+  float max_zero_crossing;
+  /** seconds of audio kept before the voice starts, sent when it does */
+  float pre_roll;
+  /** seconds the voice is still considered active after the last active window */
+  float hangover;
+};
+
+/**
+* @brief Voice activity detection by energy and zero-crossing rate
+* @note the channels are mixed down and cut in windows of 10 ms. A window is active when its energy is
+* threshold dB above the noise floor and above min_level, with a zero-crossing rate low enough for voice.
+* The noise floor is the minimum of the smoothed window energy over the last seconds (minimum statistics):
+* a single quiet window cannot pull it down, and it rises again when the noise does, like a fan turning on.
+* Until a first block of windows is measured, nothing is active.
+* The voice stays active hangover seconds after the last active window.
+*/
+class VoiceActivityDetector
+{
+public:
+  explicit VoiceActivityDetector( const VoiceActivityConfig& config = VoiceActivityConfig() );
+
+  /**
+  * @brief Analyse a block of interleaved samples
+  * @return whether the voice was active in the block
+  */
+  bool process( const int16_t* samples, size_t samples_per_channel, size_t channels, int frequency );
+
+  inline bool isActive() const
+  {
+    return active_;
+  }
+
+  /** Noise floor, in dB below full scale */
+  double noiseFloor() const;
+
+  inline const VoiceActivityConfig& config() const
+  {
+    return config_;
+  }
+
+private:
+  /** Minimum of the smoothed energy over the measured blocks, negative while none is */
+  double floor() const;
+
+  VoiceActivityConfig config_;
+  /** mean square of the last windows, in full scale units */
+  double smoothed_energy_;
+  /** windows analysed since the start, saturated once the smoothing is settled */
+  size_t windows_;
+  /** minimum of the smoothed energy in the block being measured */
+  double block_min_;
+  /** windows in the block being measured */
+  size_t block_windows_;
+  /** minima of the last blocks, negative for the ones not measured yet */
+  std::vector<double> block_minima_;
+  size_t block_index_;
+  /** samples left before the hangover ends */
+  size_t hangover_left_;
+  bool active_;
+};
+
+} // tools
+} // naoqi
+
+#endif